@@ -0,0 +1,22 @@
+#version 460 core
+
+in vec2 texCoord;
+
+uniform sampler2D source;
+// one texel along the blur axis, in uv
+uniform vec2 direction;
+
+out vec4 fragColor;
+
+// 9 tap gaussian in 5 fetches, pairs of taps are merged into one bilinear fetch between them
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main() {
+   vec3 color = texture(source, texCoord).rgb * weights[0];
+   for (int i = 1; i < 3; i++) {
+      color += texture(source, texCoord + direction * offsets[i]).rgb * weights[i];
+      color += texture(source, texCoord - direction * offsets[i]).rgb * weights[i];
+   }
+   fragColor = vec4(color, 1.0);
+}
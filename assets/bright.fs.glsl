@@ -0,0 +1,39 @@
+#version 460 core
+
+in vec2 texCoord;
+
+uniform sampler2D source;
+// text and HUD, premultiplied, counted so they still glow
+uniform sampler2D overlay;
+uniform float overlayAmount;
+// screen uv to the part of the scene that's used, and where to stop filtering
+uniform vec2 uvScale;
+uniform vec2 uvMax;
+// four bilinear taps this far from the centre average the whole block a low res texel covers
+uniform vec2 tapOffset;
+uniform float threshold;
+uniform float knee;
+
+out vec4 fragColor;
+
+vec3 tap(vec2 uv) {
+   vec3 color = texture(source, min(uv * uvScale, uvMax)).rgb;
+   vec4 over = texture(overlay, uv) * overlayAmount;
+   return color * (1.0 - over.a) + over.rgb;
+}
+
+void main() {
+   vec3 color = tap(texCoord + vec2(-tapOffset.x, -tapOffset.y));
+   color += tap(texCoord + vec2(tapOffset.x, -tapOffset.y));
+   color += tap(texCoord + vec2(-tapOffset.x, tapOffset.y));
+   color += tap(texCoord + vec2(tapOffset.x, tapOffset.y));
+   color *= 0.25;
+
+   // soft knee, so things don't pop in and out right at the threshold
+   float brightness = max(color.r, max(color.g, color.b));
+   float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+   soft = soft * soft / (4.0 * knee + 0.0001);
+   float contribution = max(soft, brightness - threshold) / max(brightness, 0.0001);
+
+   fragColor = vec4(color * contribution, 1.0);
+}
@@ -0,0 +1,78 @@
+#version 460 core
+
+in vec2 texCoord;
+
+uniform sampler2D scene;
+uniform sampler2D bloom;
+// text and HUD at native resolution, premultiplied
+uniform sampler2D overlay;
+uniform float overlayAmount;
+
+// screen uv to the part of the scene that's used, and where to stop filtering
+uniform vec2 uvScale;
+uniform vec2 uvMax;
+// one scene pixel in screen uv, and how hard the upscale sharpens
+uniform vec2 sceneTexel;
+uniform float sharpen;
+
+uniform float bloomStrength;
+// 0 is a flat screen
+uniform float curvature;
+// how much darker the gaps between scanlines are, and how many lines there are top to bottom
+uniform float scanlineStrength;
+uniform float scanlineCount;
+// colour fringing at the edges, in uv
+uniform float chromatic;
+uniform float vignette;
+
+out vec4 fragColor;
+
+// bulges the picture out like the glass on a tube
+vec2 warp(vec2 uv) {
+   vec2 centered = uv * 2.0 - 1.0;
+   centered += centered * (centered.yx * centered.yx) * curvature;
+   return centered * 0.5 + 0.5;
+}
+
+vec3 sampleScene(vec2 uv) {
+   return texture(scene, min(uv * uvScale, uvMax)).rgb;
+}
+
+void main() {
+   vec2 uv = warp(texCoord);
+   if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) {
+      fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+      return;
+   }
+
+   // red and blue pulled apart towards the edges
+   vec2 fringe = (uv - 0.5) * chromatic;
+   vec3 color;
+   vec3 center = sampleScene(uv);
+   color.r = sampleScene(uv + fringe).r;
+   color.g = center.g;
+   color.b = sampleScene(uv - fringe).b;
+
+   // the bilinear upscale goes soft, take some of the blur back out
+   if (sharpen > 0.0) {
+      vec3 around = sampleScene(uv + vec2(sceneTexel.x, 0.0));
+      around += sampleScene(uv - vec2(sceneTexel.x, 0.0));
+      around += sampleScene(uv + vec2(0.0, sceneTexel.y));
+      around += sampleScene(uv - vec2(0.0, sceneTexel.y));
+      color = max(color + (center - around * 0.25) * sharpen, 0.0);
+   }
+
+   vec4 over = texture(overlay, uv) * overlayAmount;
+   color = color * (1.0 - over.a) + over.rgb;
+
+   color += texture(bloom, uv).rgb * bloomStrength;
+
+   // lines follow the warped uv so they bend with the screen
+   float line = 0.5 + 0.5 * sin(uv.y * scanlineCount * 6.28318531);
+   color *= mix(1.0, line, scanlineStrength);
+
+   float edge = 16.0 * uv.x * uv.y * (1.0 - uv.x) * (1.0 - uv.y);
+   color *= pow(edge, vignette);
+
+   fragColor = vec4(color, 1.0);
+}
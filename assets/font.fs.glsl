@@ -1,13 +0,0 @@
-#version 460 core
-
-in vec2 texCoord;
-
-uniform sampler2D textureIn;
-uniform vec4 colorIn;
-
-out vec4 fragColor;
-
-void main() {
-    vec4 texelColor = texture(textureIn, texCoord);
-    fragColor = texelColor * colorIn;
-}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 460 core
+
+in vec2 localPos;
+flat in float halfLength;
+flat in float radius;
+in vec4 color;
+
+uniform float glowRadius;
+uniform float glowStrength;
+
+out vec4 fragColor;
+
+void main() {
+   // distance to the edge of a capsule, which gives round caps and clean joints for free
+   float dist = length(vec2(max(abs(localPos.x) - halfLength, 0.0), localPos.y)) - radius;
+
+   // one pixel of coverage based anti-aliasing on the edge
+   float core = clamp(0.5 - dist, 0.0, 1.0);
+   float falloff = glowRadius > 0.0 ? clamp(1.0 - dist / glowRadius, 0.0, 1.0) : 0.0;
+   float alpha = max(core, falloff * falloff * glowStrength);
+   if (alpha <= 0.0) discard;
+
+   fragColor = vec4(color.rgb, color.a * alpha);
+}
@@ -0,0 +1,43 @@
+#version 460 core
+
+// one segment per instance, the quad's corners come from gl_VertexID
+layout (location = 0) in vec2 iStart;
+layout (location = 1) in vec2 iEnd;
+layout (location = 2) in float iWidth;
+layout (location = 3) in vec4 iColor;
+
+uniform mat4 projection;
+uniform mat4 model;
+// in pixels, widths and the glow are screen space so they don't scale with the camera
+uniform vec2 viewport;
+uniform float glowRadius;
+
+// pixels from the segment's centre, x along it and y across
+out vec2 localPos;
+flat out float halfLength;
+flat out float radius;
+out vec4 color;
+
+void main() {
+   vec4 clipStart = projection * model * vec4(iStart, 0.0, 1.0);
+   vec4 clipEnd = projection * model * vec4(iEnd, 0.0, 1.0);
+   vec2 start = (clipStart.xy / clipStart.w * 0.5 + 0.5) * viewport;
+   vec2 end = (clipEnd.xy / clipEnd.w * 0.5 + 0.5) * viewport;
+
+   vec2 dir = end - start;
+   float len = length(dir);
+   dir = len > 0.0001 ? dir / len : vec2(1.0, 0.0);
+   vec2 normal = vec2(-dir.y, dir.x);
+
+   // room for the caps, the glow and a pixel of anti-aliasing on every side
+   float extent = iWidth * 0.5 + glowRadius + 1.0;
+   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+   localPos = corner * vec2(len * 0.5 + extent, extent);
+
+   vec2 pixel = (start + end) * 0.5 + dir * localPos.x + normal * localPos.y;
+   gl_Position = vec4(pixel / viewport * 2.0 - 1.0, clipStart.z / clipStart.w, 1.0);
+
+   halfLength = len * 0.5;
+   radius = iWidth * 0.5;
+   color = iColor;
+}
@@ -0,0 +1,12 @@
+#version 460 core
+
+in vec4 vertexColor;
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+void main() {
+    // soft round particle
+    float dist = length(texCoord - 0.5) * 2.0;
+    fragColor = vec4(vertexColor.rgb, vertexColor.a * (1.0 - smoothstep(0.5, 1.0, dist)));
+}
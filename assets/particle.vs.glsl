@@ -0,0 +1,35 @@
+#version 460 core
+
+struct Particle {
+    vec2 pos;
+    vec2 velocity;
+    vec4 color;
+    float age;
+    float life;
+    float size;
+    float pad;
+};
+
+layout (std430, binding = 0) readonly buffer Particles { Particle particles[]; };
+layout (std430, binding = 2) readonly buffer AliveList { uint aliveIndices[]; };
+
+uniform mat4 projection;
+uniform mat4 model;
+
+out vec4 vertexColor;
+out vec2 texCoord;
+
+void main() {
+    Particle p = particles[aliveIndices[gl_InstanceID]];
+
+    // triangle strip corners (0,0) (1,0) (0,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    float t = p.age / p.life;
+    float size = p.size * (1.0 - 0.5 * t);
+
+    vec2 pos = p.pos + (corner - 0.5) * size;
+    gl_Position = projection * model * vec4(pos, 0.0, 1.0);
+
+    vertexColor = vec4(p.color.rgb, p.color.a * (1.0 - t));
+    texCoord = corner;
+}
@@ -0,0 +1,91 @@
+#version 460 core
+
+layout (local_size_x = 256) in;
+
+struct Particle {
+    vec2 pos;
+    vec2 velocity;
+    vec4 color;
+    float age;
+    float life;
+    float size;
+    float pad;
+};
+
+struct Emitter {
+    vec4 color;
+    vec2 pos;
+    vec2 velocity;
+    vec2 spread;
+    float life;
+    float size;
+    uint spawnOffset;
+    uint spawnCount;
+    vec2 pad;
+};
+
+layout (std430, binding = 0) buffer Particles { Particle particles[]; };
+layout (std430, binding = 1) buffer FreeList { int freeCount; uint freeIndices[]; };
+// last frame's survivors, spawns go on the end for the update pass to pick up
+layout (std430, binding = 5) writeonly buffer AliveInput { uint aliveInput[]; };
+layout (std430, binding = 3) buffer Counters {
+    uint vertexCount;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+    uint groupsX;
+    uint groupsY;
+    uint groupsZ;
+    uint spawned;
+    uint inputCount;
+};
+layout (std430, binding = 4) readonly buffer Emitters { Emitter emitters[]; };
+
+uniform uint spawnTotal;
+uniform uint emitterCount;
+uniform uint seed;
+
+// pcg hash, good enough for visual noise
+uint hash(uint x) {
+    uint state = x * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random(inout uint state) {
+    state = hash(state);
+    return float(state) / 4294967295.0;
+}
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= spawnTotal) return;
+
+    // find which emitter this spawn belongs to, there are only a handful
+    uint e = 0;
+    while (e < emitterCount - 1 && id >= emitters[e].spawnOffset + emitters[e].spawnCount) e++;
+
+    // pop a dead slot, if there aren't any we just drop the spawn
+    int slot = atomicAdd(freeCount, -1) - 1;
+    if (slot < 0) {
+        atomicAdd(freeCount, 1);
+        return;
+    }
+    uint index = freeIndices[slot];
+
+    Emitter em = emitters[e];
+    uint rng = hash(id ^ seed);
+    vec2 jitter = vec2(random(rng), random(rng)) * 2.0 - 1.0;
+
+    Particle p;
+    p.pos = em.pos;
+    p.velocity = em.velocity + jitter * em.spread;
+    p.color = em.color;
+    p.age = 0.0;
+    p.life = em.life * (0.75 + 0.5 * random(rng));
+    p.size = em.size;
+    p.pad = 0.0;
+    particles[index] = p;
+
+    aliveInput[instanceCount + atomicAdd(spawned, 1u)] = index;
+}
@@ -0,0 +1,30 @@
+#version 460 core
+
+layout (local_size_x = 1) in;
+
+// DrawArraysIndirectCommand, then the update pass's DispatchIndirectCommand
+layout (std430, binding = 3) buffer Counters {
+    uint vertexCount;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+    uint groupsX;
+    uint groupsY;
+    uint groupsZ;
+    // appended to the input alive list by the emit pass this frame
+    uint spawned;
+    // length of the input alive list for the update pass
+    uint inputCount;
+};
+
+// Sizes the update dispatch to last frame's survivors plus this frame's spawns
+void main() {
+    inputCount = instanceCount + spawned;
+    groupsX = (inputCount + 255u) / 256u;
+    groupsY = 1u;
+    groupsZ = 1u;
+
+    // the update pass counts the survivors back up
+    instanceCount = 0u;
+    spawned = 0u;
+}
@@ -0,0 +1,80 @@
+#version 460 core
+
+layout (local_size_x = 256) in;
+
+struct Particle {
+    vec2 pos;
+    vec2 velocity;
+    vec4 color;
+    float age;
+    float life;
+    float size;
+    float pad;
+};
+
+layout (std430, binding = 0) buffer Particles { Particle particles[]; };
+layout (std430, binding = 1) buffer FreeList { int freeCount; uint freeIndices[]; };
+layout (std430, binding = 2) writeonly buffer AliveList { uint aliveIndices[]; };
+// DrawArraysIndirectCommand then the dispatch this runs with, instanceCount is reset
+// to 0 by the prepare pass every frame
+layout (std430, binding = 3) buffer Counters {
+    uint vertexCount;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+    uint groupsX;
+    uint groupsY;
+    uint groupsZ;
+    uint spawned;
+    uint inputCount;
+};
+// last frame's alive list plus this frame's spawns, the only slots worth looking at
+layout (std430, binding = 5) readonly buffer AliveInput { uint aliveInput[]; };
+
+uniform float dt;
+uniform vec2 gravity;
+
+// past the end of the input list
+const uint NO_PARTICLE = 0xFFFFFFFFu;
+
+shared uint groupAlive;
+shared uint groupBase;
+
+void main() {
+    uint id = gl_GlobalInvocationID.x < inputCount ? aliveInput[gl_GlobalInvocationID.x] : NO_PARTICLE;
+
+    if (gl_LocalInvocationIndex == 0) groupAlive = 0;
+    barrier();
+
+    bool alive = false;
+    uint localIndex = 0;
+
+    if (id != NO_PARTICLE && particles[id].life > 0.0) {
+        Particle p = particles[id];
+        p.age += dt;
+
+        if (p.age >= p.life) {
+            // dead, give the slot back
+            particles[id].life = 0.0;
+            int slot = atomicAdd(freeCount, 1);
+            freeIndices[slot] = id;
+        } else {
+            p.velocity += gravity * dt;
+            p.pos += p.velocity * dt;
+
+            particles[id].pos = p.pos;
+            particles[id].velocity = p.velocity;
+            particles[id].age = p.age;
+
+            alive = true;
+            localIndex = atomicAdd(groupAlive, 1);
+        }
+    }
+
+    // one global atomic per work group instead of one per particle
+    barrier();
+    if (gl_LocalInvocationIndex == 0) groupBase = atomicAdd(instanceCount, groupAlive);
+    barrier();
+
+    if (alive) aliveIndices[groupBase + localIndex] = id;
+}
@@ -0,0 +1,21 @@
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+// per instance 2x3 affine (Affine2D_t)
+layout (location = 4) in vec2 iXAxis;
+layout (location = 5) in vec2 iYAxis;
+layout (location = 6) in vec2 iTranslation;
+
+uniform mat4 projection;
+uniform mat4 model;
+
+out vec4 vertexColor;
+out vec3 fragCoord;
+
+void main() {
+   vec2 pos = (iXAxis * aPos.x) + (iYAxis * aPos.y) + iTranslation;
+   gl_Position = projection * model * vec4(pos, aPos.z, 1.0);
+   fragCoord = aPos;
+   vertexColor = aColor;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTex;
+// per instance 2x3 affine (Affine2D_t)
+layout (location = 4) in vec2 iXAxis;
+layout (location = 5) in vec2 iYAxis;
+layout (location = 6) in vec2 iTranslation;
+
+out vec2 texCoord;
+out vec3 fragCoord;
+
+uniform mat4 projection;
+uniform mat4 model;
+
+void main() {
+   vec2 pos = (iXAxis * aPos.x) + (iYAxis * aPos.y) + iTranslation;
+   gl_Position = projection * model * vec4(pos, aPos.z, 1.0);
+   fragCoord = aPos;
+   texCoord = aTex;
+}
\ No newline at end of file
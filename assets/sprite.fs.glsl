@@ -0,0 +1,15 @@
+#version 460 core
+
+in vec2 texCoord;
+in vec4 vertexColor;
+
+uniform sampler2D textureIn;
+uniform bool textured;
+uniform vec4 tint;
+
+out vec4 fragColor;
+
+void main() {
+    vec4 color = vertexColor * tint;
+    fragColor = textured ? texture(textureIn, texCoord) * color : color;
+}
@@ -0,0 +1,44 @@
+#version 460 core
+
+struct Sprite {
+    vec2 pos;
+    vec2 size;
+    vec4 uvRect;
+    float rotation;
+    uint color;
+    uint layer;
+    uint pad;
+};
+
+layout (std430, binding = 0) readonly buffer Sprites { Sprite sprites[]; };
+
+uniform mat4 projection;
+uniform mat4 model;
+
+out vec2 texCoord;
+out vec4 vertexColor;
+flat out uint textureLayer;
+
+// two triangles per sprite, same corners and winding the old glyph quad had
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0),
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)
+);
+
+void main() {
+    Sprite s = sprites[gl_VertexID / 6];
+    vec2 corner = corners[gl_VertexID % 6];
+
+    vec2 offset = corner * s.size;
+    if (s.rotation != 0.0) {
+        float c = cos(s.rotation);
+        float r = sin(s.rotation);
+        offset = vec2(offset.x * c - offset.y * r, offset.x * r + offset.y * c);
+    }
+
+    gl_Position = projection * model * vec4(s.pos + offset, 0.0, 1.0);
+
+    texCoord = s.uvRect.xy + vec2(corner.x, 1.0 - corner.y) * s.uvRect.zw;
+    vertexColor = unpackUnorm4x8(s.color);
+    textureLayer = s.layer;
+}
@@ -0,0 +1,14 @@
+#version 460 core
+
+in vec2 texCoord;
+in vec4 vertexColor;
+flat in uint textureLayer;
+
+uniform sampler2DArray textureIn;
+uniform vec4 tint;
+
+out vec4 fragColor;
+
+void main() {
+    fragColor = texture(textureIn, vec3(texCoord, float(textureLayer))) * vertexColor * tint;
+}
@@ -0,0 +1,18 @@
+#version 460 core
+#extension GL_ARB_bindless_texture : require
+
+in vec2 texCoord;
+in vec4 vertexColor;
+flat in uint textureLayer;
+
+// filled by TexturePool_bind, one handle per layer
+layout (std430, binding = 1) readonly buffer TextureHandles { uvec2 handles[]; };
+
+uniform vec4 tint;
+
+out vec4 fragColor;
+
+void main() {
+    // the layer is flat across the sprite, so the handle is dynamically uniform per sprite
+    fragColor = texture(sampler2D(handles[textureLayer]), texCoord) * vertexColor * tint;
+}
@@ -0,0 +1,54 @@
+#!/bin/sh
+# Physics benchmark, runs the 100k object integrate benchmark over and over and
+# reports the median tick time of each run, the target is under 1 ms.
+#
+# usage: scripts/physics_bench.sh [-n runs] [binary]
+#   -n  runs, 10 by default
+#   binary defaults to ./DeltaWingTests
+#
+# Build with optimizations (-DCMAKE_BUILD_TYPE=Release, and -DDW_ENABLE_AVX2=ON to
+# check the AVX path), the plain -g build is nowhere near the target.
+
+RUNS=10
+
+while getopts "n:" opt; do
+    case $opt in
+        n) RUNS=$OPTARG ;;
+        *) echo "usage: $0 [-n runs] [binary]" >&2; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+BIN=${1:-./DeltaWingTests}
+if [ ! -x "$BIN" ]; then
+    echo "Error: $BIN isn't an executable, build first or pass the binary" >&2
+    exit 1
+fi
+
+TMP=$(mktemp)
+trap 'rm -f "$TMP"' EXIT
+
+i=0
+while [ $i -lt "$RUNS" ]; do
+    out=$("$BIN" -b physics 2>&1)
+    tick=$(echo "$out" | sed -n 's/^Physics: .* p50 \([0-9.]*\) ms.*$/\1/p')
+    if [ -z "$tick" ]; then
+        echo "Error: no tick time in the output:" >&2
+        echo "$out" | tail -n 5 >&2
+        exit 1
+    fi
+    echo "$tick" >> "$TMP"
+    i=$((i + 1))
+done
+
+sort -n "$TMP" | awk '
+    { v[NR] = $1; sum += $1 }
+    function pct(p,  i) { i = int(p * (NR - 1) + 0.5) + 1; return v[i] }
+    END {
+        printf "  %-12s n=%-3d min %8.3f  p50 %8.3f  p90 %8.3f  max %8.3f  mean %8.3f ms\n",
+            "tick", NR, v[1], pct(0.5), pct(0.9), v[NR], sum / NR
+        if (pct(0.5) >= 1.0) {
+            print "Error: median tick is over the 1 ms target" > "/dev/stderr"
+            exit 1
+        }
+    }'
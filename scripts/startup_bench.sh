@@ -0,0 +1,111 @@
+#!/bin/sh
+# Startup benchmark, launches the game over and over and reports time to first frame.
+#
+# usage: scripts/startup_bench.sh [-n runs] [-c] [binary]
+#   -n  launches per mode, 10 by default
+#   -c  skip the cold runs
+#   binary defaults to ./DeltaWing, run from the repo root so it finds its assets
+#
+# Cold runs drop the page cache first, which needs root (or passwordless sudo).
+# Without it they're skipped. Warm runs go after one untimed launch to fill the cache.
+#
+# Two numbers per run:
+#   first frame  from main() to the first frame with a scene in it, printed by the game
+#   process      from exec to exit, includes dynamic loading before main and teardown after
+
+RUNS=10
+COLD=1
+
+while getopts "n:c" opt; do
+    case $opt in
+        n) RUNS=$OPTARG ;;
+        c) COLD=0 ;;
+        *) echo "usage: $0 [-n runs] [-c] [binary]" >&2; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+BIN=${1:-./DeltaWing}
+if [ ! -x "$BIN" ]; then
+    echo "Error: $BIN isn't an executable, build first or pass the binary" >&2
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+drop_caches() {
+    sync
+    if [ -w /proc/sys/vm/drop_caches ]; then
+        echo 3 > /proc/sys/vm/drop_caches
+    elif command -v sudo > /dev/null && sudo -n true 2> /dev/null; then
+        sudo -n sh -c 'echo 3 > /proc/sys/vm/drop_caches'
+    else
+        return 1
+    fi
+}
+
+now_ms() {
+    # date +%N isn't everywhere, python is the fallback
+    t=$(date +%s%N 2> /dev/null)
+    case $t in
+        *N) python3 -c 'import time; print("%.3f" % (time.time() * 1000))' ;;
+        *) echo "$t" | awk '{ printf "%.3f\n", $1 / 1000000 }' ;;
+    esac
+}
+
+# run <mode>, appends one line of "first_frame process" to $TMP/<mode>
+run() {
+    start=$(now_ms)
+    out=$(DW_STARTUP_BENCH=1 "$BIN" 2>&1)
+    end=$(now_ms)
+
+    frame=$(echo "$out" | sed -n 's/^Startup: first frame after \([0-9.]*\) ms$/\1/p')
+    if [ -z "$frame" ]; then
+        echo "Error: no first frame in the output:" >&2
+        echo "$out" | tail -n 5 >&2
+        return 1
+    fi
+    echo "$frame $(echo "$start $end" | awk '{ printf "%.2f", $2 - $1 }')" >> "$TMP/$1"
+}
+
+# report <mode> <column> <label>
+report() {
+    cut -d' ' -f"$2" "$TMP/$1" | sort -n | awk -v label="$3" '
+        { v[NR] = $1; sum += $1 }
+        function pct(p,  i) { i = int(p * (NR - 1) + 0.5) + 1; return v[i] }
+        END {
+            printf "  %-12s n=%-3d min %8.2f  p50 %8.2f  p90 %8.2f  p99 %8.2f  max %8.2f  mean %8.2f ms\n",
+                label, NR, v[1], pct(0.5), pct(0.9), pct(0.99), v[NR], sum / NR
+        }'
+}
+
+if [ "$COLD" = 1 ]; then
+    if drop_caches; then
+        i=0
+        while [ $i -lt "$RUNS" ]; do
+            drop_caches
+            run cold || exit 1
+            i=$((i + 1))
+        done
+    else
+        echo "Can't drop the page cache (needs root), skipping cold runs" >&2
+        COLD=0
+    fi
+fi
+
+# untimed, so the warm runs really are warm
+DW_STARTUP_BENCH=1 "$BIN" > /dev/null 2>&1
+
+i=0
+while [ $i -lt "$RUNS" ]; do
+    run warm || exit 1
+    i=$((i + 1))
+done
+
+for mode in cold warm; do
+    [ -f "$TMP/$mode" ] || continue
+    echo "$mode:"
+    report $mode 1 "first frame"
+    report $mode 2 "process"
+done
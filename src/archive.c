@@ -0,0 +1,284 @@
+#include "archive.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+const uint8_t *archiveData_m = NULL;
+size_t archiveSize_m = 0;
+const ArchiveEntry_t *archiveEntries_m = NULL;
+uint32_t archiveEntryCount_m = 0;
+const char *archiveNames_m = NULL;
+
+#ifdef _WIN32
+HANDLE archiveFile_m = INVALID_HANDLE_VALUE;
+HANDLE archiveMapping_m = NULL;
+#endif
+
+uint64_t Archive_hash(const char *path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const uint8_t *c = (const uint8_t*) path; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool Archive_decompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize) {
+    const uint8_t *ip = src;
+    const uint8_t *ipEnd = src + srcSize;
+    uint8_t *op = dst;
+    uint8_t *opEnd = dst + dstSize;
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+
+        // literal run, 15 means more length bytes follow
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ipEnd) return false;
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+
+        if (literals > (size_t) (ipEnd - ip) || literals > (size_t) (opEnd - op)) return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // the last sequence is literals only
+        if (ip >= ipEnd) break;
+
+        if (ipEnd - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t) (op - dst)) return false;
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ipEnd) return false;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += 4;
+        if (matchLen > (size_t) (opEnd - op)) return false;
+
+        // byte by byte since the match can overlap what it's writing
+        const uint8_t *match = op - offset;
+        for (size_t i = 0; i < matchLen; i++) {
+            op[i] = match[i];
+        }
+        op += matchLen;
+    }
+
+    return op == opEnd;
+}
+
+static bool Archive_validate(const uint8_t *data, size_t size) {
+    if (size < sizeof(ArchiveHeader_t)) return false;
+
+    const ArchiveHeader_t *header = (const ArchiveHeader_t*) data;
+    if (memcmp(header->magic, ARCHIVE_MAGIC, 4) != 0 || header->version != ARCHIVE_VERSION) return false;
+
+    size_t indexEnd = sizeof(ArchiveHeader_t) + (size_t) header->entryCount * sizeof(ArchiveEntry_t) + header->namesSize;
+    if (indexEnd > size) return false;
+
+    // anything pointing outside the file gets rejected once here instead of on every load
+    const ArchiveEntry_t *entries = (const ArchiveEntry_t*) (data + sizeof(ArchiveHeader_t));
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const ArchiveEntry_t *entry = &entries[i];
+        size_t stored = (entry->flags & ARCHIVE_ENTRY_COMPRESSED) ? entry->packedSize : (size_t) entry->size + 1;
+        if (entry->offset > size || stored > size - entry->offset || entry->nameOffset >= header->namesSize) return false;
+        // stored entries are handed out in place as strings, so they need their terminator
+        if (!(entry->flags & ARCHIVE_ENTRY_COMPRESSED) && data[entry->offset + entry->size] != '\0') return false;
+    }
+
+    return header->namesSize == 0 || data[indexEnd - 1] == '\0';
+}
+
+bool Archive_mount(const char *packPath) {
+    if (archiveData_m != NULL) {
+        fprintf(stderr, "Error: An asset pack is already mounted.\n");
+        return false;
+    }
+
+    const uint8_t *data = NULL;
+    size_t size = 0;
+
+#ifdef _WIN32
+    archiveFile_m = CreateFileA(packPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (archiveFile_m == INVALID_HANDLE_VALUE) {
+        printf("No asset pack at %s, loading loose files\n", packPath);
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(archiveFile_m, &fileSize);
+    size = (size_t) fileSize.QuadPart;
+
+    archiveMapping_m = CreateFileMappingA(archiveFile_m, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (archiveMapping_m != NULL) data = MapViewOfFile(archiveMapping_m, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = open(packPath, O_RDONLY);
+    if (fd < 0) {
+        printf("No asset pack at %s, loading loose files\n", packPath);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = (size_t) st.st_size;
+        // the mapping keeps the file alive, only the pages we touch ever get read
+        void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) data = mapped;
+    }
+    close(fd);
+#endif
+
+    if (data == NULL) {
+        fprintf(stderr, "Error: Couldn't map asset pack %s, loading loose files.\n", packPath);
+        Archive_unmount();
+        return false;
+    }
+
+    archiveData_m = data;
+    archiveSize_m = size;
+
+    if (!Archive_validate(data, size)) {
+        fprintf(stderr, "Error: %s isn't a valid version %d asset pack, loading loose files.\n", packPath, ARCHIVE_VERSION);
+        Archive_unmount();
+        return false;
+    }
+
+    const ArchiveHeader_t *header = (const ArchiveHeader_t*) data;
+    archiveEntries_m = (const ArchiveEntry_t*) (data + sizeof(ArchiveHeader_t));
+    archiveEntryCount_m = header->entryCount;
+    archiveNames_m = (const char*) (archiveEntries_m + header->entryCount);
+
+    printf("Mounted asset pack %s: %u entries, %zu bytes\n", packPath, archiveEntryCount_m, size);
+    return true;
+}
+
+void Archive_unmount() {
+#ifdef _WIN32
+    if (archiveData_m != NULL) UnmapViewOfFile(archiveData_m);
+    if (archiveMapping_m != NULL) CloseHandle(archiveMapping_m);
+    if (archiveFile_m != INVALID_HANDLE_VALUE) CloseHandle(archiveFile_m);
+    archiveMapping_m = NULL;
+    archiveFile_m = INVALID_HANDLE_VALUE;
+#else
+    if (archiveData_m != NULL) munmap((void*) archiveData_m, archiveSize_m);
+#endif
+
+    archiveData_m = NULL;
+    archiveSize_m = 0;
+    archiveEntries_m = NULL;
+    archiveEntryCount_m = 0;
+    archiveNames_m = NULL;
+}
+
+static const ArchiveEntry_t* Archive_find(const char *path) {
+    uint64_t hash = Archive_hash(path);
+
+    // lower bound on the hash, then walk the (very unlikely) run of collisions
+    uint32_t lo = 0;
+    uint32_t hi = archiveEntryCount_m;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (archiveEntries_m[mid].hash < hash) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (uint32_t i = lo; i < archiveEntryCount_m && archiveEntries_m[i].hash == hash; i++) {
+        if (strcmp(archiveNames_m + archiveEntries_m[i].nameOffset, path) == 0) return &archiveEntries_m[i];
+    }
+    return NULL;
+}
+
+static bool Asset_loadFile(Asset_t *asset, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Unable to open asset %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+
+    uint8_t *data = size >= 0 ? Memory_alloc(MEMORY_TAG_ASSET, size + 1) : NULL;
+    if (data == NULL || fread(data, 1, size, file) != (size_t) size) {
+        fprintf(stderr, "Error: Failed reading asset %s\n", path);
+        Memory_free(data);
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
+    data[size] = '\0';
+    asset->data = data;
+    asset->size = size;
+    asset->owned = data;
+    return true;
+}
+
+bool Asset_load(Asset_t *asset, const char *path) {
+    asset->data = NULL;
+    asset->size = 0;
+    asset->owned = NULL;
+
+    const ArchiveEntry_t *entry = archiveData_m != NULL ? Archive_find(path) : NULL;
+    if (entry == NULL) return Asset_loadFile(asset, path);
+
+    if (!(entry->flags & ARCHIVE_ENTRY_COMPRESSED)) {
+        // zero copy, the packer already put a zero byte after it
+        asset->data = archiveData_m + entry->offset;
+        asset->size = entry->size;
+        return true;
+    }
+
+    uint8_t *data = Memory_alloc(MEMORY_TAG_ASSET, (size_t) entry->size + 1);
+    if (data == NULL || !Archive_decompress(archiveData_m + entry->offset, entry->packedSize, data, entry->size)) {
+        fprintf(stderr, "Error: Corrupt asset %s in pack\n", path);
+        Memory_free(data);
+        return false;
+    }
+
+    data[entry->size] = '\0';
+    asset->data = data;
+    asset->size = entry->size;
+    asset->owned = data;
+    return true;
+}
+
+void Asset_free(Asset_t *asset) {
+    Memory_free(asset->owned);
+    asset->owned = NULL;
+    asset->data = NULL;
+    asset->size = 0;
+}
+
+bool Asset_exists(const char *path) {
+    if (archiveData_m != NULL && Archive_find(path) != NULL) return true;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Asset pack layout, everything little endian:
+ *
+ *   ArchiveHeader_t
+ *   ArchiveEntry_t[entryCount]    sorted by hash
+ *   names                         NUL terminated paths, namesSize bytes
+ *   entry data                    each entry starts on a 64 byte boundary
+ *
+ * Stored entries are always followed by at least one zero byte, so text assets
+ * can be used straight out of the mapping as C strings.
+ */
+#define ARCHIVE_MAGIC "DWPK"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGNMENT 64
+
+// entry data is an LZ4 block, packedSize bytes that expand to size
+#define ARCHIVE_ENTRY_COMPRESSED 0x1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesSize;
+} ArchiveHeader_t;
+
+typedef struct {
+    uint64_t hash;
+    // from the start of the file
+    uint64_t offset;
+    uint32_t size;
+    uint32_t packedSize;
+    // into the names block
+    uint32_t nameOffset;
+    uint32_t flags;
+} ArchiveEntry_t;
+
+// A loaded asset. Either a slice of the mapped pack or a heap copy, Asset_free handles both
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    // set when data was allocated for us (loose files, compressed entries)
+    void *owned;
+} Asset_t;
+
+// FNV-1a over the path, what the index is sorted by
+uint64_t Archive_hash(const char *path);
+
+// Decodes an LZ4 block, returns false unless it comes out to exactly dstSize bytes
+bool Archive_decompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
+/**
+ * Maps the pack for the rest of the run. Assets that aren't in it (or every asset
+ * if there's no pack) are read from loose files instead, so a missing pack isn't fatal.
+ * Call before anything loads assets, lookups don't lock.
+ */
+bool Archive_mount(const char *packPath);
+
+// where the build writes the pack, the default is for builds that don't say
+#ifndef DW_ASSET_PACK
+#define DW_ASSET_PACK "assets.pak"
+#endif
+
+void Archive_unmount();
+
+/**
+ * Loads an asset by the same path it has under the working directory, eg. "assets/pc.vs.glsl".
+ * data is always followed by a zero byte. Safe from any thread.
+ */
+bool Asset_load(Asset_t *asset, const char *path);
+
+void Asset_free(Asset_t *asset);
+
+// True if Asset_load would find it, without loading anything
+bool Asset_exists(const char *path);
+
+#endif
@@ -0,0 +1,175 @@
+#include "arena.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+// heap block for an allocation that didn't fit, data follows the header
+struct ArenaSpill {
+    ArenaSpill_t *next;
+    size_t size;
+};
+
+static Arena_t frameArenas_m[2];
+static uint32_t frameIndex_m;
+
+static Arena_t scratchArenas_m[ARENA_MAX_SCRATCH];
+static uint32_t scratchCount_m;
+static __thread Arena_t *scratch_m;
+// for threads past ARENA_MAX_SCRATCH, no block so everything spills, but it still works
+static __thread Arena_t unlistedScratch_m;
+
+void Arena_init(Arena_t *arena, const char *name, size_t capacity) {
+    memset(arena, 0, sizeof(Arena_t));
+    arena->name = name;
+    arena->base = capacity > 0 ? Memory_alloc(MEMORY_TAG_ENGINE, capacity) : NULL;
+    arena->capacity = arena->base != NULL ? capacity : 0;
+}
+
+void Arena_free(Arena_t *arena) {
+    Arena_reset(arena);
+    Memory_free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+}
+
+static void* Arena_spill(Arena_t *arena, size_t size) {
+    if (arena->overflows++ == 0) {
+        fprintf(stderr, "Error: %s arena is out of its %zu bytes, spilling to the heap\n", arena->name, arena->capacity);
+    }
+
+    ArenaSpill_t *spill = Memory_alloc(MEMORY_TAG_ENGINE, sizeof(ArenaSpill_t) + size);
+    if (spill == NULL) return NULL;
+    spill->next = arena->spills;
+    spill->size = size;
+    arena->spills = spill;
+    arena->spilled += size;
+    return spill + 1;
+}
+
+void* Arena_alloc(Arena_t *arena, size_t size) {
+    size_t start = (arena->used + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+
+    void *ptr;
+    if (start + size <= arena->capacity) {
+        ptr = arena->base + start;
+        arena->used = start + size;
+    } else {
+        ptr = Arena_spill(arena, size);
+    }
+
+    if (arena->used + arena->spilled > arena->highWater) arena->highWater = arena->used + arena->spilled;
+    return ptr;
+}
+
+static char* Arena_vprintf(Arena_t *arena, const char *format, va_list args) {
+    va_list measure;
+    va_copy(measure, args);
+    int length = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+    if (length < 0) return NULL;
+
+    char *str = Arena_alloc(arena, length + 1);
+    if (str != NULL) vsnprintf(str, length + 1, format, args);
+    return str;
+}
+
+char* Arena_printf(Arena_t *arena, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    char *str = Arena_vprintf(arena, format, args);
+    va_end(args);
+    return str;
+}
+
+ArenaMark_t Arena_mark(Arena_t *arena) {
+    return (ArenaMark_t) { arena->used, arena->spills, arena->spilled };
+}
+
+void Arena_rewind(Arena_t *arena, ArenaMark_t mark) {
+    if (mark.used < arena->used) arena->used = mark.used;
+
+    // newest first, so everything in front of the mark's head came after it
+    while (arena->spills != NULL && arena->spills != mark.spills) {
+        ArenaSpill_t *next = arena->spills->next;
+        Memory_free(arena->spills);
+        arena->spills = next;
+    }
+    arena->spilled = arena->spills != NULL ? mark.spilled : 0;
+}
+
+void Arena_reset(Arena_t *arena) {
+    Arena_rewind(arena, (ArenaMark_t) { 0 });
+}
+
+void FrameArena_init() {
+    Arena_init(&frameArenas_m[0], "frame 0", FRAME_ARENA_SIZE);
+    Arena_init(&frameArenas_m[1], "frame 1", FRAME_ARENA_SIZE);
+    frameIndex_m = 0;
+}
+
+void FrameArena_shutdown() {
+    Arena_free(&frameArenas_m[0]);
+    Arena_free(&frameArenas_m[1]);
+
+    uint32_t count = __atomic_load_n(&scratchCount_m, __ATOMIC_ACQUIRE);
+    if (count > ARENA_MAX_SCRATCH) count = ARENA_MAX_SCRATCH;
+    for (uint32_t i = 0; i < count; i++) {
+        Arena_free(&scratchArenas_m[i]);
+    }
+    __atomic_store_n(&scratchCount_m, 0, __ATOMIC_RELEASE);
+    // only ours can be cleared, the other threads are gone by now
+    scratch_m = NULL;
+    Arena_free(&unlistedScratch_m);
+}
+
+void* FrameArena_alloc(size_t size) {
+    return Arena_alloc(&frameArenas_m[frameIndex_m], size);
+}
+
+char* FrameArena_printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    char *str = Arena_vprintf(&frameArenas_m[frameIndex_m], format, args);
+    va_end(args);
+    return str;
+}
+
+void FrameArena_endFrame() {
+    // the other one held last frame's allocations, which have had their extra frame now
+    frameIndex_m ^= 1;
+    Arena_reset(&frameArenas_m[frameIndex_m]);
+}
+
+Arena_t* FrameArena_scratch() {
+    if (scratch_m != NULL) return scratch_m;
+
+    uint32_t slot = __atomic_fetch_add(&scratchCount_m, 1, __ATOMIC_ACQ_REL);
+    if (slot >= ARENA_MAX_SCRATCH) {
+        fprintf(stderr, "Error: Out of scratch arenas, this thread's go to the heap\n");
+        unlistedScratch_m.name = "unlisted scratch";
+        scratch_m = &unlistedScratch_m;
+    } else {
+        Arena_init(&scratchArenas_m[slot], "scratch", SCRATCH_ARENA_SIZE);
+        scratch_m = &scratchArenas_m[slot];
+    }
+    return scratch_m;
+}
+
+static void Arena_printStats(const Arena_t *arena) {
+    printf("  %-8s %8zu / %zu bytes peak, %u overflows\n", arena->name, arena->highWater, arena->capacity, arena->overflows);
+}
+
+void FrameArena_printStats() {
+    printf("Arenas:\n");
+    Arena_printStats(&frameArenas_m[0]);
+    Arena_printStats(&frameArenas_m[1]);
+
+    uint32_t count = __atomic_load_n(&scratchCount_m, __ATOMIC_ACQUIRE);
+    if (count > ARENA_MAX_SCRATCH) count = ARENA_MAX_SCRATCH;
+    for (uint32_t i = 0; i < count; i++) {
+        Arena_printStats(&scratchArenas_m[i]);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// each of the two frame arenas
+#define FRAME_ARENA_SIZE (1 << 20)
+// per thread, for temporaries that don't outlive the function using them
+#define SCRATCH_ARENA_SIZE (256 << 10)
+// every allocation starts on this, enough for anything SIMD loads straight out of
+#define ARENA_ALIGNMENT 16
+// scratch arenas for the job workers, the main thread, the loader and a few spare
+#define ARENA_MAX_SCRATCH 40
+
+typedef struct ArenaSpill ArenaSpill_t;
+
+/**
+ * A bump allocator over one fixed block. Allocating moves a pointer, there is no
+ * per allocation free, everything goes at once on reset (or back to a mark).
+ *
+ * What doesn't fit still gets served, from the heap, so an undersized arena
+ * doesn't crash anything. Those spills are counted and freed with everything else
+ * on reset or rewind, and the first one prints an error, the stats say how big the
+ * arena should be.
+ */
+typedef struct {
+    const char *name;
+    uint8_t *base;
+    size_t capacity;
+    size_t used;
+
+    ArenaSpill_t *spills;
+    size_t spilled;
+    // most that was in use at once, spills included
+    size_t highWater;
+    uint32_t overflows;
+} Arena_t;
+
+// Where an arena was at, spills included, so a rewind frees the ones made since
+typedef struct {
+    size_t used;
+    ArenaSpill_t *spills;
+    size_t spilled;
+} ArenaMark_t;
+
+void Arena_init(Arena_t *arena, const char *name, size_t capacity);
+
+void Arena_free(Arena_t *arena);
+
+void* Arena_alloc(Arena_t *arena, size_t size);
+
+// vsnprintf into the arena
+char* Arena_printf(Arena_t *arena, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// Everything allocated after a mark goes on rewind, spills too
+ArenaMark_t Arena_mark(Arena_t *arena);
+
+void Arena_rewind(Arena_t *arena, ArenaMark_t mark);
+
+void Arena_reset(Arena_t *arena);
+
+/**
+ * The frame arenas, main thread only. There are two, swapped by FrameArena_endFrame,
+ * so something allocated during a frame is still there for all of the next one,
+ * eg. from a tick to the render after it. Then it's gone, never keep a pointer longer.
+ */
+void FrameArena_init();
+
+// Frees the frame and scratch arenas, after the job system and loader have stopped
+void FrameArena_shutdown();
+
+void* FrameArena_alloc(size_t size);
+
+char* FrameArena_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Swaps arenas and empties the one this frame allocates from, once the frame is done with
+void FrameArena_endFrame();
+
+/**
+ * The calling thread's scratch arena, made on first use. Anything using it takes a
+ * mark and rewinds to it before returning, so it's empty between jobs:
+ *
+ *   Arena_t *scratch = FrameArena_scratch();
+ *   ArenaMark_t mark = Arena_mark(scratch);
+ *   ...
+ *   Arena_rewind(scratch, mark);
+ */
+Arena_t* FrameArena_scratch();
+
+// High water marks and overflows of every arena so far
+void FrameArena_printStats();
+
+#endif
@@ -0,0 +1,333 @@
+#include "atlas.h"
+
+#include <string.h>
+
+#include "jobs.h"
+#include "memory.h"
+
+// images decoded per job while building
+#define ATLAS_DECODE_BATCH 4
+
+void Skyline_init(Skyline_t *skyline, uint32_t width, uint32_t height) {
+    skyline->width = width;
+    skyline->height = height;
+    skyline->nodeCapacity = 16;
+    skyline->nodes = Memory_alloc(MEMORY_TAG_ASSET, skyline->nodeCapacity * sizeof(SkylineNode_t));
+    // one flat span along the bottom to start with
+    skyline->nodes[0] = (SkylineNode_t) { 0, 0, width };
+    skyline->nodeCount = 1;
+    skyline->usedHeight = 0;
+}
+
+void Skyline_free(Skyline_t *skyline) {
+    Memory_free(skyline->nodes);
+    skyline->nodes = NULL;
+    skyline->nodeCount = 0;
+}
+
+// y a rect would sit at with its left edge on node index, UINT32_MAX if it runs off the side
+static uint32_t fitAt(Skyline_t *skyline, uint32_t index, uint32_t width) {
+    if (skyline->nodes[index].x + width > skyline->width) return UINT32_MAX;
+
+    uint32_t y = 0;
+    uint32_t remaining = width;
+    // the nodes always cover the whole width, so this can't run off the end
+    for (uint32_t i = index; ; i++) {
+        const SkylineNode_t *node = &skyline->nodes[i];
+        if (node->y > y) y = node->y;
+        if (node->width >= remaining) break;
+        remaining -= node->width;
+    }
+    return y;
+}
+
+static void removeNode(Skyline_t *skyline, uint32_t index) {
+    memmove(&skyline->nodes[index], &skyline->nodes[index + 1], (skyline->nodeCount - index - 1) * sizeof(SkylineNode_t));
+    skyline->nodeCount--;
+}
+
+bool Skyline_insert(Skyline_t *skyline, uint32_t width, uint32_t height, uint32_t *x, uint32_t *y) {
+    int32_t best = -1;
+    uint32_t bestY = 0;
+    uint32_t bestTop = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+
+    for (uint32_t i = 0; i < skyline->nodeCount; i++) {
+        uint32_t fit = fitAt(skyline, i, width);
+        if (fit == UINT32_MAX || fit + height > skyline->height) continue;
+
+        // lowest top edge wins, ties go to the narrower span so wide gaps are kept for wide rects
+        uint32_t top = fit + height;
+        if (top < bestTop || (top == bestTop && skyline->nodes[i].width < bestWidth)) {
+            best = i;
+            bestY = fit;
+            bestTop = top;
+            bestWidth = skyline->nodes[i].width;
+        }
+    }
+
+    if (best < 0) return false;
+
+    if (skyline->nodeCount == skyline->nodeCapacity) {
+        skyline->nodeCapacity *= 2;
+        skyline->nodes = Memory_realloc(MEMORY_TAG_ASSET, skyline->nodes, skyline->nodeCapacity * sizeof(SkylineNode_t));
+    }
+
+    *x = skyline->nodes[best].x;
+    *y = bestY;
+
+    memmove(&skyline->nodes[best + 1], &skyline->nodes[best], (skyline->nodeCount - best) * sizeof(SkylineNode_t));
+    skyline->nodes[best] = (SkylineNode_t) { *x, bestTop, width };
+    skyline->nodeCount++;
+
+    // cut away whatever the new span covers
+    for (uint32_t i = best + 1; i < skyline->nodeCount; ) {
+        SkylineNode_t *node = &skyline->nodes[i];
+        uint32_t prevEnd = skyline->nodes[i - 1].x + skyline->nodes[i - 1].width;
+        if (node->x >= prevEnd) break;
+
+        uint32_t overlap = prevEnd - node->x;
+        if (node->width <= overlap) {
+            removeNode(skyline, i);
+            continue;
+        }
+        node->x += overlap;
+        node->width -= overlap;
+        break;
+    }
+
+    // neighbours at the same height become one span
+    for (uint32_t i = 0; i + 1 < skyline->nodeCount; ) {
+        if (skyline->nodes[i].y == skyline->nodes[i + 1].y) {
+            skyline->nodes[i].width += skyline->nodes[i + 1].width;
+            removeNode(skyline, i + 1);
+        } else {
+            i++;
+        }
+    }
+
+    if (bestTop > skyline->usedHeight) skyline->usedHeight = bestTop;
+    return true;
+}
+
+void Atlas_init(Atlas_t *atlas, uint32_t pageSize, uint32_t padding) {
+    memset(atlas, 0, sizeof(Atlas_t));
+    atlas->pageSize = pageSize;
+
+    // a gutter of 2^n texels keeps the first n mip levels from bleeding
+    if (padding > 0) {
+        atlas->padding = 1;
+        while (atlas->padding * 2 <= padding) {
+            atlas->padding *= 2;
+            atlas->mipLevels++;
+        }
+    }
+}
+
+static void freePages(Atlas_t *atlas) {
+    for (uint32_t i = 0; i < atlas->pageCount; i++) {
+        DW_freeTexture(&atlas->pages[i]);
+    }
+    atlas->pageCount = 0;
+}
+
+void Atlas_free(Atlas_t *atlas) {
+    freePages(atlas);
+
+    for (uint32_t i = 0; i < atlas->count; i++) {
+        Memory_free(atlas->paths[i]);
+    }
+    Memory_free(atlas->paths);
+    Memory_free(atlas->regions);
+    atlas->paths = NULL;
+    atlas->regions = NULL;
+    atlas->count = 0;
+    atlas->capacity = 0;
+}
+
+uint32_t Atlas_add(Atlas_t *atlas, const char *path) {
+    if (atlas->count == atlas->capacity) {
+        atlas->capacity = atlas->capacity ? atlas->capacity * 2 : 32;
+        atlas->paths = Memory_realloc(MEMORY_TAG_ASSET, atlas->paths, atlas->capacity * sizeof(char*));
+        atlas->regions = Memory_realloc(MEMORY_TAG_ASSET, atlas->regions, atlas->capacity * sizeof(AtlasRegion_t));
+    }
+
+    uint32_t index = atlas->count++;
+    atlas->paths[index] = Memory_strdup(MEMORY_TAG_ASSET, path);
+    memset(&atlas->regions[index], 0, sizeof(AtlasRegion_t));
+    atlas->regions[index].page = -1;
+    return index;
+}
+
+typedef struct {
+    Atlas_t *atlas;
+    Image_t *images;
+} AtlasDecode_t;
+
+static void decodeRange(void *data, uint32_t start, uint32_t end) {
+    AtlasDecode_t *decode = (AtlasDecode_t*) data;
+    for (uint32_t i = start; i < end; i++) {
+        DW_loadImage(&decode->images[i], decode->atlas->paths[i]);
+    }
+}
+
+typedef struct {
+    uint32_t index;
+    uint32_t width;
+    uint32_t height;
+} AtlasItem_t;
+
+// tallest first, then widest, so each skyline row gets filled with similar heights
+static int compareItems(const void *a, const void *b) {
+    const AtlasItem_t *ia = (const AtlasItem_t*) a;
+    const AtlasItem_t *ib = (const AtlasItem_t*) b;
+    if (ia->height != ib->height) return ia->height < ib->height ? 1 : -1;
+    if (ia->width != ib->width) return ia->width < ib->width ? 1 : -1;
+    return ia->index < ib->index ? -1 : 1;
+}
+
+// Copies the image in as rgba, then smears its edges out over the gutter
+static void blitRegion(uint8_t *page, uint32_t pageWidth, const AtlasRegion_t *region, const Image_t *image, uint32_t padding) {
+    int32_t pad = (int32_t) padding;
+    int32_t width = (int32_t) region->width;
+    int32_t height = (int32_t) region->height;
+    int channels = image->channels;
+
+    for (int32_t y = -pad; y < height + pad; y++) {
+        int32_t sy = y < 0 ? 0 : y >= height ? height - 1 : y;
+        uint8_t *row = page + ((size_t) (region->y + y) * pageWidth + region->x) * 4;
+
+        for (int32_t x = -pad; x < width + pad; x++) {
+            int32_t sx = x < 0 ? 0 : x >= width ? width - 1 : x;
+            const uint8_t *src = image->pixels + ((size_t) sy * width + sx) * channels;
+            uint8_t *dst = row + (ptrdiff_t) x * 4;
+
+            if (channels >= 3) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            } else {
+                dst[0] = dst[1] = dst[2] = src[0];
+            }
+            dst[3] = channels == 4 ? src[3] : channels == 2 ? src[1] : 255;
+        }
+    }
+}
+
+bool Atlas_pack(Atlas_t *atlas, const Image_t *images, Image_t *pages, uint32_t *pageCountOut) {
+    AtlasItem_t *items = Memory_alloc(MEMORY_TAG_ASSET, atlas->count * sizeof(AtlasItem_t));
+    uint32_t itemCount = 0;
+    for (uint32_t i = 0; i < atlas->count; i++) {
+        atlas->regions[i].page = -1;
+        if (images[i].pixels == NULL) continue;
+        items[itemCount++] = (AtlasItem_t) { i, images[i].width, images[i].height };
+    }
+    qsort(items, itemCount, sizeof(AtlasItem_t), compareItems);
+
+    // cells are rounded up to the padding so every image starts on a mip aligned texel
+    uint32_t align = atlas->padding ? atlas->padding : 1;
+    Skyline_t skylines[ATLAS_MAX_PAGES];
+    uint32_t pageCount = 0;
+    bool allPlaced = true;
+
+    for (uint32_t i = 0; i < itemCount; i++) {
+        AtlasItem_t *item = &items[i];
+        uint32_t cellWidth = (item->width + atlas->padding * 2 + align - 1) & ~(align - 1);
+        uint32_t cellHeight = (item->height + atlas->padding * 2 + align - 1) & ~(align - 1);
+
+        // too big for any page, don't start an empty one for it
+        bool fits = cellWidth <= atlas->pageSize && cellHeight <= atlas->pageSize;
+
+        uint32_t x, y;
+        int32_t page = -1;
+        for (uint32_t p = 0; fits && p < pageCount && page < 0; p++) {
+            if (Skyline_insert(&skylines[p], cellWidth, cellHeight, &x, &y)) page = p;
+        }
+        if (fits && page < 0 && pageCount < ATLAS_MAX_PAGES) {
+            Skyline_init(&skylines[pageCount], atlas->pageSize, atlas->pageSize);
+            if (Skyline_insert(&skylines[pageCount], cellWidth, cellHeight, &x, &y)) page = pageCount;
+            pageCount++;
+        }
+
+        if (page < 0) {
+            fprintf(stderr, "Error: %s doesn't fit in the atlas\n", atlas->paths[item->index]);
+            allPlaced = false;
+            continue;
+        }
+
+        AtlasRegion_t *region = &atlas->regions[item->index];
+        region->page = page;
+        region->x = x + atlas->padding;
+        region->y = y + atlas->padding;
+        region->width = item->width;
+        region->height = item->height;
+    }
+
+    for (uint32_t p = 0; p < pageCount; p++) {
+        // pages are only as tall as they need to be, still a power of two
+        uint32_t height = 1;
+        while (height < skylines[p].usedHeight) height *= 2;
+
+        pages[p] = (Image_t) { atlas->pageSize, height, 4, Memory_calloc(MEMORY_TAG_ASSET, (size_t) atlas->pageSize * height, 4) };
+        for (uint32_t i = 0; i < atlas->count; i++) {
+            AtlasRegion_t *region = &atlas->regions[i];
+            if (region->page != (int32_t) p) continue;
+
+            blitRegion(pages[p].pixels, atlas->pageSize, region, &images[i], atlas->padding);
+            glm_vec4_copy((vec4) {
+                (float) region->x / atlas->pageSize,
+                (float) region->y / height,
+                (float) (region->x + region->width) / atlas->pageSize,
+                (float) (region->y + region->height) / height
+            }, region->uv);
+        }
+
+        Skyline_free(&skylines[p]);
+    }
+    *pageCountOut = pageCount;
+
+    Memory_free(items);
+    return allPlaced && itemCount == atlas->count;
+}
+
+bool Atlas_build(Atlas_t *atlas) {
+    freePages(atlas);
+
+    Image_t *images = Memory_calloc(MEMORY_TAG_ASSET, atlas->count, sizeof(Image_t));
+    AtlasDecode_t decode = { atlas, images };
+    JobSystem_parallelFor(atlas->count, ATLAS_DECODE_BATCH, decodeRange, &decode);
+
+    Image_t pages[ATLAS_MAX_PAGES];
+    uint32_t pageCount = 0;
+    bool allPlaced = Atlas_pack(atlas, images, pages, &pageCount);
+
+    for (uint32_t p = 0; p < pageCount; p++) {
+        atlas->pages[p] = DW_createTexture(&pages[p]);
+        Memory_free(pages[p].pixels);
+
+        // levels past what the gutter covers would bleed, so they're never sampled
+        glBindTexture(GL_TEXTURE_2D, atlas->pages[p].texId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, atlas->mipLevels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, atlas->mipLevels > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    atlas->pageCount = pageCount;
+
+    for (uint32_t i = 0; i < atlas->count; i++) {
+        if (images[i].pixels != NULL) DW_freeImage(&images[i]);
+    }
+    Memory_free(images);
+
+    return allPlaced;
+}
+
+const AtlasRegion_t* Atlas_region(Atlas_t *atlas, uint32_t index) {
+    return &atlas->regions[index];
+}
+
+const Texture_t* Atlas_page(Atlas_t *atlas, uint32_t index) {
+    int32_t page = atlas->regions[index].page;
+    return page >= 0 ? &atlas->pages[page] : NULL;
+}
@@ -0,0 +1,101 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <cglm/cglm.h>
+
+#include "renderer.h"
+
+// textures an atlas can spill over into
+#define ATLAS_MAX_PAGES 8
+
+// A span of the skyline, everything from x to x + width is used up to y
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+} SkylineNode_t;
+
+/**
+ * Bottom-left skyline rectangle packer. Only the top edge of what's been placed
+ * is tracked, so a rect never goes in underneath another one, but it's cheap and
+ * packs sprites sorted by height about as well as MaxRects does.
+ */
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    SkylineNode_t *nodes;
+    uint32_t nodeCount;
+    uint32_t nodeCapacity;
+    // highest y anything reaches
+    uint32_t usedHeight;
+} Skyline_t;
+
+void Skyline_init(Skyline_t *skyline, uint32_t width, uint32_t height);
+
+void Skyline_free(Skyline_t *skyline);
+
+// Finds the spot that keeps the top of the rect lowest, false if it doesn't fit anywhere
+bool Skyline_insert(Skyline_t *skyline, uint32_t width, uint32_t height, uint32_t *x, uint32_t *y);
+
+typedef struct {
+    // u0, v0, u1, v1. v0 is the bottom edge, images are flipped for GL like everywhere else
+    vec4 uv;
+    // index into pages, -1 if it couldn't be loaded or didn't fit
+    int32_t page;
+    // in pixels, without the gutter
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} AtlasRegion_t;
+
+/**
+ * Packs lots of small images into a few big textures, so sprites using different
+ * images can still be drawn with one bound texture.
+ *
+ * Every image gets a gutter of padding pixels copied from its edges and starts on
+ * a multiple of the padding, so neither linear filtering nor the mip levels that
+ * get sampled (log2 of the padding) pick up texels from a neighbour.
+ */
+typedef struct {
+    uint32_t pageSize;
+    // rounded down to a power of two
+    uint32_t padding;
+    uint32_t mipLevels;
+
+    char **paths;
+    AtlasRegion_t *regions;
+    uint32_t count;
+    uint32_t capacity;
+
+    Texture_t pages[ATLAS_MAX_PAGES];
+    uint32_t pageCount;
+} Atlas_t;
+
+// pageSize should be a power of two, eg. 2048
+void Atlas_init(Atlas_t *atlas, uint32_t pageSize, uint32_t padding);
+
+void Atlas_free(Atlas_t *atlas);
+
+// Queues an image for the next Atlas_build, returns its region index
+uint32_t Atlas_add(Atlas_t *atlas, const char *path);
+
+/**
+ * Places images (one per region, ones without pixels are skipped), fills in the regions
+ * and writes each page used into pages as rgba, for the caller to free. No GL in here,
+ * Atlas_build is this plus the upload. False if anything didn't fit
+ */
+bool Atlas_pack(Atlas_t *atlas, const Image_t *images, Image_t *pages, uint32_t *pageCount);
+
+// Decodes everything on the job system, packs it and uploads the pages. Replaces any earlier build
+bool Atlas_build(Atlas_t *atlas);
+
+const AtlasRegion_t* Atlas_region(Atlas_t *atlas, uint32_t index);
+
+// Texture a region lives in, NULL if it has none
+const Texture_t* Atlas_page(Atlas_t *atlas, uint32_t index);
+
+#endif
@@ -0,0 +1,34 @@
+#include "camera.h"
+
+void Camera_init(Camera_t *camera, float viewportWidth, float viewportHeight) {
+    glm_vec2_zero(camera->pos);
+    camera->zoom = 1.0f;
+    glm_vec2_copy((vec2) { viewportWidth, viewportHeight }, camera->viewportSize);
+    Camera_update(camera);
+}
+
+void Camera_update(Camera_t *camera) {
+    float width = camera->viewportSize[0] / camera->zoom;
+    float height = camera->viewportSize[1] / camera->zoom;
+
+    glm_vec2_copy((vec2) { camera->pos[0] - (width / 2.f), camera->pos[1] - (height / 2.f) }, camera->view.pos);
+    glm_vec2_copy((vec2) { width, height }, camera->view.size);
+
+    glm_ortho(
+        camera->view.pos[0],
+        camera->view.pos[0] + width,
+        camera->view.pos[1],
+        camera->view.pos[1] + height,
+        -1.0f,
+        0.0f,
+        camera->projection
+    );
+}
+
+bool Camera_isVisible(Camera_t *camera, Rect_t *rect) {
+    Rect_t *view = &camera->view;
+    return rect->pos[0] < view->pos[0] + view->size[0]
+        && view->pos[0] < rect->pos[0] + rect->size[0]
+        && rect->pos[1] < view->pos[1] + view->size[1]
+        && view->pos[1] < rect->pos[1] + rect->size[1];
+}
@@ -0,0 +1,29 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <cglm/cglm.h>
+
+#include "engine.h"
+
+// 2D orthographic camera, pos is the center of the screen
+typedef struct {
+    vec2 pos;
+    float zoom;
+    // size of the screen in pixels
+    vec2 viewportSize;
+
+    // recalculated by Camera_update
+    // world space rectangle that's on screen
+    Rect_t view;
+    mat4 projection;
+} Camera_t;
+
+void Camera_init(Camera_t *camera, float viewportWidth, float viewportHeight);
+
+// Rebuilds the projection and view rect from pos and zoom
+void Camera_update(Camera_t *camera);
+
+// True if any part of rect is on screen
+bool Camera_isVisible(Camera_t *camera, Rect_t *rect);
+
+#endif
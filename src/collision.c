@@ -0,0 +1,349 @@
+#include "collision.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+bool Rect_intersects(Rect_t *a, Rect_t *b) {
+    return a->pos[0] < b->pos[0] + b->size[0]
+        && b->pos[0] < a->pos[0] + a->size[0]
+        && a->pos[1] < b->pos[1] + b->size[1]
+        && b->pos[1] < a->pos[1] + a->size[1];
+}
+
+bool Rect_raycast(Rect_t *rect, vec2 origin, vec2 delta, float *hitTime) {
+    float tMin = 0.0f;
+    float tMax = 1.0f;
+
+    for (int i = 0; i < 2; i++) {
+        float min = rect->pos[i];
+        float max = rect->pos[i] + rect->size[i];
+
+        if (fabsf(delta[i]) < FLT_EPSILON) {
+            // parallel to this slab, either always inside it or never
+            if (origin[i] < min || origin[i] > max) return false;
+            continue;
+        }
+
+        float invD = 1.0f / delta[i];
+        float t1 = (min - origin[i]) * invD;
+        float t2 = (max - origin[i]) * invD;
+        if (t1 > t2) {
+            float tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+
+        if (t1 > tMin) tMin = t1;
+        if (t2 < tMax) tMax = t2;
+        if (tMin > tMax) return false;
+    }
+
+    *hitTime = tMin;
+    return true;
+}
+
+bool Rect_sweep(Rect_t *moving, vec2 delta, Rect_t *target, float *hitTime, vec2 normal) {
+    glm_vec2_zero(normal);
+
+    if (Rect_intersects(moving, target)) {
+        *hitTime = 0.0f;
+        return true;
+    }
+
+    // minkowski sum, this turns it into a ray from moving->pos vs a bigger box
+    float tEnter = 0.0f;
+    float tExit = 1.0f;
+    int hitAxis = -1;
+
+    for (int i = 0; i < 2; i++) {
+        float min = target->pos[i] - moving->size[i];
+        float max = target->pos[i] + target->size[i];
+        float o = moving->pos[i];
+
+        if (fabsf(delta[i]) < FLT_EPSILON) {
+            if (o <= min || o >= max) return false;
+            continue;
+        }
+
+        float invD = 1.0f / delta[i];
+        float t1 = (min - o) * invD;
+        float t2 = (max - o) * invD;
+        if (t1 > t2) {
+            float tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+
+        if (t1 > tEnter) {
+            tEnter = t1;
+            hitAxis = i;
+        }
+        if (t2 < tExit) tExit = t2;
+        if (tEnter > tExit) return false;
+    }
+
+    if (hitAxis < 0) return false;
+
+    normal[hitAxis] = delta[hitAxis] > 0.0f ? -1.0f : 1.0f;
+    *hitTime = tEnter;
+    return true;
+}
+
+void Rect_union(Rect_t *a, Rect_t *b, Rect_t *dest) {
+    float minX = fminf(a->pos[0], b->pos[0]);
+    float minY = fminf(a->pos[1], b->pos[1]);
+    float maxX = fmaxf(a->pos[0] + a->size[0], b->pos[0] + b->size[0]);
+    float maxY = fmaxf(a->pos[1] + a->size[1], b->pos[1] + b->size[1]);
+
+    glm_vec2_copy((vec2) { minX, minY }, dest->pos);
+    glm_vec2_copy((vec2) { maxX - minX, maxY - minY }, dest->size);
+}
+
+void CollisionPairArray_init(CollisionPairArray_t *array, uint32_t capacity) {
+    array->size = 0;
+    array->capacity = capacity;
+    array->ptr = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(CollisionPair_t));
+}
+
+void CollisionPairArray_free(CollisionPairArray_t *array) {
+    Memory_free(array->ptr);
+    array->ptr = NULL;
+    array->size = 0;
+    array->capacity = 0;
+}
+
+void CollisionHitArray_init(CollisionHitArray_t *array, uint32_t capacity) {
+    array->size = 0;
+    array->capacity = capacity;
+    array->ptr = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(CollisionHit_t));
+}
+
+void CollisionHitArray_free(CollisionHitArray_t *array) {
+    Memory_free(array->ptr);
+    array->ptr = NULL;
+    array->size = 0;
+    array->capacity = 0;
+}
+
+static void pushPair(CollisionPairArray_t *array, uint32_t a, uint32_t b) {
+    if (array->size == array->capacity) {
+        array->capacity = array->capacity ? array->capacity * 2 : 16;
+        array->ptr = Memory_realloc(MEMORY_TAG_SCENE, array->ptr, array->capacity * sizeof(CollisionPair_t));
+    }
+
+    array->ptr[array->size++] = (CollisionPair_t) { a, b };
+}
+
+static void pushHit(CollisionHitArray_t *array, uint32_t index, float t) {
+    if (array->size == array->capacity) {
+        array->capacity = array->capacity ? array->capacity * 2 : 16;
+        array->ptr = Memory_realloc(MEMORY_TAG_SCENE, array->ptr, array->capacity * sizeof(CollisionHit_t));
+    }
+
+    array->ptr[array->size++] = (CollisionHit_t) { index, t };
+}
+
+static uint32_t nextPow2(uint32_t v) {
+    uint32_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+static inline uint32_t hashCell(SpatialHash_t *hash, int32_t x, int32_t y) {
+    uint32_t h = ((uint32_t) x * 73856093u) ^ ((uint32_t) y * 19349663u);
+    return h & (hash->bucketCount - 1);
+}
+
+static inline int32_t cellCoord(SpatialHash_t *hash, float v) {
+    return (int32_t) floorf(v * hash->invCellSize);
+}
+
+// next stamp for the visited list, wraps around by clearing it
+static uint32_t nextStamp(SpatialHash_t *hash) {
+    if (++hash->stamp == 0) {
+        memset(hash->visitStamp, 0, hash->rectCapacity * sizeof(uint32_t));
+        hash->stamp = 1;
+    }
+    return hash->stamp;
+}
+
+void SpatialHash_init(SpatialHash_t *hash, float cellSize, uint32_t maxRects) {
+    hash->cellSize = cellSize;
+    hash->invCellSize = 1.0f / cellSize;
+
+    // about 2 buckets per box keeps unrelated cells from sharing too often
+    hash->bucketCount = nextPow2(maxRects * 2 > 64 ? maxRects * 2 : 64);
+    hash->bucketStart = Memory_calloc(MEMORY_TAG_SCENE, hash->bucketCount + 1, sizeof(uint32_t));
+
+    hash->entryCount = 0;
+    hash->entryCapacity = maxRects * 4;
+    hash->entries = Memory_alloc(MEMORY_TAG_SCENE, hash->entryCapacity * sizeof(uint32_t));
+
+    hash->rectCount = 0;
+    hash->rectCapacity = maxRects;
+    hash->rects = Memory_alloc(MEMORY_TAG_SCENE, maxRects * sizeof(Rect_t));
+    hash->visitStamp = Memory_calloc(MEMORY_TAG_SCENE, maxRects, sizeof(uint32_t));
+    hash->stamp = 0;
+}
+
+void SpatialHash_free(SpatialHash_t *hash) {
+    Memory_free(hash->bucketStart);
+    Memory_free(hash->entries);
+    Memory_free(hash->rects);
+    Memory_free(hash->visitStamp);
+
+    hash->bucketStart = NULL;
+    hash->entries = NULL;
+    hash->rects = NULL;
+    hash->visitStamp = NULL;
+}
+
+void SpatialHash_build(SpatialHash_t *hash, Rect_t *rects, uint32_t count) {
+    if (count > hash->rectCapacity) {
+        fprintf(stderr, "Warning: SpatialHash grew from %u to %u boxes, consider a bigger maxRects.\n", hash->rectCapacity, count);
+        hash->rectCapacity = count;
+        hash->rects = Memory_realloc(MEMORY_TAG_SCENE, hash->rects, count * sizeof(Rect_t));
+        hash->visitStamp = Memory_realloc(MEMORY_TAG_SCENE, hash->visitStamp, count * sizeof(uint32_t));
+        memset(hash->visitStamp, 0, count * sizeof(uint32_t));
+        hash->stamp = 0;
+    }
+
+    memcpy(hash->rects, rects, count * sizeof(Rect_t));
+    hash->rectCount = count;
+
+    uint32_t *start = hash->bucketStart;
+    memset(start, 0, (hash->bucketCount + 1) * sizeof(uint32_t));
+
+    // count how many entries land in each bucket
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        Rect_t *r = &rects[i];
+        int32_t x0 = cellCoord(hash, r->pos[0]);
+        int32_t y0 = cellCoord(hash, r->pos[1]);
+        int32_t x1 = cellCoord(hash, r->pos[0] + r->size[0]);
+        int32_t y1 = cellCoord(hash, r->pos[1] + r->size[1]);
+
+        for (int32_t y = y0; y <= y1; y++) {
+            for (int32_t x = x0; x <= x1; x++) {
+                start[hashCell(hash, x, y)]++;
+                total++;
+            }
+        }
+    }
+
+    if (total > hash->entryCapacity) {
+        hash->entryCapacity = total * 2;
+        hash->entries = Memory_realloc(MEMORY_TAG_SCENE, hash->entries, hash->entryCapacity * sizeof(uint32_t));
+    }
+    hash->entryCount = total;
+
+    // inclusive prefix sum, start[b] is now the end of bucket b
+    for (uint32_t b = 1; b < hash->bucketCount; b++) {
+        start[b] += start[b - 1];
+    }
+    start[hash->bucketCount] = total;
+
+    // fill backwards, which leaves start[b] pointing at the beginning of bucket b
+    for (uint32_t i = 0; i < count; i++) {
+        Rect_t *r = &rects[i];
+        int32_t x0 = cellCoord(hash, r->pos[0]);
+        int32_t y0 = cellCoord(hash, r->pos[1]);
+        int32_t x1 = cellCoord(hash, r->pos[0] + r->size[0]);
+        int32_t y1 = cellCoord(hash, r->pos[1] + r->size[1]);
+
+        for (int32_t y = y0; y <= y1; y++) {
+            for (int32_t x = x0; x <= x1; x++) {
+                hash->entries[--start[hashCell(hash, x, y)]] = i;
+            }
+        }
+    }
+}
+
+// Tests one box against everything sharing a cell with it
+static void queryRect(SpatialHash_t *hash, Rect_t *rect, uint32_t queryIndex, CollisionPairArray_t *out) {
+    uint32_t stamp = nextStamp(hash);
+
+    int32_t x0 = cellCoord(hash, rect->pos[0]);
+    int32_t y0 = cellCoord(hash, rect->pos[1]);
+    int32_t x1 = cellCoord(hash, rect->pos[0] + rect->size[0]);
+    int32_t y1 = cellCoord(hash, rect->pos[1] + rect->size[1]);
+
+    for (int32_t y = y0; y <= y1; y++) {
+        for (int32_t x = x0; x <= x1; x++) {
+            uint32_t b = hashCell(hash, x, y);
+
+            for (uint32_t e = hash->bucketStart[b]; e < hash->bucketStart[b + 1]; e++) {
+                uint32_t other = hash->entries[e];
+
+                if (hash->visitStamp[other] == stamp) continue;
+                hash->visitStamp[other] = stamp;
+
+                if (Rect_intersects(rect, &hash->rects[other])) {
+                    pushPair(out, queryIndex, other);
+                }
+            }
+        }
+    }
+}
+
+void SpatialHash_queryRects(SpatialHash_t *hash, Rect_t *rects, uint32_t count, CollisionPairArray_t *out) {
+    out->size = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        queryRect(hash, &rects[i], i, out);
+    }
+}
+
+void SpatialHash_querySegment(SpatialHash_t *hash, vec2 origin, vec2 delta, CollisionHitArray_t *out) {
+    out->size = 0;
+    uint32_t stamp = nextStamp(hash);
+
+    // walk the cells along the segment (Amanatides & Woo)
+    int32_t x = cellCoord(hash, origin[0]);
+    int32_t y = cellCoord(hash, origin[1]);
+    int32_t endX = cellCoord(hash, origin[0] + delta[0]);
+    int32_t endY = cellCoord(hash, origin[1] + delta[1]);
+
+    int32_t stepX = delta[0] > 0.0f ? 1 : (delta[0] < 0.0f ? -1 : 0);
+    int32_t stepY = delta[1] > 0.0f ? 1 : (delta[1] < 0.0f ? -1 : 0);
+
+    float tDeltaX = stepX ? hash->cellSize / fabsf(delta[0]) : FLT_MAX;
+    float tDeltaY = stepY ? hash->cellSize / fabsf(delta[1]) : FLT_MAX;
+
+    float tMaxX = FLT_MAX;
+    float tMaxY = FLT_MAX;
+    if (stepX > 0) tMaxX = ((x + 1) * hash->cellSize - origin[0]) / delta[0];
+    if (stepX < 0) tMaxX = (x * hash->cellSize - origin[0]) / delta[0];
+    if (stepY > 0) tMaxY = ((y + 1) * hash->cellSize - origin[1]) / delta[1];
+    if (stepY < 0) tMaxY = (y * hash->cellSize - origin[1]) / delta[1];
+
+    int32_t cells = abs(endX - x) + abs(endY - y) + 1;
+
+    for (int32_t c = 0; c < cells; c++) {
+        uint32_t b = hashCell(hash, x, y);
+
+        for (uint32_t e = hash->bucketStart[b]; e < hash->bucketStart[b + 1]; e++) {
+            uint32_t other = hash->entries[e];
+
+            if (hash->visitStamp[other] == stamp) continue;
+            hash->visitStamp[other] = stamp;
+
+            float t;
+            if (Rect_raycast(&hash->rects[other], origin, delta, &t)) {
+                pushHit(out, other, t);
+            }
+        }
+
+        if (tMaxX < tMaxY) {
+            x += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+}
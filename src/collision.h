@@ -0,0 +1,97 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "engine.h"
+
+// Two indices that overlap, what they index into depends on the query
+typedef struct {
+    uint32_t a;
+    uint32_t b;
+} CollisionPair_t;
+
+// growable array of pairs, reused between queries so we aren't mallocing every tick
+typedef struct {
+    uint32_t size;
+    uint32_t capacity;
+    CollisionPair_t *ptr;
+} CollisionPairArray_t;
+
+// result of a segment query, t is in [0, 1] along the segment
+typedef struct {
+    uint32_t index;
+    float t;
+} CollisionHit_t;
+
+typedef struct {
+    uint32_t size;
+    uint32_t capacity;
+    CollisionHit_t *ptr;
+} CollisionHitArray_t;
+
+/**
+ * Uniform grid broadphase, cells are hashed into a fixed bucket table
+ * so the world doesn't need bounds. Rebuilt from scratch every tick with a
+ * counting sort, which keeps it linear in the number of boxes.
+ */
+typedef struct {
+    float cellSize;
+    float invCellSize;
+
+    // power of two
+    uint32_t bucketCount;
+    // bucketCount + 1 offsets into entries
+    uint32_t *bucketStart;
+    // box indices, grouped by bucket
+    uint32_t *entries;
+    uint32_t entryCount;
+    uint32_t entryCapacity;
+
+    // copy of the boxes from the last build
+    Rect_t *rects;
+    uint32_t rectCount;
+    uint32_t rectCapacity;
+
+    // used to skip boxes we've already tested during a query
+    uint32_t *visitStamp;
+    uint32_t stamp;
+} SpatialHash_t;
+
+bool Rect_intersects(Rect_t *a, Rect_t *b);
+
+// Moves `moving` by delta against a static target, returns the time of impact in [0, 1]
+// and the surface normal of the target we hit. Already overlapping boxes hit at t = 0.
+bool Rect_sweep(Rect_t *moving, vec2 delta, Rect_t *target, float *hitTime, vec2 normal);
+
+// Segment (origin -> origin + delta) vs box, slab test. Boxes are closed, a segment
+// along an edge hits, and a zero length one hits at t = 0 if it starts inside
+bool Rect_raycast(Rect_t *rect, vec2 origin, vec2 delta, float *hitTime);
+
+// Smallest rect containing both a and b
+void Rect_union(Rect_t *a, Rect_t *b, Rect_t *dest);
+
+void CollisionPairArray_init(CollisionPairArray_t *array, uint32_t capacity);
+
+void CollisionPairArray_free(CollisionPairArray_t *array);
+
+void CollisionHitArray_init(CollisionHitArray_t *array, uint32_t capacity);
+
+void CollisionHitArray_free(CollisionHitArray_t *array);
+
+void SpatialHash_init(SpatialHash_t *hash, float cellSize, uint32_t maxRects);
+
+void SpatialHash_free(SpatialHash_t *hash);
+
+// Replaces the contents of the grid with the given boxes
+void SpatialHash_build(SpatialHash_t *hash, Rect_t *rects, uint32_t count);
+
+// Every overlap between the given boxes and the grid, a = query index, b = grid index
+void SpatialHash_queryRects(SpatialHash_t *hash, Rect_t *rects, uint32_t count, CollisionPairArray_t *out);
+
+// Every box crossed by the segment origin -> origin + delta, not sorted by t
+void SpatialHash_querySegment(SpatialHash_t *hash, vec2 origin, vec2 delta, CollisionHitArray_t *out);
+
+#endif
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "culling.h"
+#include "memory.h"
+
+#include <cglm/simd/intrin.h>
+
+void CullBounds_init(CullBounds_t *bounds, uint32_t capacity) {
+    bounds->count = 0;
+    bounds->capacity = capacity;
+    bounds->minX = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(float));
+    bounds->minY = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(float));
+    bounds->maxX = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(float));
+    bounds->maxY = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(float));
+}
+
+void CullBounds_free(CullBounds_t *bounds) {
+    Memory_free(bounds->minX);
+    Memory_free(bounds->minY);
+    Memory_free(bounds->maxX);
+    Memory_free(bounds->maxY);
+
+    bounds->minX = NULL;
+    bounds->minY = NULL;
+    bounds->maxX = NULL;
+    bounds->maxY = NULL;
+    bounds->count = 0;
+    bounds->capacity = 0;
+}
+
+void CullBounds_clear(CullBounds_t *bounds) {
+    bounds->count = 0;
+}
+
+static void growBounds(CullBounds_t *bounds, uint32_t capacity) {
+    bounds->capacity = capacity;
+    bounds->minX = Memory_realloc(MEMORY_TAG_SCENE, bounds->minX, capacity * sizeof(float));
+    bounds->minY = Memory_realloc(MEMORY_TAG_SCENE, bounds->minY, capacity * sizeof(float));
+    bounds->maxX = Memory_realloc(MEMORY_TAG_SCENE, bounds->maxX, capacity * sizeof(float));
+    bounds->maxY = Memory_realloc(MEMORY_TAG_SCENE, bounds->maxY, capacity * sizeof(float));
+}
+
+uint32_t CullBounds_add(CullBounds_t *bounds, Rect_t *rect) {
+    if (bounds->count == bounds->capacity) {
+        growBounds(bounds, bounds->capacity ? bounds->capacity * 2 : 64);
+    }
+
+    uint32_t index = bounds->count++;
+    CullBounds_set(bounds, index, rect);
+    return index;
+}
+
+void CullBounds_set(CullBounds_t *bounds, uint32_t index, Rect_t *rect) {
+    bounds->minX[index] = rect->pos[0];
+    bounds->minY[index] = rect->pos[1];
+    bounds->maxX[index] = rect->pos[0] + rect->size[0];
+    bounds->maxY[index] = rect->pos[1] + rect->size[1];
+}
+
+// Tests boxes [start, end) against the view, ids maps them back to the caller's indices (or NULL)
+static uint32_t cullRange(CullBounds_t *b, uint32_t start, uint32_t end, Rect_t *view, uint32_t *ids, uint32_t *out) {
+    float viewMinX = view->pos[0];
+    float viewMinY = view->pos[1];
+    float viewMaxX = view->pos[0] + view->size[0];
+    float viewMaxY = view->pos[1] + view->size[1];
+
+    uint32_t visible = 0;
+    uint32_t i = start;
+
+#if defined(CGLM_AVX_FP)
+    __m256 vMinX8 = _mm256_set1_ps(viewMinX);
+    __m256 vMinY8 = _mm256_set1_ps(viewMinY);
+    __m256 vMaxX8 = _mm256_set1_ps(viewMaxX);
+    __m256 vMaxY8 = _mm256_set1_ps(viewMaxY);
+
+    for (; i + 8 <= end; i += 8) {
+        __m256 mask = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b->minX + i), vMaxX8, _CMP_LT_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(b->maxX + i), vMinX8, _CMP_GT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b->minY + i), vMaxY8, _CMP_LT_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(b->maxY + i), vMinY8, _CMP_GT_OQ)));
+
+        uint32_t bits = _mm256_movemask_ps(mask);
+        while (bits) {
+            uint32_t lane = __builtin_ctz(bits);
+            out[visible++] = ids ? ids[i + lane] : i + lane;
+            bits &= bits - 1;
+        }
+    }
+#endif
+
+#if defined(CGLM_SSE2_FP)
+    __m128 vMinX = _mm_set1_ps(viewMinX);
+    __m128 vMinY = _mm_set1_ps(viewMinY);
+    __m128 vMaxX = _mm_set1_ps(viewMaxX);
+    __m128 vMaxY = _mm_set1_ps(viewMaxY);
+
+    for (; i + 4 <= end; i += 4) {
+        __m128 mask = _mm_and_ps(
+            _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(b->minX + i), vMaxX), _mm_cmpgt_ps(_mm_loadu_ps(b->maxX + i), vMinX)),
+            _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(b->minY + i), vMaxY), _mm_cmpgt_ps(_mm_loadu_ps(b->maxY + i), vMinY)));
+
+        uint32_t bits = _mm_movemask_ps(mask);
+        while (bits) {
+            uint32_t lane = __builtin_ctz(bits);
+            out[visible++] = ids ? ids[i + lane] : i + lane;
+            bits &= bits - 1;
+        }
+    }
+#elif defined(CGLM_NEON_FP)
+    float32x4_t vMinX = vdupq_n_f32(viewMinX);
+    float32x4_t vMinY = vdupq_n_f32(viewMinY);
+    float32x4_t vMaxX = vdupq_n_f32(viewMaxX);
+    float32x4_t vMaxY = vdupq_n_f32(viewMaxY);
+
+    for (; i + 4 <= end; i += 4) {
+        uint32x4_t mask = vandq_u32(
+            vandq_u32(vcltq_f32(vld1q_f32(b->minX + i), vMaxX), vcgtq_f32(vld1q_f32(b->maxX + i), vMinX)),
+            vandq_u32(vcltq_f32(vld1q_f32(b->minY + i), vMaxY), vcgtq_f32(vld1q_f32(b->maxY + i), vMinY)));
+
+        uint32_t lanes[4];
+        vst1q_u32(lanes, mask);
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            if (lanes[lane]) out[visible++] = ids ? ids[i + lane] : i + lane;
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        if (b->minX[i] < viewMaxX && b->maxX[i] > viewMinX && b->minY[i] < viewMaxY && b->maxY[i] > viewMinY) {
+            out[visible++] = ids ? ids[i] : i;
+        }
+    }
+
+    return visible;
+}
+
+uint32_t Cull_rects(CullBounds_t *bounds, Rect_t *view, uint32_t *visible, CullStats_t *stats) {
+    uint32_t count = cullRange(bounds, 0, bounds->count, view, NULL, visible);
+
+    if (stats) {
+        stats->visible = count;
+        stats->culled = bounds->count - count;
+    }
+    return count;
+}
+
+void CullGrid_init(CullGrid_t *grid, vec2 origin, float cellSize, uint32_t cellsX, uint32_t cellsY) {
+    glm_vec2_copy(origin, grid->origin);
+    grid->cellSize = cellSize;
+    grid->cellsX = cellsX;
+    grid->cellsY = cellsY;
+    grid->maxExtent = 0.0f;
+
+    uint32_t cellCount = cellsX * cellsY;
+    grid->cellStart = Memory_calloc(MEMORY_TAG_SCENE, cellCount + 1, sizeof(uint32_t));
+    grid->cellBounds = Memory_alloc(MEMORY_TAG_SCENE, cellCount * sizeof(Rect_t));
+
+    CullBounds_init(&grid->sorted, 64);
+    grid->ids = Memory_alloc(MEMORY_TAG_SCENE, 64 * sizeof(uint32_t));
+}
+
+void CullGrid_free(CullGrid_t *grid) {
+    Memory_free(grid->cellStart);
+    Memory_free(grid->cellBounds);
+    Memory_free(grid->ids);
+    CullBounds_free(&grid->sorted);
+
+    grid->cellStart = NULL;
+    grid->cellBounds = NULL;
+    grid->ids = NULL;
+}
+
+static uint32_t clampCell(float v, uint32_t cells) {
+    if (v < 0.0f) return 0;
+    if (v >= (float) cells) return cells - 1;
+    return (uint32_t) v;
+}
+
+static uint32_t cellOf(CullGrid_t *grid, CullBounds_t *b, uint32_t i) {
+    float cx = ((b->minX[i] + b->maxX[i]) * 0.5f - grid->origin[0]) / grid->cellSize;
+    float cy = ((b->minY[i] + b->maxY[i]) * 0.5f - grid->origin[1]) / grid->cellSize;
+    return clampCell(cy, grid->cellsY) * grid->cellsX + clampCell(cx, grid->cellsX);
+}
+
+void CullGrid_build(CullGrid_t *grid, CullBounds_t *bounds) {
+    uint32_t cellCount = grid->cellsX * grid->cellsY;
+    uint32_t *start = grid->cellStart;
+
+    if (bounds->count > grid->sorted.capacity) {
+        growBounds(&grid->sorted, bounds->count);
+        grid->ids = Memory_realloc(MEMORY_TAG_SCENE, grid->ids, bounds->count * sizeof(uint32_t));
+    }
+    grid->sorted.count = bounds->count;
+
+    // counting sort by cell, same trick as the collision spatial hash
+    memset(start, 0, (cellCount + 1) * sizeof(uint32_t));
+    grid->maxExtent = 0.0f;
+    for (uint32_t i = 0; i < bounds->count; i++) {
+        start[cellOf(grid, bounds, i)]++;
+
+        float w = bounds->maxX[i] - bounds->minX[i];
+        float h = bounds->maxY[i] - bounds->minY[i];
+        grid->maxExtent = fmaxf(grid->maxExtent, fmaxf(w, h));
+    }
+    for (uint32_t c = 1; c < cellCount; c++) {
+        start[c] += start[c - 1];
+    }
+    start[cellCount] = bounds->count;
+
+    // empty cells get inverted bounds so they never pass the inside test
+    for (uint32_t c = 0; c < cellCount; c++) {
+        grid->cellBounds[c] = (Rect_t) { { FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX } };
+    }
+
+    for (uint32_t i = 0; i < bounds->count; i++) {
+        uint32_t c = cellOf(grid, bounds, i);
+        uint32_t slot = --start[c];
+
+        grid->sorted.minX[slot] = bounds->minX[i];
+        grid->sorted.minY[slot] = bounds->minY[i];
+        grid->sorted.maxX[slot] = bounds->maxX[i];
+        grid->sorted.maxY[slot] = bounds->maxY[i];
+        grid->ids[slot] = i;
+
+        // cellBounds is stored as min/max here and converted below
+        Rect_t *cb = &grid->cellBounds[c];
+        cb->pos[0] = fminf(cb->pos[0], bounds->minX[i]);
+        cb->pos[1] = fminf(cb->pos[1], bounds->minY[i]);
+        cb->size[0] = fmaxf(cb->size[0], bounds->maxX[i]);
+        cb->size[1] = fmaxf(cb->size[1], bounds->maxY[i]);
+    }
+
+    for (uint32_t c = 0; c < cellCount; c++) {
+        Rect_t *cb = &grid->cellBounds[c];
+        cb->size[0] -= cb->pos[0];
+        cb->size[1] -= cb->pos[1];
+    }
+}
+
+uint32_t CullGrid_query(CullGrid_t *grid, Rect_t *view, uint32_t *visible, CullStats_t *stats) {
+    // boxes are binned by center, so widen the search by the biggest box
+    float pad = grid->maxExtent * 0.5f;
+    uint32_t x0 = clampCell((view->pos[0] - pad - grid->origin[0]) / grid->cellSize, grid->cellsX);
+    uint32_t y0 = clampCell((view->pos[1] - pad - grid->origin[1]) / grid->cellSize, grid->cellsY);
+    uint32_t x1 = clampCell((view->pos[0] + view->size[0] + pad - grid->origin[0]) / grid->cellSize, grid->cellsX);
+    uint32_t y1 = clampCell((view->pos[1] + view->size[1] + pad - grid->origin[1]) / grid->cellSize, grid->cellsY);
+
+    float viewMaxX = view->pos[0] + view->size[0];
+    float viewMaxY = view->pos[1] + view->size[1];
+
+    uint32_t count = 0;
+    for (uint32_t y = y0; y <= y1; y++) {
+        for (uint32_t x = x0; x <= x1; x++) {
+            uint32_t c = y * grid->cellsX + x;
+            uint32_t start = grid->cellStart[c];
+            uint32_t end = grid->cellStart[c + 1];
+            if (start == end) continue;
+
+            Rect_t *cb = &grid->cellBounds[c];
+            bool overlaps = cb->pos[0] < viewMaxX && cb->pos[0] + cb->size[0] > view->pos[0]
+                         && cb->pos[1] < viewMaxY && cb->pos[1] + cb->size[1] > view->pos[1];
+            if (!overlaps) continue;
+
+            bool inside = cb->pos[0] > view->pos[0] && cb->pos[0] + cb->size[0] < viewMaxX
+                       && cb->pos[1] > view->pos[1] && cb->pos[1] + cb->size[1] < viewMaxY;
+
+            if (inside) {
+                // whole cell is on screen, no need to test its boxes
+                for (uint32_t i = start; i < end; i++) {
+                    visible[count++] = grid->ids[i];
+                }
+            } else {
+                count += cullRange(&grid->sorted, start, end, view, grid->ids, visible + count);
+            }
+        }
+    }
+
+    if (stats) {
+        stats->visible = count;
+        stats->culled = grid->sorted.count - count;
+    }
+    return count;
+}
@@ -0,0 +1,73 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "engine.h"
+
+// Bounds stored as separate arrays (SoA) so we can test 4-8 boxes per instruction
+typedef struct {
+    float *minX;
+    float *minY;
+    float *maxX;
+    float *maxY;
+
+    uint32_t count;
+    uint32_t capacity;
+} CullBounds_t;
+
+typedef struct {
+    uint32_t visible;
+    uint32_t culled;
+} CullStats_t;
+
+/**
+ * Coarse uniform grid over a level for when there are too many boxes to test every frame.
+ * Boxes are sorted into cells by their center, each cell keeps the union of its boxes,
+ * so cells fully on screen are accepted whole and cells off screen are never touched.
+ * The origin can be moved between builds, eg. to follow a level that scrolls.
+ */
+typedef struct {
+    vec2 origin;
+    float cellSize;
+    uint32_t cellsX;
+    uint32_t cellsY;
+
+    // cellsX * cellsY + 1 offsets into sorted
+    uint32_t *cellStart;
+    Rect_t *cellBounds;
+
+    // the boxes in cell order, and their original indices
+    CullBounds_t sorted;
+    uint32_t *ids;
+
+    // biggest box size, so we can catch boxes hanging over from neighbouring cells
+    float maxExtent;
+} CullGrid_t;
+
+void CullBounds_init(CullBounds_t *bounds, uint32_t capacity);
+
+void CullBounds_free(CullBounds_t *bounds);
+
+void CullBounds_clear(CullBounds_t *bounds);
+
+// Appends a box and returns its index
+uint32_t CullBounds_add(CullBounds_t *bounds, Rect_t *rect);
+
+void CullBounds_set(CullBounds_t *bounds, uint32_t index, Rect_t *rect);
+
+// Writes the indices of every box overlapping view to visible, returns how many there were
+uint32_t Cull_rects(CullBounds_t *bounds, Rect_t *view, uint32_t *visible, CullStats_t *stats);
+
+void CullGrid_init(CullGrid_t *grid, vec2 origin, float cellSize, uint32_t cellsX, uint32_t cellsY);
+
+void CullGrid_free(CullGrid_t *grid);
+
+// Sorts the boxes into the grid, boxes outside the grid go into the border cells
+void CullGrid_build(CullGrid_t *grid, CullBounds_t *bounds);
+
+// Same as Cull_rects but only looks at cells near the view, indices refer to the bounds given to CullGrid_build
+uint32_t CullGrid_query(CullGrid_t *grid, Rect_t *view, uint32_t *visible, CullStats_t *stats);
+
+#endif
@@ -4,7 +4,11 @@
 #include <cglm/vec2.h>
 
 typedef struct {
-    void (*init)(void);
+    // optional, runs on the loader thread with a shared GL context. Anything heavy goes here:
+    // file io, decoding, buffers, textures and shaders. Can't create VAOs/FBOs, those aren't shared
+    void (*preload)(void);
+    // runs on the main thread once preload is done, right before the scene becomes current
+    void (*activate)(void);
     void (*tick)(void);
     void (*render)(void);
     void (*exit)(void);
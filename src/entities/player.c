@@ -1,60 +1,75 @@
 #include "player.h"
 
 #include "../util.h"
+#include "../physics.h"
+#include "../memory.h"
 
 
 #define GRAVITY_ACCEL 9.81f
+#define MAX_VELOCITY 25.0f
 
 VertexBuffer_t *vb;
 IndexBuffer_t *ib;
 Renderer_t *playerRenderer;
 
+// the player's world transform, drawn as a single instance
+TransformSystem_t playerTransform;
+uint32_t playerNode;
+VertexBuffer_t *playerInstanceVb;
+
 GameObj_t *gameObj;
 
+// gravity only pulls us down until we hit -GRAVITY_ACCEL
+const PhysicsParams_t playerPhysics = {
+    .gravity = { 0.0f, -GRAVITY_ACCEL / (TARGET_TPS / 2) },
+    .terminalVelocity = { GRAVITY_ACCEL, GRAVITY_ACCEL },
+    .maxVelocity = { MAX_VELOCITY, MAX_VELOCITY }
+};
+
 void Player_init(GameObj_t *gameObjIn) {
     gameObj = gameObjIn;
 
-    vb = malloc(sizeof(VertexBuffer_t));
-    ib = malloc(sizeof(IndexBuffer_t));
-    size_t vSize = VertexFormat_sizeOf(VERTEX_FORMAT_PC);
-    Vertex_PC verticies[] = {
-        (Vertex_PC) { { -20.0f, -20.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f} },
-        (Vertex_PC) { { 0.0f, 25.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } }, 
-        (Vertex_PC) { { 20.0f, -20.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } }
+    vb = Memory_alloc(MEMORY_TAG_ENTITY, sizeof(VertexBuffer_t));
+    ib = Memory_alloc(MEMORY_TAG_ENTITY, sizeof(IndexBuffer_t));
+    size_t vSize = VertexFormat_sizeOf(VERTEX_FORMAT_S16C8);
+    Vertex_S16C8 verticies[] = {
+        (Vertex_S16C8) { { -20, -20 }, { 255, 0, 0, 255 } },
+        (Vertex_S16C8) { { 0, 25 }, { 255, 0, 0, 255 } },
+        (Vertex_S16C8) { { 20, -20 }, { 255, 0, 0, 255 } }
     };
 
     VertexBuffer_init(vb, vSize, 3, 3 * vSize, GL_STATIC_DRAW, verticies);
     uint32_t indicies[] = { 0, 1, 2 };
-    IndexBuffer_init(ib, 3, sizeof(indicies), indicies);
+    IndexBuffer_initCompact(ib, 3, indicies);
+
+    playerRenderer = Memory_alloc(MEMORY_TAG_ENTITY, sizeof(Renderer_t));
+    Renderer_init(playerRenderer, context, VERTEX_FORMAT_S16C8, vb, ib);
 
-    playerRenderer = malloc(sizeof(Renderer_t));
-    Renderer_init(playerRenderer, context, VERTEX_FORMAT_PC, vb, ib);
+    TransformSystem_init(&playerTransform, 1);
+    playerNode = TransformSystem_create(&playerTransform, TRANSFORM_NO_PARENT);
+
+    playerInstanceVb = Memory_alloc(MEMORY_TAG_ENTITY, sizeof(VertexBuffer_t));
+    VertexBuffer_init(playerInstanceVb, sizeof(Affine2D_t), 1, sizeof(Affine2D_t), GL_STREAM_DRAW, NULL);
+    Renderer_setInstanceBuffer(playerRenderer, playerInstanceVb);
 }
 
 void Player_reset() {
     glm_vec2_copy(GLM_VEC2_ZERO, gameObj->pos);
+    glm_vec2_copy(GLM_VEC2_ZERO, gameObj->prevPos);
+    glm_vec2_copy(GLM_VEC2_ZERO, gameObj->velocity);
 }
 
 // we will store our player's previous velocity so the jump upwards is *somewhat* smooth
 float prevYVel = 0.0f;
 
 void Player_tick() {
-    // apply gravity
     prevYVel = gameObj->velocity[1];
-    if (gameObj->velocity[1] > -GRAVITY_ACCEL) {
-        glm_vec2_add((vec2) { 0.f, -GRAVITY_ACCEL / (TARGET_TPS / 2) }, gameObj->velocity, gameObj->velocity);
-    }
-
-    float newX = gameObj->pos[0] + gameObj->velocity[0];
-    float newY = gameObj->pos[1] + gameObj->velocity[1];
-    glm_vec2_copy(gameObj->pos, gameObj->prevPos);
-    glm_vec2_copy((vec2) { newX, newY }, gameObj->pos);
+    // apply gravity & move
+    Physics_integrate(gameObj, 1, &playerPhysics);
 }
 
 
 void Player_render() {
-    MatrixStack_pushMatrix(context->matrixStack);
-
     float renderX = DW_lerp(gameObj->prevPos[0], gameObj->pos[0], context->partialTicks);
     float renderY = DW_lerp(gameObj->prevPos[1], gameObj->pos[1], context->partialTicks);
 
@@ -65,19 +80,20 @@ void Player_render() {
     float angleAdd = fmax(fmin(yVel * 5.0f, 90.0f), -90.0f);
     angle += (angleAdd * (M_PI / 180));
 
-    MatrixStack_translate(context->matrixStack, (vec3) { renderX, renderY, 0.0f });
-    MatrixStack_rotate(context->matrixStack, angle, (vec3) { 0.0f, 0.0f, 1.0f });
-    MatrixStack_translate(context->matrixStack, (vec3) { -renderX, -renderY, 0.0f });
-
+    // rotate around our own position
+    Transform_setPosition(&playerTransform, playerNode, (vec2) { renderX, renderY });
+    Transform_setRotation(&playerTransform, playerNode, angle);
+    if (TransformSystem_update(&playerTransform) > 0) {
+        VertexBuffer_update(playerInstanceVb, 1, sizeof(Affine2D_t), TransformSystem_getPacked(&playerTransform, playerNode));
+    }
 
-    MatrixStack_translate(context->matrixStack, (vec3) { renderX, renderY, 0.0f });
     Renderer_bind(playerRenderer);
-    Renderer_draw(playerRenderer);
-    
-    MatrixStack_popMatrix(context->matrixStack);
+    Renderer_drawInstanced(playerRenderer, 1);
 }
 
 void Player_kill() {
+    TransformSystem_free(&playerTransform);
+    VertexBuffer_free(playerInstanceVb);
     Renderer_free(playerRenderer);
     IndexBuffer_free(ib);
     VertexBuffer_free(vb);
@@ -4,6 +4,10 @@
 #include "renderer.h"
 #include "font.h"
 #include "util.h"
+#include "jobs.h"
+#include "archive.h"
+#include "trace.h"
+#include "memory.h"
 
 
 typedef struct Block {
@@ -62,10 +66,10 @@ char* parse_string(const uint8_t *buf, size_t bufSize, size_t strSize) {
         return NULL;
     }
 
-    char* str = malloc(sizeof(char) * strSize);
+    char* str = Memory_alloc(MEMORY_TAG_FONT, sizeof(char) * strSize);
 
     int len = 0;
-    while (len <= bufSize && len < strSize && (buf[len] != '\0' || buf[len] != EOF)) {
+    while (len < bufSize && len < strSize && buf[len] != '\0') {
         str[len] = buf[len];
         len++;
         
@@ -75,7 +79,7 @@ char* parse_string(const uint8_t *buf, size_t bufSize, size_t strSize) {
     str[len++] = '\0';
 
     // reallocate string to trim the fat
-    return realloc(str, len);
+    return Memory_realloc(MEMORY_TAG_FONT, str, len);
 }
 
 Block_t parse_Block(const uint8_t *buf, size_t bufSize) {
@@ -133,18 +137,31 @@ CharData_t parse_CharData(uint8_t *buf, size_t bufSize, uint32_t texW, uint32_t
     return charData;
 }
 
-void read_bytes(uint8_t *buf, FILE *file, size_t amount) {
-    if (fread(buf, sizeof(uint8_t), amount, file) != amount) {
+// cursor over the font file, which is loaded in one go
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} ByteReader_t;
+
+// Returns a pointer to the next amount bytes and moves past them, NULL if there aren't that many left
+const uint8_t* read_bytes(ByteReader_t *reader, size_t amount) {
+    if (amount > reader->size - reader->pos) {
         fprintf(stderr, "Error: byte index out of range.\n");
-        return;
+        reader->pos = reader->size;
+        return NULL;
     }
+
+    const uint8_t *bytes = reader->data + reader->pos;
+    reader->pos += amount;
+    return bytes;
 }
 
-int read_Header(uint8_t *buf, FILE *file, FontData_t *fontData) {
+int read_Header(ByteReader_t *reader, FontData_t *fontData) {
 // Check file header
-    read_bytes(buf, file, 4);
+    const uint8_t *buf = read_bytes(reader, 4);
 
-    if (buf[0] != 'B' || buf[1] != 'M' || buf[2] != 'F') {
+    if (buf == NULL || buf[0] != 'B' || buf[1] != 'M' || buf[2] != 'F') {
         fprintf(stderr, "Error: Font data file does not contain BMF header.\n");
         return 0;
     }
@@ -159,73 +176,110 @@ int read_Header(uint8_t *buf, FILE *file, FontData_t *fontData) {
     return 1;
 }
 
+// Reads a block's type and size header, a zeroed block if the file ends early
+Block_t read_Block(ByteReader_t *reader) {
+    const uint8_t *buf = read_bytes(reader, 5);
+    if (buf == NULL) return (Block_t) { 0, 0 };
+    return parse_Block(buf, 5);
+}
+
+typedef struct {
+    const char *path;
+    Image_t image;
+} FontImageJob_t;
+
+void FontRenderer_decodeAtlas(void *data) {
+    FontImageJob_t *job = data;
+    DW_loadImage(&job->image, job->path);
+}
+
 // reads the binary font data file as defined in:
 // https://www.angelcode.com/products/bmfont/doc/file_format.html#bin
 void FontRenderer_loadData(char* fontPath, FontData_t *fontData) {
-    FILE *filePtr = fopen(fontPath, "rb");
-    uint8_t buf[128];
-    size_t bufSize = (sizeof(buf) / sizeof(uint8_t));
-
-    if (filePtr == NULL) {
+    // the whole file at once, straight out of the asset pack when there is one
+    Asset_t asset;
+    if (!Asset_load(&asset, fontPath)) {
         fprintf(stderr, "Error: loading font file: %s\n", fontPath);
         return;
     }
+    ByteReader_t reader = { asset.data, asset.size, 0 };
 
-    if (!read_Header(buf, filePtr, fontData)) return;
-
-    // Read & cache block types
-    read_bytes(buf, filePtr, 5);
+    if (!read_Header(&reader, fontData)) {
+        Asset_free(&asset);
+        return;
+    }
 
     // Read only the font name from block 1
-
-    Block_t block1 = parse_Block(buf, bufSize);
+    Block_t block1 = read_Block(&reader);
     // fontName is 14 bytes ahead
-    fseek(filePtr, 14, SEEK_CUR);
+    read_bytes(&reader, 14);
     uint32_t strLen = block1.size - 14;
-    read_bytes(buf, filePtr, strLen);
-    fontData->fontName = parse_string(buf, bufSize, strLen);
+    const uint8_t *nameBytes = read_bytes(&reader, strLen);
+    fontData->fontName = nameBytes ? parse_string(nameBytes, strLen, strLen) : Memory_strdup(MEMORY_TAG_FONT, "");
     fontData->nameLen = strlen(fontData->fontName);
 
-
     // skip over block 2
-    read_bytes(buf, filePtr, 5);
-    fseek(filePtr, parse_Block(buf, bufSize).size, SEEK_CUR);
+    read_bytes(&reader, read_Block(&reader).size);
 
     // read block 3 to get our texture
-    read_bytes(buf, filePtr, 5);
-    Block_t block3 = parse_Block(buf, bufSize);
+    Block_t block3 = read_Block(&reader);
     
     // read texture file name
-    read_bytes(buf, filePtr, block3.size);
-    char* texName = parse_string(buf, bufSize, block3.size);
+    const uint8_t *texBytes = read_bytes(&reader, block3.size);
+    char* texName = texBytes ? parse_string(texBytes, block3.size, block3.size) : Memory_strdup(MEMORY_TAG_FONT, "");
+
+    // texture names are relative to the assets folder
+    char texPath[256];
+    snprintf(texPath, sizeof(texPath), "assets/%s", texName);
 
-    // open file and parse image using stb_image.h
-    char texPath[128] = "assets/";
-    strcat(texPath, texName);
+    // texconv'd atlas next to the png, it uploads straight out of the file with nothing to decode
+    char *ext = strrchr(texName, '.');
+    int baseLen = ext != NULL ? (int) (ext - texName) : (int) strlen(texName);
+    char dwtxPath[256];
+    snprintf(dwtxPath, sizeof(dwtxPath), "assets/%.*s.dwtx", baseLen, texName);
+    Memory_free(texName);
 
-    fontData->fontAtlas = DW_loadTexture(texPath);
+    Trace_begin("font atlas upload");
+    bool hasDwtx = Asset_exists(dwtxPath) && DW_loadTextureFile(&fontData->fontAtlas, dwtxPath);
+    Trace_end();
+
+    // otherwise decode the png on a worker while we read the rest of the file
+    FontImageJob_t imageJob = { .path = texPath };
+    JobCounter_t imageCounter = { 0 };
+    if (!hasDwtx) JobSystem_run(FontRenderer_decodeAtlas, &imageJob, &imageCounter);
 
     // load char data from block 4
-    read_bytes(buf, filePtr, 5);
-    Block_t block4 = parse_Block(buf, bufSize);
+    Block_t block4 = read_Block(&reader);
     
     // we know each unit of chardata is 20 bytes
     // So we can find how many chars we have
     size_t charCount = block4.size / 20;
+    const uint8_t *charBuf = read_bytes(&reader, charCount * 20);
+    if (charBuf == NULL) charCount = 0;
+
     fontData->charCount = charCount;
-    fontData->charData = (CharData_t*) malloc(charCount * sizeof(CharData_t));
+    fontData->charData = (CharData_t*) Memory_alloc(MEMORY_TAG_FONT, charCount * sizeof(CharData_t));
+
+    // charData requires texture size for calculating UV coordinates
+    if (!hasDwtx) {
+        Trace_begin("font atlas decode");
+        JobSystem_wait(&imageCounter);
+        Trace_end();
+        Trace_begin("font atlas upload");
+        fontData->fontAtlas = DW_createTexture(&imageJob.image);
+        Trace_end();
+        DW_freeImage(&imageJob.image);
+    }
 
-    // read every char
+    // parse every char
     for (int i = 0; i < charCount; i++) {
-        read_bytes(buf, filePtr, 20);
-        // charData requires texture size for calculating UV coordinates
-        CharData_t charData = parse_CharData(buf, bufSize, fontData->fontAtlas.width, fontData->fontAtlas.height);
+        CharData_t charData = parse_CharData((uint8_t*) charBuf + (i * 20), 20, fontData->fontAtlas.width, fontData->fontAtlas.height);
         fontData->charData[i] = charData;
     }
 
-    fclose(filePtr);
+    Asset_free(&asset);
 
-    printf("Loaded bitmap font: %s @ %s\n", fontData->fontName, texPath);
+    printf("Loaded bitmap font: %s @ %s\n", fontData->fontName, hasDwtx ? dwtxPath : texPath);
 }
 
 // Puts the data relative to the font atlas into the glyph instance. position is set later when rendering.
@@ -255,14 +309,16 @@ void FontRenderer_init(FontRenderer_t *font, Context_t *context, char* fontPath,
     font->context = context;
     font->scaleFactor = scaleFactor;
     // load chars and font data
-    font->fontData = (FontData_t*) malloc(sizeof(FontData_t));
+    font->fontData = (FontData_t*) Memory_alloc(MEMORY_TAG_FONT, sizeof(FontData_t));
+    Trace_begin("FontRenderer_loadData");
     FontRenderer_loadData(fontPath, font->fontData);
+    Trace_end();
     font->charHeight = font->fontData->charData[0].height * scaleFactor;
 
     // Create glyph instance data
     size_t instanceSize = sizeof(GlyphInstance_t);
     font->instanceDataSize = instanceSize * font->fontData->charCount;
-    font->instanceData = malloc(font->instanceDataSize);
+    font->instanceData = Memory_alloc(MEMORY_TAG_FONT, font->instanceDataSize);
 
     for (size_t i = 0; i < font->fontData->charCount; i++) {
         font->instanceData[i] = CharData_genGlyphInstance(font->fontData, i, scaleFactor);
@@ -271,105 +327,37 @@ void FontRenderer_init(FontRenderer_t *font, Context_t *context, char* fontPath,
     // our default render color is white
     glm_vec4_copy((vec4) { 1.0f, 1.0f, 1.0f, 1.0f }, font->color);
 
-    // create render pipeline
-    font->shader = Shader_createProgram(DW_loadSourceFile("assets/font.vs.glsl"), DW_loadSourceFile("assets/font.fs.glsl"));
-
-    // setup our vao
-    glGenVertexArrays(1, &font->vao);
-    glBindVertexArray(font->vao);
-
-    uint32_t indicies[] = {
-        0, 1, 2, 0, 2, 3
-    };
-
-    font->ib = malloc(sizeof(IndexBuffer_t));
-    IndexBuffer_init(font->ib, 6, sizeof(indicies), indicies);
-
-
-    // setup usual vertex attributes
-    Vertex_PT verticies[] = {
-        { { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } },
-        { { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f } },
-        { { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f } },
-        { { 1.0f, 1.0f, 0.0f }, { 1.0f, 0.0f } }
-    };
-
-    font->vb = malloc(sizeof(VertexBuffer_t));
-    VertexBuffer_init(font->vb, sizeof(Vertex_PT), 4, sizeof(verticies), GL_STATIC_DRAW, verticies);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex_PT), (void*) 0);
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex_PT), (void*) offsetof(Vertex_PT, uv));
-
-    // Setup instance buffer attributes
-    font->instanceVb = malloc(sizeof(VertexBuffer_t));
-    VertexBuffer_init(font->instanceVb, instanceSize, 0, 0, GL_STREAM_DRAW, NULL);
-
-    // instance position
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, instanceSize, (void*) NULL);
-    glVertexAttribDivisor(2, 1);
-    // instance size
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, instanceSize, (void*) offsetof(GlyphInstance_t, size));
-    glVertexAttribDivisor(3, 1);
-
-    // uv
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, instanceSize, (void*) offsetof(GlyphInstance_t, uv));
-    glVertexAttribDivisor(4, 1);
-
-    // uv size
-    glEnableVertexAttribArray(5);
-    glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, instanceSize, (void*) offsetof(GlyphInstance_t, uvSize));
-    glVertexAttribDivisor(5, 1);
-
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    // every glyph is one sprite, the quad comes out of the vertex shader
+    SpriteBatch_init(&font->sprites, context);
 }
 
 void FontRenderer_setColor(FontRenderer_t *font, vec4 color) {
     glm_vec4_copy(color, font->color);
 }
 
-void FontRenderer_bind(FontRenderer_t *font) {
-    glUseProgram(font->shader);
-    glBindVertexArray(font->vao);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, font->ib->ibo);
-}
-
 void FontData_free(FontData_t *fontData) {
-    free(fontData->charData);
+    Memory_free(fontData->charData);
     fontData->charData = NULL;
 
-    free(fontData->fontName);
+    Memory_free(fontData->fontName);
     fontData->fontName = NULL;
 
-    free(fontData);
+    Memory_free(fontData);
     fontData = NULL;
 }
 
 void FontRenderer_free(FontRenderer_t *font) {
-    // Renderer_free(font->renderer);    
+    DW_freeTexture(&font->fontData->fontAtlas);
     FontData_free(font->fontData);
-    glDeleteVertexArrays(1, &font->vao);
-    IndexBuffer_free(font->ib);
-    VertexBuffer_free(font->vb);
-    free(font->instanceData);
-    free(font);
+    SpriteBatch_free(&font->sprites);
+    Memory_free(font->instanceData);
+    Memory_free(font);
 }
 
 void FontRenderer_drawString(FontRenderer_t *font, char *text, float renderX, float renderY) {
-    FontRenderer_bind(font);
-
     size_t charCount = strlen(text);
-    GlyphInstance_t bufData[charCount];
-    size_t bufSize = sizeof(bufData);
-    // setup instance buffer data
+    Sprite_t *sprites = SpriteBatch_reserve(&font->sprites, charCount);
+
     float cursorAdvance = 0.0f;
     for (int i = 0; i < charCount; i++) {
 
@@ -378,29 +366,19 @@ void FontRenderer_drawString(FontRenderer_t *font, char *text, float renderX, fl
             c = '?';
         }
 
-        int inst = (int) c - GLYPH_FIRST;
-        // printf("getting instance data index %u for char %c (%u)\n", inst, c, c);
-        bufData[i] = font->instanceData[inst];
-        bufData[i].pos[0] = renderX + cursorAdvance;
-        bufData[i].pos[1] = renderY;
-        cursorAdvance += bufData[i].advance;
+        GlyphInstance_t *glyph = &font->instanceData[(int) c - GLYPH_FIRST];
+        sprites[i] = (Sprite_t) {
+            .pos = { renderX + cursorAdvance, renderY },
+            .size = { glyph->size[0], glyph->size[1] },
+            .uvRect = { glyph->uv[0], glyph->uv[1], glyph->uvSize[0], glyph->uvSize[1] },
+            // white, the font's colour goes in as the tint
+            .color = 0xffffffff
+        };
+        cursorAdvance += glyph->advance;
     }
-    // pass buffer data
-    glBindBuffer(GL_ARRAY_BUFFER, font->instanceVb->vbo);
-    glBufferData(GL_ARRAY_BUFFER, bufSize, bufData, GL_STREAM_DRAW);
-
-
-    // pass matricies
-    glUniform1i(glGetUniformLocation(font->shader, "textureIn"), 0);
-    glUniform4f(glGetUniformLocation(font->shader, "colorIn"), font->color[0], font->color[1], font->color[2], font->color[3]);
-    glUniformMatrix4fv(glGetUniformLocation(font->shader, "projection"), 1, GL_FALSE, (float*) &font->context->projectionMatrix);
-    glUniformMatrix4fv(glGetUniformLocation(font->shader, "model"), 1, GL_FALSE, (float*) MatrixStack_peek(font->context->matrixStack));
-
-    // bind textures
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, font->fontData->fontAtlas.texId);
 
-    glDrawElementsInstanced(GL_TRIANGLES, font->ib->indexCount, GL_UNSIGNED_INT, NULL, charCount);
+    SpriteBatch_setTint(&font->sprites, font->color);
+    SpriteBatch_flush(&font->sprites, font->fontData->fontAtlas.texId);
 }
 
 size_t FontRenderer_getStringWidth(FontRenderer_t *font, char *text) {
@@ -2,6 +2,7 @@
 #define FONT_H
 
 #include "renderer.h"
+#include "sprites.h"
 
 // We only support standard ASCII glyphs, no unicode
 #define GLYPH_FIRST 32
@@ -34,10 +35,8 @@ typedef struct FontData {
 } FontData_t;
 
 
-// intermediary struct for data that will be passed to the instancing VBO
+// what each glyph looks like, drawing a string copies these into sprites
 typedef struct GlyphInstance {
-    // position of the instanced glyph
-    vec2 pos;
     // actual size of glyph
     vec2 size;
     // top left of UV space for glyph
@@ -49,9 +48,9 @@ typedef struct GlyphInstance {
 } GlyphInstance_t;
 
 // This is a different type of renderer,
-// unlike Renderer_t, we will use instancing to
-// draw chars for better performance, since our data will
-// never change, just the positions and uvs being drawn
+// unlike Renderer_t, every char is one sprite in a
+// SpriteBatch_t and a whole string is one draw, since our
+// glyph data never changes, just the positions being drawn
 typedef struct FontRenderer {
     // null terminated string
     char *fontPath;
@@ -60,12 +59,8 @@ typedef struct FontRenderer {
     // pointer to our rendering context, there is usually only 1 of these
     Context_t *context;
 
-    // renderer variables
-    GLuint vao;
-    VertexBuffer_t *vb;
-    VertexBuffer_t *instanceVb;
-    IndexBuffer_t *ib;
-    GLuint shader;
+    // glyphs of the string being drawn
+    SpriteBatch_t sprites;
 
     // value to scale up or down our quads
     float scaleFactor;
@@ -82,8 +77,6 @@ void FontRenderer_init(FontRenderer_t *font, Context_t *context, char* fontPath,
 
 void FontRenderer_setColor(FontRenderer_t *font, vec4 color);
 
-void FontRenderer_bind(FontRenderer_t *font);
-
 void FontRenderer_free(FontRenderer_t *font);
 
 void FontRenderer_drawString(FontRenderer_t *font, char *text, float renderX, float renderY);
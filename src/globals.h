@@ -3,6 +3,7 @@
 
 #include "input.h"
 #include "font.h"
+#include "lines.h"
 #include "engine.h"
 
 #define DISPLAY_WIDTH 1280
@@ -29,6 +30,7 @@ Input_t *input;
 Context_t *context;
 Renderer_t *dynRenderer;
 FontRenderer_t *fontRenderer;
+LineRenderer_t *lineRenderer;
 Scene_t *currentScene;
 
 #else
@@ -39,6 +41,7 @@ extern Input_t *input;
 extern Context_t *context;
 extern Renderer_t *dynRenderer;
 extern FontRenderer_t *fontRenderer;
+extern LineRenderer_t *lineRenderer;
 extern Scene_t *currentScene;
 #endif
 
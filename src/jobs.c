@@ -0,0 +1,427 @@
+#include "jobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define CACHE_LINE 64
+
+/**
+ * Chase-Lev work stealing deque, see "Correct and Efficient Work-Stealing for
+ * Weak Memory Models" (Le et al. 2013). The owning thread pushes and pops at the
+ * bottom, everyone else steals from the top.
+ */
+typedef struct {
+    int64_t top __attribute__((aligned(CACHE_LINE)));
+    int64_t bottom __attribute__((aligned(CACHE_LINE)));
+    Job_t *jobs[JOB_QUEUE_SIZE] __attribute__((aligned(CACHE_LINE)));
+} JobDeque_t;
+
+typedef struct {
+    JobDeque_t deque;
+    // ring of job storage, only touched by the owning thread
+    Job_t jobPool[JOB_QUEUE_SIZE];
+    uint32_t nextJob;
+    // used to pick steal victims
+    uint32_t rngState;
+    pthread_t thread;
+} JobThread_t;
+
+JobThread_t *jobThreads_m = NULL;
+uint32_t jobThreadCount_m = 0;
+
+bool jobsRunning_m = false;
+// jobs sitting in a deque, workers sleep when this is zero
+int32_t jobsPending_m = 0;
+int32_t jobsSleeping_m = 0;
+pthread_mutex_t jobsSleepMutex_m = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t jobsSleepCond_m = PTHREAD_COND_INITIALIZER;
+
+__thread int32_t jobThreadIndex_m = -1;
+
+static bool JobDeque_push(JobDeque_t *q, Job_t *job) {
+    int64_t b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= JOB_QUEUE_SIZE) return false;
+
+    __atomic_store_n(&q->jobs[b & (JOB_QUEUE_SIZE - 1)], job, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static Job_t* JobDeque_pop(JobDeque_t *q) {
+    int64_t b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        // empty
+        __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    Job_t *job = __atomic_load_n(&q->jobs[b & (JOB_QUEUE_SIZE - 1)], __ATOMIC_RELAXED);
+    if (t == b) {
+        // last job, race the thieves for it
+        if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            job = NULL;
+        }
+        __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+static Job_t* JobDeque_steal(JobDeque_t *q) {
+    int64_t t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b) return NULL;
+
+    Job_t *job = __atomic_load_n(&q->jobs[t & (JOB_QUEUE_SIZE - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&q->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return job;
+}
+
+static void spinLock(int32_t *lock) {
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED)) sched_yield();
+    }
+}
+
+static void spinUnlock(int32_t *lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+static void wakeWorkers() {
+    if (__atomic_load_n(&jobsSleeping_m, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&jobsSleepMutex_m);
+        pthread_cond_broadcast(&jobsSleepCond_m);
+        pthread_mutex_unlock(&jobsSleepMutex_m);
+    }
+}
+
+static void executeJob(Job_t *job);
+
+// Hands a job to the calling thread's deque, runs it inline if we can't queue it
+static void submitJob(Job_t *job) {
+    int32_t index = jobThreadIndex_m;
+
+    if (index < 0 || !JobDeque_push(&jobThreads_m[index].deque, job)) {
+        executeJob(job);
+        return;
+    }
+
+    __atomic_add_fetch(&jobsPending_m, 1, __ATOMIC_SEQ_CST);
+    wakeWorkers();
+}
+
+// Marks a job as done, anything parked on its counter gets queued once it hits zero
+static void finishJob(JobCounter_t *counter) {
+    if (counter == NULL) return;
+
+    // under the lock, so a runAfter can't park on the counter between it reaching
+    // zero and us taking the list, and then get released along with the old waiters
+    spinLock(&counter->lock);
+    Job_t *waiting = NULL;
+    if (__atomic_sub_fetch(&counter->value, 1, __ATOMIC_ACQ_REL) == 0) {
+        waiting = counter->waiting;
+        counter->waiting = NULL;
+    }
+    spinUnlock(&counter->lock);
+
+    while (waiting != NULL) {
+        Job_t *next = waiting->next;
+        submitJob(waiting);
+        waiting = next;
+    }
+}
+
+// The last finishJob drops value to zero while it still holds the lock, so wait
+// for that unlock before telling the caller it can free or reuse the counter
+static void settleCounter(JobCounter_t *counter) {
+    spinLock(&counter->lock);
+    spinUnlock(&counter->lock);
+}
+
+static void executeJob(Job_t *job) {
+    if (job->rangeFunc != NULL) {
+        job->rangeFunc(job->data, job->start, job->end);
+    } else {
+        job->func(job->data);
+    }
+
+    JobCounter_t *counter = job->counter;
+    __atomic_store_n(&job->inUse, 0, __ATOMIC_RELEASE);
+    finishJob(counter);
+}
+
+// Grabs the next slot in the calling thread's job ring. Returns NULL when that slot
+// is still busy (deeply nested waits can have a lot in flight) or the caller isn't
+// one of our threads, in which case the job just runs inline.
+static Job_t* allocJob(int32_t index) {
+    if (index < 0) return NULL;
+
+    JobThread_t *thread = &jobThreads_m[index];
+    Job_t *job = &thread->jobPool[thread->nextJob & (JOB_QUEUE_SIZE - 1)];
+    if (__atomic_load_n(&job->inUse, __ATOMIC_ACQUIRE)) return NULL;
+
+    thread->nextJob++;
+    memset(job, 0, sizeof(Job_t));
+    job->inUse = 1;
+    return job;
+}
+
+// Our own deque first, then try stealing from everyone else starting at a random thread
+static Job_t* getJob(int32_t index) {
+    JobThread_t *self = &jobThreads_m[index];
+
+    Job_t *job = JobDeque_pop(&self->deque);
+    if (job == NULL) {
+        // xorshift
+        self->rngState ^= self->rngState << 13;
+        self->rngState ^= self->rngState >> 17;
+        self->rngState ^= self->rngState << 5;
+
+        uint32_t start = self->rngState % jobThreadCount_m;
+        for (uint32_t i = 0; i < jobThreadCount_m && job == NULL; i++) {
+            uint32_t victim = (start + i) % jobThreadCount_m;
+            if (victim == (uint32_t) index) continue;
+            job = JobDeque_steal(&jobThreads_m[victim].deque);
+        }
+    }
+
+    if (job != NULL) {
+        __atomic_sub_fetch(&jobsPending_m, 1, __ATOMIC_SEQ_CST);
+    }
+    return job;
+}
+
+static void* workerMain(void *arg) {
+    jobThreadIndex_m = (int32_t) (intptr_t) arg;
+    uint32_t idleSpins = 0;
+
+    while (__atomic_load_n(&jobsRunning_m, __ATOMIC_ACQUIRE)) {
+        Job_t *job = getJob(jobThreadIndex_m);
+        if (job != NULL) {
+            executeJob(job);
+            idleSpins = 0;
+            continue;
+        }
+
+        // spin for a bit before going to sleep, jobs tend to come in bursts
+        if (++idleSpins < 64) {
+            sched_yield();
+            continue;
+        }
+
+        pthread_mutex_lock(&jobsSleepMutex_m);
+        __atomic_add_fetch(&jobsSleeping_m, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&jobsPending_m, __ATOMIC_SEQ_CST) == 0
+            && __atomic_load_n(&jobsRunning_m, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&jobsSleepCond_m, &jobsSleepMutex_m);
+        }
+        __atomic_sub_fetch(&jobsSleeping_m, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&jobsSleepMutex_m);
+        idleSpins = 0;
+    }
+
+    return NULL;
+}
+
+static uint32_t cpuCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t) count : 1;
+#endif
+}
+
+void JobSystem_init(uint32_t workerCount) {
+    if (jobThreads_m != NULL) {
+        fprintf(stderr, "Error: Job system is already initialized.\n");
+        return;
+    }
+
+    if (workerCount == 0) {
+        uint32_t cores = cpuCount();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+    if (workerCount > JOB_MAX_THREADS - 1) workerCount = JOB_MAX_THREADS - 1;
+
+    jobThreadCount_m = workerCount + 1;
+    // deques are cache line aligned so thieves and owners don't false share
+#ifdef _WIN32
+    jobThreads_m = _aligned_malloc(jobThreadCount_m * sizeof(JobThread_t), CACHE_LINE);
+#else
+    if (posix_memalign((void**) &jobThreads_m, CACHE_LINE, jobThreadCount_m * sizeof(JobThread_t)) != 0) {
+        jobThreads_m = NULL;
+    }
+#endif
+    if (jobThreads_m == NULL) {
+        fprintf(stderr, "Error: Failed to allocate job threads.\n");
+        return;
+    }
+    memset(jobThreads_m, 0, jobThreadCount_m * sizeof(JobThread_t));
+
+    jobsRunning_m = true;
+    jobThreadIndex_m = 0;
+
+    for (uint32_t i = 0; i < jobThreadCount_m; i++) {
+        jobThreads_m[i].rngState = 0x9E3779B9u * (i + 1);
+    }
+    for (uint32_t i = 1; i < jobThreadCount_m; i++) {
+        pthread_create(&jobThreads_m[i].thread, NULL, workerMain, (void*) (intptr_t) i);
+    }
+
+    printf("Started job system with %u workers\n", workerCount);
+}
+
+void JobSystem_shutdown() {
+    if (jobThreads_m == NULL) return;
+
+    pthread_mutex_lock(&jobsSleepMutex_m);
+    __atomic_store_n(&jobsRunning_m, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&jobsSleepCond_m);
+    pthread_mutex_unlock(&jobsSleepMutex_m);
+
+    for (uint32_t i = 1; i < jobThreadCount_m; i++) {
+        pthread_join(jobThreads_m[i].thread, NULL);
+    }
+
+#ifdef _WIN32
+    _aligned_free(jobThreads_m);
+#else
+    free(jobThreads_m);
+#endif
+    jobThreads_m = NULL;
+    jobThreadCount_m = 0;
+    jobThreadIndex_m = -1;
+}
+
+uint32_t JobSystem_threadCount() {
+    return jobThreadCount_m;
+}
+
+int32_t JobSystem_threadIndex() {
+    return jobThreadIndex_m;
+}
+
+void JobSystem_run(JobFunc_t func, void *data, JobCounter_t *counter) {
+    Job_t *job = allocJob(jobThreadIndex_m);
+    if (job == NULL) {
+        func(data);
+        return;
+    }
+
+    job->func = func;
+    job->data = data;
+    job->counter = counter;
+
+    if (counter != NULL) __atomic_add_fetch(&counter->value, 1, __ATOMIC_ACQ_REL);
+    submitJob(job);
+}
+
+void JobSystem_runAfter(JobCounter_t *dependency, JobFunc_t func, void *data, JobCounter_t *counter) {
+    Job_t *job = allocJob(jobThreadIndex_m);
+    if (job == NULL) {
+        JobSystem_wait(dependency);
+        func(data);
+        return;
+    }
+
+    job->func = func;
+    job->data = data;
+    job->counter = counter;
+
+    if (counter != NULL) __atomic_add_fetch(&counter->value, 1, __ATOMIC_ACQ_REL);
+
+    spinLock(&dependency->lock);
+    if (__atomic_load_n(&dependency->value, __ATOMIC_ACQUIRE) > 0) {
+        job->next = dependency->waiting;
+        dependency->waiting = job;
+        spinUnlock(&dependency->lock);
+        return;
+    }
+    spinUnlock(&dependency->lock);
+
+    submitJob(job);
+}
+
+void JobSystem_wait(JobCounter_t *counter) {
+    int32_t index = jobThreadIndex_m;
+
+    while (__atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) > 0) {
+        Job_t *job = index >= 0 ? getJob(index) : NULL;
+
+        if (job != NULL) {
+            executeJob(job);
+        } else {
+            sched_yield();
+        }
+    }
+
+    settleCounter(counter);
+}
+
+bool JobCounter_isDone(JobCounter_t *counter) {
+    if (__atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) > 0) return false;
+
+    settleCounter(counter);
+    return true;
+}
+
+void JobSystem_parallelFor(uint32_t count, uint32_t batchSize, JobRangeFunc_t func, void *data) {
+    if (count == 0) return;
+    if (batchSize == 0) batchSize = 1;
+
+    // don't wrap our job ring
+    uint32_t maxBatches = JOB_QUEUE_SIZE / 2;
+    if ((count + batchSize - 1) / batchSize > maxBatches) {
+        batchSize = (count + maxBatches - 1) / maxBatches;
+    }
+
+    // one batch or nobody to share with, skip the queue entirely
+    if (count <= batchSize || jobThreadIndex_m < 0) {
+        func(data, 0, count);
+        return;
+    }
+
+    JobCounter_t counter = { 0 };
+    for (uint32_t start = 0; start < count; start += batchSize) {
+        uint32_t end = start + batchSize < count ? start + batchSize : count;
+
+        Job_t *job = allocJob(jobThreadIndex_m);
+        if (job == NULL) {
+            func(data, start, end);
+            continue;
+        }
+
+        job->rangeFunc = func;
+        job->data = data;
+        job->start = start;
+        job->end = end;
+        job->counter = &counter;
+
+        __atomic_add_fetch(&counter.value, 1, __ATOMIC_ACQ_REL);
+        submitJob(job);
+    }
+
+    JobSystem_wait(&counter);
+}
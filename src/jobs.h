@@ -0,0 +1,74 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// upper bound on threads in the pool, including the main thread
+#define JOB_MAX_THREADS 32
+// jobs each thread can have in flight, must be a power of two
+#define JOB_QUEUE_SIZE 4096
+
+typedef void (*JobFunc_t)(void *data);
+// runs [start, end) of a parallel for
+typedef void (*JobRangeFunc_t)(void *data, uint32_t start, uint32_t end);
+
+typedef struct Job Job_t;
+
+/**
+ * Counts jobs that haven't finished yet, zero means everything attached to it is done.
+ * Jobs started with JobSystem_runAfter are parked on the counter until it reaches zero.
+ * Needs to be zeroed before first use. It can be reused once it's back at zero, jobs
+ * parked after that wait for the new work, never the old.
+ */
+typedef struct {
+    int32_t value;
+    // protects the waiting list
+    int32_t lock;
+    Job_t *waiting;
+} JobCounter_t;
+
+struct Job {
+    // only one of these is set, rangeFunc is used by parallel for batches
+    JobFunc_t func;
+    JobRangeFunc_t rangeFunc;
+    void *data;
+    uint32_t start;
+    uint32_t end;
+    // decremented once the job finishes, can be NULL
+    JobCounter_t *counter;
+    // next job parked on the same dependency
+    Job_t *next;
+    // set while the job is queued/running so its slot isn't handed out again
+    int32_t inUse;
+};
+
+/**
+ * Starts the worker pool, the calling thread becomes thread 0 and can help
+ * with work while waiting. workerCount of 0 uses one worker per extra core.
+ */
+void JobSystem_init(uint32_t workerCount);
+
+void JobSystem_shutdown();
+
+// worker threads + the main thread
+uint32_t JobSystem_threadCount();
+
+// index of the calling thread in the pool, 0 is the main thread, -1 if it isn't ours
+int32_t JobSystem_threadIndex();
+
+void JobSystem_run(JobFunc_t func, void *data, JobCounter_t *counter);
+
+// Same as JobSystem_run, but the job won't start until dependency reaches zero
+void JobSystem_runAfter(JobCounter_t *dependency, JobFunc_t func, void *data, JobCounter_t *counter);
+
+// Runs other jobs until the counter reaches zero, instead of blocking the thread
+void JobSystem_wait(JobCounter_t *counter);
+
+// True once everything attached to the counter has finished, never waits
+bool JobCounter_isDone(JobCounter_t *counter);
+
+// Splits [0, count) into batches of batchSize and waits for all of them
+void JobSystem_parallelFor(uint32_t count, uint32_t batchSize, JobRangeFunc_t func, void *data);
+
+#endif
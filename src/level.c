@@ -0,0 +1,309 @@
+#include "level.h"
+#include "rng.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// bottom of the screen at the default camera height
+#define LEVEL_GROUND_Y -360.0f
+
+// openings start wide and close up the further you get
+#define LEVEL_GAP_START 280.0f
+#define LEVEL_GAP_MIN 170.0f
+#define LEVEL_GAP_SHRINK 4.0f
+#define LEVEL_GAP_RANDOM 60.0f
+// how far the center of an opening can be from the middle of the screen
+#define LEVEL_GAP_RANGE 180.0f
+
+#define LEVEL_HILLS 4
+// 3 vertices a hill and 6 a cloud have to fit LEVEL_MAX_DECORATION_VERTICES
+#define LEVEL_MIN_CLOUDS 2
+#define LEVEL_MAX_CLOUDS 6
+
+void ChunkQueue_init(ChunkQueue_t *queue) {
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+bool ChunkQueue_push(ChunkQueue_t *queue, LevelChunk_t *chunk) {
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= LEVEL_POOL_SIZE) return false;
+
+    queue->items[tail & (LEVEL_POOL_SIZE - 1)] = chunk;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+LevelChunk_t* ChunkQueue_pop(ChunkQueue_t *queue) {
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail) return NULL;
+
+    LevelChunk_t *chunk = queue->items[head & (LEVEL_POOL_SIZE - 1)];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return chunk;
+}
+
+static bool ChunkQueue_isEmpty(ChunkQueue_t *queue) {
+    return __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+}
+
+static void addDecorationVertex(LevelChunk_t *chunk, float x, float y, vec4 color) {
+    if (chunk->decorationVertexCount >= LEVEL_MAX_DECORATION_VERTICES) return;
+
+    Vertex_P2C8 *v = &chunk->decorationVertices[chunk->decorationVertexCount++];
+    v->pos[0] = chunk->x + x;
+    v->pos[1] = y;
+    Vertex_packColor(color, v->color);
+}
+
+void Level_generateChunk(LevelChunk_t *chunk, uint64_t seed, uint32_t index) {
+    // every chunk is its own pcg sequence, so chunks don't depend on each other
+    Pcg32_t rng;
+    Pcg32_init(&rng, seed, index);
+
+    chunk->index = index;
+    chunk->x = index * LEVEL_CHUNK_WIDTH;
+    chunk->obstacleCount = 0;
+    chunk->pickupCount = 0;
+    chunk->decorationVertexCount = 0;
+
+    // the first chunk is left empty as a run up
+    if (index > 0) {
+        float gap = fmaxf(LEVEL_GAP_MIN, LEVEL_GAP_START - index * LEVEL_GAP_SHRINK);
+        float spacing = LEVEL_CHUNK_WIDTH / LEVEL_MAX_OBSTACLES;
+
+        for (int i = 0; i < LEVEL_MAX_OBSTACLES; i++) {
+            LevelObstacle_t *obstacle = &chunk->obstacles[chunk->obstacleCount++];
+            obstacle->x = (i + 0.5f) * spacing + (Pcg32_nextFloat(&rng) - 0.5f) * 120.0f;
+            obstacle->gapSize = gap + Pcg32_nextFloat(&rng) * LEVEL_GAP_RANDOM;
+            obstacle->gapY = Pcg32_range(&rng, -LEVEL_GAP_RANGE, LEVEL_GAP_RANGE);
+
+            // one in the middle of every opening
+            LevelPickup_t *pickup = &chunk->pickups[chunk->pickupCount++];
+            glm_vec2_copy((vec2) { obstacle->x, obstacle->gapY }, pickup->pos);
+            pickup->collected = false;
+        }
+    }
+
+    // pairs in the open space between obstacles
+    for (int i = 0; i < 2 && chunk->pickupCount + 2 <= LEVEL_MAX_PICKUPS; i++) {
+        float x = i * (LEVEL_CHUNK_WIDTH / 2.0f);
+        float y = Pcg32_range(&rng, -LEVEL_GAP_RANGE, LEVEL_GAP_RANGE);
+
+        LevelPickup_t *first = &chunk->pickups[chunk->pickupCount++];
+        glm_vec2_copy((vec2) { x + 40.0f, y }, first->pos);
+        first->collected = false;
+
+        LevelPickup_t *second = &chunk->pickups[chunk->pickupCount++];
+        glm_vec2_copy((vec2) { x + 120.0f, y }, second->pos);
+        second->collected = false;
+    }
+
+    // decorations take 4 random numbers each, made in one batch from the chunk's sequence
+    uint32_t cloudCount = LEVEL_MIN_CLOUDS + Pcg32_nextBounded(&rng, LEVEL_MAX_CLOUDS - LEVEL_MIN_CLOUDS + 1);
+    uint64_t decorationSeed = (uint64_t) Pcg32_next(&rng) << 32;
+    decorationSeed |= Pcg32_next(&rng);
+
+    Xoshiro128x4_t decorationRng;
+    Xoshiro128x4_init(&decorationRng, decorationSeed);
+    float random[(LEVEL_HILLS + LEVEL_MAX_CLOUDS) * 4];
+    Xoshiro128x4_fillFloat(&decorationRng, random, (LEVEL_HILLS + cloudCount) * 4, 0.0f, 1.0f);
+    float *r = random;
+
+    // hills along the bottom, kept inside the chunk so they don't pop when it's recycled
+    for (int i = 0; i < LEVEL_HILLS; i++, r += 4) {
+        float halfWidth = 120.0f + r[0] * 80.0f;
+        float height = 80.0f + r[1] * 140.0f;
+        float x = halfWidth + r[2] * (LEVEL_CHUNK_WIDTH - halfWidth * 2.0f);
+        float shade = r[3] * 0.1f;
+        vec4 color = { 0.25f + shade, 0.6f + shade, 0.3f, 1.0f };
+
+        addDecorationVertex(chunk, x - halfWidth, LEVEL_GROUND_Y, color);
+        addDecorationVertex(chunk, x, LEVEL_GROUND_Y + height, color);
+        addDecorationVertex(chunk, x + halfWidth, LEVEL_GROUND_Y, color);
+    }
+
+    for (uint32_t i = 0; i < cloudCount; i++, r += 4) {
+        float width = 80.0f + r[0] * 80.0f;
+        float height = 24.0f + r[1] * 24.0f;
+        float x = r[2] * (LEVEL_CHUNK_WIDTH - width);
+        float y = 140.0f + r[3] * 160.0f;
+        vec4 color = { 1.0f, 1.0f, 1.0f, 0.7f };
+
+        addDecorationVertex(chunk, x, y, color);
+        addDecorationVertex(chunk, x, y + height, color);
+        addDecorationVertex(chunk, x + width, y + height, color);
+        addDecorationVertex(chunk, x, y, color);
+        addDecorationVertex(chunk, x + width, y + height, color);
+        addDecorationVertex(chunk, x + width, y, color);
+    }
+}
+
+static bool LevelStreamer_hasWork(LevelStreamer_t *streamer, uint32_t generation, uint32_t next) {
+    if (!__atomic_load_n(&streamer->running, __ATOMIC_SEQ_CST)) return true;
+    if (__atomic_load_n(&streamer->generation, __ATOMIC_SEQ_CST) != generation) return true;
+
+    return next < __atomic_load_n(&streamer->wantedChunks, __ATOMIC_SEQ_CST)
+        && !ChunkQueue_isEmpty(&streamer->freeChunks);
+}
+
+static void* LevelStreamer_threadMain(void *data) {
+    LevelStreamer_t *streamer = data;
+
+    uint32_t generation = 0;
+    uint32_t next = streamer->primedChunks;
+
+    while (__atomic_load_n(&streamer->running, __ATOMIC_SEQ_CST)) {
+        uint32_t currentGeneration = __atomic_load_n(&streamer->generation, __ATOMIC_SEQ_CST);
+        if (currentGeneration != generation) {
+            generation = currentGeneration;
+            next = 0;
+        }
+
+        if (next < __atomic_load_n(&streamer->wantedChunks, __ATOMIC_SEQ_CST)) {
+            LevelChunk_t *chunk = ChunkQueue_pop(&streamer->freeChunks);
+            if (chunk != NULL) {
+                Level_generateChunk(chunk, streamer->seed, next++);
+                chunk->generation = generation;
+                // every chunk fits in the queue, so this can't fail
+                ChunkQueue_push(&streamer->readyChunks, chunk);
+                continue;
+            }
+        }
+
+        // caught up, or waiting on chunks to scroll off. Sleep until the main thread wakes us
+        pthread_mutex_lock(&streamer->sleepMutex);
+        __atomic_store_n(&streamer->sleeping, 1, __ATOMIC_SEQ_CST);
+        while (!LevelStreamer_hasWork(streamer, generation, next)) {
+            pthread_cond_wait(&streamer->sleepCond, &streamer->sleepMutex);
+        }
+        __atomic_store_n(&streamer->sleeping, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&streamer->sleepMutex);
+    }
+
+    return NULL;
+}
+
+static void LevelStreamer_wake(LevelStreamer_t *streamer) {
+    if (__atomic_load_n(&streamer->sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&streamer->sleepMutex);
+        pthread_cond_signal(&streamer->sleepCond);
+        pthread_mutex_unlock(&streamer->sleepMutex);
+    }
+}
+
+void LevelStreamer_init(LevelStreamer_t *streamer, uint64_t seed, ChunkLoadedFunc_t onChunkLoaded) {
+    streamer->seed = seed;
+    streamer->onChunkLoaded = onChunkLoaded;
+    streamer->activeCount = 0;
+    streamer->generation = 0;
+    streamer->sleeping = 0;
+    streamer->running = true;
+
+    streamer->pool = Memory_alloc(MEMORY_TAG_SCENE, LEVEL_POOL_SIZE * sizeof(LevelChunk_t));
+    if (streamer->pool == NULL) {
+        fprintf(stderr, "Error: Failed to allocate the level chunk pool.\n");
+        streamer->running = false;
+        return;
+    }
+
+    ChunkQueue_init(&streamer->freeChunks);
+    ChunkQueue_init(&streamer->readyChunks);
+    for (uint32_t i = 0; i < LEVEL_POOL_SIZE; i++) {
+        streamer->pool[i].slot = i;
+        ChunkQueue_push(&streamer->freeChunks, &streamer->pool[i]);
+    }
+
+    // generate the start of the level here so it's there on the first frame
+    streamer->wantedChunks = 1 + LEVEL_CHUNKS_AHEAD;
+    streamer->primedChunks = 0;
+    while (streamer->primedChunks < streamer->wantedChunks) {
+        LevelChunk_t *chunk = ChunkQueue_pop(&streamer->freeChunks);
+        Level_generateChunk(chunk, seed, streamer->primedChunks++);
+        chunk->generation = 0;
+        ChunkQueue_push(&streamer->readyChunks, chunk);
+    }
+
+    pthread_mutex_init(&streamer->sleepMutex, NULL);
+    pthread_cond_init(&streamer->sleepCond, NULL);
+    if (pthread_create(&streamer->thread, NULL, LevelStreamer_threadMain, streamer) != 0) {
+        fprintf(stderr, "Error: Failed to start the level streaming thread.\n");
+        streamer->running = false;
+    }
+}
+
+void LevelStreamer_free(LevelStreamer_t *streamer) {
+    if (streamer->pool == NULL) return;
+
+    if (streamer->running) {
+        __atomic_store_n(&streamer->running, false, __ATOMIC_SEQ_CST);
+        pthread_mutex_lock(&streamer->sleepMutex);
+        pthread_cond_signal(&streamer->sleepCond);
+        pthread_mutex_unlock(&streamer->sleepMutex);
+        pthread_join(streamer->thread, NULL);
+    }
+
+    pthread_mutex_destroy(&streamer->sleepMutex);
+    pthread_cond_destroy(&streamer->sleepCond);
+
+    Memory_free(streamer->pool);
+    streamer->pool = NULL;
+    streamer->activeCount = 0;
+}
+
+void LevelStreamer_update(LevelStreamer_t *streamer, float minX, float maxX) {
+    bool wake = false;
+
+    // active is ordered by index, so only chunks at the front can have scrolled off
+    uint32_t dropped = 0;
+    while (dropped < streamer->activeCount && streamer->active[dropped]->x + LEVEL_CHUNK_WIDTH < minX) {
+        ChunkQueue_push(&streamer->freeChunks, streamer->active[dropped]);
+        dropped++;
+    }
+    if (dropped > 0) {
+        streamer->activeCount -= dropped;
+        memmove(streamer->active, streamer->active + dropped, streamer->activeCount * sizeof(LevelChunk_t*));
+        wake = true;
+    }
+
+    LevelChunk_t *chunk;
+    while ((chunk = ChunkQueue_pop(&streamer->readyChunks)) != NULL) {
+        // generated before the last reset
+        if (chunk->generation != streamer->generation) {
+            ChunkQueue_push(&streamer->freeChunks, chunk);
+            wake = true;
+            continue;
+        }
+
+        streamer->active[streamer->activeCount++] = chunk;
+        if (streamer->onChunkLoaded != NULL) streamer->onChunkLoaded(chunk);
+    }
+
+    uint32_t wanted = maxX > 0.0f ? (uint32_t) (maxX / LEVEL_CHUNK_WIDTH) + 1 + LEVEL_CHUNKS_AHEAD : 1 + LEVEL_CHUNKS_AHEAD;
+    if (wanted != streamer->wantedChunks) {
+        wake |= wanted > streamer->wantedChunks;
+        __atomic_store_n(&streamer->wantedChunks, wanted, __ATOMIC_SEQ_CST);
+    }
+
+    if (wake) LevelStreamer_wake(streamer);
+}
+
+void LevelStreamer_reset(LevelStreamer_t *streamer) {
+    for (uint32_t i = 0; i < streamer->activeCount; i++) {
+        ChunkQueue_push(&streamer->freeChunks, streamer->active[i]);
+    }
+    streamer->activeCount = 0;
+
+    // wanted has to be in place before the generator sees the new generation
+    __atomic_store_n(&streamer->wantedChunks, 1 + LEVEL_CHUNKS_AHEAD, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&streamer->generation, streamer->generation + 1, __ATOMIC_SEQ_CST);
+
+    LevelStreamer_wake(streamer);
+}
@@ -0,0 +1,133 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "renderer.h"
+
+#define LEVEL_CHUNK_WIDTH 1024.0f
+// chunks that exist at once, also the size of the queues. Must be a power of two
+#define LEVEL_POOL_SIZE 16
+// how many chunks past the right edge of the screen we keep generated
+#define LEVEL_CHUNKS_AHEAD 2
+
+#define LEVEL_MAX_OBSTACLES 2
+#define LEVEL_MAX_PICKUPS 6
+#define LEVEL_MAX_DECORATION_VERTICES 64
+
+// a pair of pipes with an opening between them, in chunk space
+typedef struct {
+    float x;
+    // center and height of the opening
+    float gapY;
+    float gapSize;
+} LevelObstacle_t;
+
+typedef struct {
+    // chunk space
+    vec2 pos;
+    bool collected;
+} LevelPickup_t;
+
+typedef struct {
+    // chunk i covers [i * LEVEL_CHUNK_WIDTH, (i + 1) * LEVEL_CHUNK_WIDTH)
+    uint32_t index;
+    float x;
+    // LevelStreamer_reset count it was generated for, older chunks get thrown away
+    uint32_t generation;
+    // where it lives in the pool, never changes
+    uint32_t slot;
+
+    uint32_t obstacleCount;
+    LevelObstacle_t obstacles[LEVEL_MAX_OBSTACLES];
+
+    uint32_t pickupCount;
+    LevelPickup_t pickups[LEVEL_MAX_PICKUPS];
+
+    // background triangles, already in world space since they never move
+    uint32_t decorationVertexCount;
+    Vertex_P2C8 decorationVertices[LEVEL_MAX_DECORATION_VERTICES];
+} LevelChunk_t;
+
+/**
+ * Single producer single consumer ring of chunk pointers. One thread pushes,
+ * one other thread pops, neither ever blocks.
+ */
+typedef struct {
+    // consumer side
+    uint32_t head __attribute__((aligned(64)));
+    // producer side
+    uint32_t tail __attribute__((aligned(64)));
+    LevelChunk_t *items[LEVEL_POOL_SIZE] __attribute__((aligned(64)));
+} ChunkQueue_t;
+
+typedef void (*ChunkLoadedFunc_t)(LevelChunk_t *chunk);
+
+/**
+ * Generates the level in fixed width chunks on a background thread.
+ * Every chunk is allocated up front, empty chunks go to the generator through
+ * freeChunks and come back filled through readyChunks, so the main thread never
+ * allocates or waits no matter how long the run goes.
+ */
+typedef struct {
+    uint64_t seed;
+    LevelChunk_t *pool;
+
+    // main thread -> generator
+    ChunkQueue_t freeChunks;
+    // generator -> main thread
+    ChunkQueue_t readyChunks;
+
+    // main thread only, the chunks in play ordered by index
+    LevelChunk_t *active[LEVEL_POOL_SIZE];
+    uint32_t activeCount;
+    // called on the main thread when a chunk is added to active
+    ChunkLoadedFunc_t onChunkLoaded;
+
+    // written by the main thread, read by the generator
+    // chunks below this index should be generated
+    uint32_t wantedChunks;
+    uint32_t generation;
+    bool running;
+
+    // chunks generated during init, the generator carries on from here
+    uint32_t primedChunks;
+
+    int32_t sleeping;
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t sleepCond;
+    pthread_t thread;
+} LevelStreamer_t;
+
+void ChunkQueue_init(ChunkQueue_t *queue);
+
+// Returns false if the queue is full
+bool ChunkQueue_push(ChunkQueue_t *queue, LevelChunk_t *chunk);
+
+// Returns NULL if the queue is empty
+LevelChunk_t* ChunkQueue_pop(ChunkQueue_t *queue);
+
+// Fills chunk `index` of the level, the same seed and index always give the same chunk
+void Level_generateChunk(LevelChunk_t *chunk, uint64_t seed, uint32_t index);
+
+/**
+ * Allocates the pool, generates the first few chunks on the calling thread so
+ * they're there on the first frame, and starts the generator thread.
+ */
+void LevelStreamer_init(LevelStreamer_t *streamer, uint64_t seed, ChunkLoadedFunc_t onChunkLoaded);
+
+// Stops the generator and frees the pool
+void LevelStreamer_free(LevelStreamer_t *streamer);
+
+/**
+ * Recycles chunks that are completely left of minX, takes in any finished chunks
+ * and asks for more up to LEVEL_CHUNKS_AHEAD past maxX. Main thread only.
+ */
+void LevelStreamer_update(LevelStreamer_t *streamer, float minX, float maxX);
+
+// Throws away every chunk and starts over from chunk 0
+void LevelStreamer_reset(LevelStreamer_t *streamer);
+
+#endif
@@ -0,0 +1,131 @@
+#include "lines.h"
+#include "memory.h"
+
+#include <string.h>
+
+void LineRenderer_init(LineRenderer_t *lines, Context_t *context) {
+    lines->context = context;
+    lines->segmentCapacity = 1024;
+    lines->segmentCount = 0;
+    lines->segments = Memory_alloc(MEMORY_TAG_RENDERER, lines->segmentCapacity * sizeof(LineSegment_t));
+    lines->glowRadius = 0.0f;
+    lines->glowStrength = 0.0f;
+
+    lines->program = Resources_loadProgram("assets/line.vs.glsl", "assets/line.fs.glsl");
+    lines->shader = Resources_programName(lines->program);
+    lines->projectionLoc = glGetUniformLocation(lines->shader, "projection");
+    lines->modelLoc = glGetUniformLocation(lines->shader, "model");
+    lines->viewportLoc = glGetUniformLocation(lines->shader, "viewport");
+    lines->glowRadiusLoc = glGetUniformLocation(lines->shader, "glowRadius");
+    lines->glowStrengthLoc = glGetUniformLocation(lines->shader, "glowStrength");
+
+    lines->vertexArray = Resources_createVertexArray();
+    lines->vao = Resources_vertexArrayName(lines->vertexArray);
+    GLuint vao = lines->vao;
+
+    // no per vertex data at all, the corners come from gl_VertexID
+    lines->instanceVb = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(VertexBuffer_t));
+    VertexBuffer_init(lines->instanceVb, sizeof(LineSegment_t), 0, 0, GL_STREAM_DRAW, NULL);
+    glVertexArrayVertexBuffer(vao, 0, lines->instanceVb->vbo, 0, sizeof(LineSegment_t));
+    glVertexArrayBindingDivisor(vao, 0, 1);
+
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(LineSegment_t, start));
+    glVertexArrayAttribBinding(vao, 0, 0);
+
+    glEnableVertexArrayAttrib(vao, 1);
+    glVertexArrayAttribFormat(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(LineSegment_t, end));
+    glVertexArrayAttribBinding(vao, 1, 0);
+
+    glEnableVertexArrayAttrib(vao, 2);
+    glVertexArrayAttribFormat(vao, 2, 1, GL_FLOAT, GL_FALSE, offsetof(LineSegment_t, width));
+    glVertexArrayAttribBinding(vao, 2, 0);
+
+    glEnableVertexArrayAttrib(vao, 3);
+    glVertexArrayAttribFormat(vao, 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(LineSegment_t, color));
+    glVertexArrayAttribBinding(vao, 3, 0);
+}
+
+void LineRenderer_free(LineRenderer_t *lines) {
+    Resources_releaseVertexArray(lines->vertexArray);
+    Resources_releaseProgram(lines->program);
+    VertexBuffer_free(lines->instanceVb);
+    Memory_free(lines->segments);
+    lines->instanceVb = NULL;
+    lines->segments = NULL;
+}
+
+void LineRenderer_setGlow(LineRenderer_t *lines, float radius, float strength) {
+    lines->glowRadius = radius;
+    lines->glowStrength = strength;
+}
+
+static uint32_t packColor(vec4 color) {
+    uint8_t rgba[4];
+    for (int i = 0; i < 4; i++) {
+        float c = color[i] < 0.0f ? 0.0f : color[i] > 1.0f ? 1.0f : color[i];
+        rgba[i] = (uint8_t) (c * 255.0f + 0.5f);
+    }
+
+    uint32_t packed;
+    memcpy(&packed, rgba, 4);
+    return packed;
+}
+
+static LineSegment_t* reserve(LineRenderer_t *lines, size_t count) {
+    if (lines->segmentCount + count > lines->segmentCapacity) {
+        while (lines->segmentCount + count > lines->segmentCapacity) lines->segmentCapacity *= 2;
+        lines->segments = Memory_realloc(MEMORY_TAG_RENDERER, lines->segments, lines->segmentCapacity * sizeof(LineSegment_t));
+    }
+
+    LineSegment_t *segments = &lines->segments[lines->segmentCount];
+    lines->segmentCount += count;
+    return segments;
+}
+
+void LineRenderer_add(LineRenderer_t *lines, vec2 start, vec2 end, float width, vec4 color) {
+    LineSegment_t *segment = reserve(lines, 1);
+    glm_vec2_copy(start, segment->start);
+    glm_vec2_copy(end, segment->end);
+    segment->width = width;
+    segment->color = packColor(color);
+}
+
+void LineRenderer_addPolyline(LineRenderer_t *lines, const vec2 *points, size_t count, bool closed, float width, vec4 color) {
+    if (count < 2) return;
+
+    size_t segmentCount = closed ? count : count - 1;
+    LineSegment_t *segments = reserve(lines, segmentCount);
+    uint32_t packed = packColor(color);
+
+    for (size_t i = 0; i < segmentCount; i++) {
+        const float *start = points[i];
+        const float *end = points[(i + 1) % count];
+        segments[i] = (LineSegment_t) { { start[0], start[1] }, { end[0], end[1] }, width, packed };
+    }
+}
+
+void LineRenderer_flush(LineRenderer_t *lines) {
+    if (lines->segmentCount == 0) return;
+
+    // orphan and refill, the previous draw can keep reading the old storage
+    VertexBuffer_t *instanceVb = lines->instanceVb;
+    size_t size = lines->segmentCount * sizeof(LineSegment_t);
+    Resources_resizeBuffer(instanceVb->handle, size > instanceVb->bufferSize ? size : instanceVb->bufferSize);
+    instanceVb->bufferSize = Resources_bufferSize(instanceVb->handle);
+    glNamedBufferSubData(instanceVb->vbo, 0, size, lines->segments);
+
+    Context_t *context = lines->context;
+    glUseProgram(lines->shader);
+    glUniformMatrix4fv(lines->projectionLoc, 1, GL_FALSE, (float*) &context->projectionMatrix);
+    glUniformMatrix4fv(lines->modelLoc, 1, GL_FALSE, (float*) MatrixStack_peek(context->matrixStack));
+    glUniform2f(lines->viewportLoc, (float) context->displayWidth, (float) context->displayHeight);
+    glUniform1f(lines->glowRadiusLoc, lines->glowRadius);
+    glUniform1f(lines->glowStrengthLoc, lines->glowStrength);
+
+    glBindVertexArray(lines->vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) lines->segmentCount);
+    glBindVertexArray(0);
+
+    lines->segmentCount = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef LINES_H
+#define LINES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "renderer.h"
+
+// one instance, what the vertex shader turns into a quad
+typedef struct {
+    vec2 start;
+    vec2 end;
+    // in pixels
+    float width;
+    // rgba8, normalized by the attribute
+    uint32_t color;
+} LineSegment_t;
+
+/**
+ * Batches line segments and draws all of them with one instanced draw. Every
+ * segment is expanded into a screen aligned quad in the vertex shader, and the
+ * fragment shader does the anti-aliasing and glow from the distance to the
+ * segment, so widths are in pixels whatever the model matrix does.
+ */
+typedef struct {
+    Context_t *context;
+
+    ProgramHandle_t program;
+    GLuint shader;
+    VertexArrayHandle_t vertexArray;
+    GLuint vao;
+    // instance data, orphaned every flush
+    VertexBuffer_t *instanceVb;
+
+    LineSegment_t *segments;
+    size_t segmentCount;
+    size_t segmentCapacity;
+
+    // pixels the glow reaches past the edge, 0 for plain lines
+    float glowRadius;
+    // glow opacity right at the edge
+    float glowStrength;
+
+    GLint projectionLoc;
+    GLint modelLoc;
+    GLint viewportLoc;
+    GLint glowRadiusLoc;
+    GLint glowStrengthLoc;
+} LineRenderer_t;
+
+void LineRenderer_init(LineRenderer_t *lines, Context_t *context);
+
+void LineRenderer_free(LineRenderer_t *lines);
+
+void LineRenderer_setGlow(LineRenderer_t *lines, float radius, float strength);
+
+void LineRenderer_add(LineRenderer_t *lines, vec2 start, vec2 end, float width, vec4 color);
+
+// count points joined up in order, closed also joins the last one back to the first
+void LineRenderer_addPolyline(LineRenderer_t *lines, const vec2 *points, size_t count, bool closed, float width, vec4 color);
+
+// Draws everything added since the last flush with the current model matrix
+void LineRenderer_flush(LineRenderer_t *lines);
+
+#endif
@@ -0,0 +1,127 @@
+#include "loader.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+typedef enum {
+    SCENE_LOADER_IDLE,
+    SCENE_LOADER_LOADING,
+    // preload is done, waiting for the main thread to pick it up
+    SCENE_LOADER_READY
+} SceneLoaderState_e;
+
+GLFWwindow *sceneLoaderWindow_m = NULL;
+pthread_t sceneLoaderThread_m;
+bool sceneLoaderRunning_m = false;
+
+int32_t sceneLoaderState_m = SCENE_LOADER_IDLE;
+Scene_t *sceneLoaderScene_m = NULL;
+pthread_mutex_t sceneLoaderMutex_m = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t sceneLoaderCond_m = PTHREAD_COND_INITIALIZER;
+
+static void* SceneLoader_threadMain(void *data) {
+    glfwMakeContextCurrent(sceneLoaderWindow_m);
+
+    pthread_mutex_lock(&sceneLoaderMutex_m);
+    while (true) {
+        while (sceneLoaderRunning_m && __atomic_load_n(&sceneLoaderState_m, __ATOMIC_ACQUIRE) != SCENE_LOADER_LOADING) {
+            pthread_cond_wait(&sceneLoaderCond_m, &sceneLoaderMutex_m);
+        }
+        if (!sceneLoaderRunning_m) break;
+
+        Scene_t *scene = sceneLoaderScene_m;
+        pthread_mutex_unlock(&sceneLoaderMutex_m);
+
+        Trace_begin("scene preload");
+        scene->preload();
+        Trace_end();
+
+        // the main thread can only rely on what we made once the GPU has actually run it,
+        // so wait for a fence here instead of making the main thread check for one
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GLenum result;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        if (result == GL_WAIT_FAILED) {
+            fprintf(stderr, "Error: Waiting on the scene loader fence failed, finishing instead.\n");
+            glFinish();
+        }
+        glDeleteSync(fence);
+
+        pthread_mutex_lock(&sceneLoaderMutex_m);
+        __atomic_store_n(&sceneLoaderState_m, SCENE_LOADER_READY, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&sceneLoaderMutex_m);
+
+    glfwMakeContextCurrent(NULL);
+    return NULL;
+}
+
+bool SceneLoader_init(GLFWwindow *mainWindow) {
+    // an invisible 1x1 window is the only portable way to get a second context out of glfw,
+    // the other window hints (version, debug) are still set from the main window
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    sceneLoaderWindow_m = glfwCreateWindow(1, 1, "DeltaWing Loader", NULL, mainWindow);
+    if (sceneLoaderWindow_m == NULL) {
+        fprintf(stderr, "Error: Couldn't create the shared loader context, scenes will load on the main thread.\n");
+        return false;
+    }
+
+    sceneLoaderRunning_m = true;
+    if (pthread_create(&sceneLoaderThread_m, NULL, SceneLoader_threadMain, NULL) != 0) {
+        fprintf(stderr, "Error: Couldn't start the scene loader thread, scenes will load on the main thread.\n");
+        sceneLoaderRunning_m = false;
+        glfwDestroyWindow(sceneLoaderWindow_m);
+        sceneLoaderWindow_m = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void SceneLoader_shutdown() {
+    if (!sceneLoaderRunning_m) return;
+
+    // an in progress preload gets to finish first
+    pthread_mutex_lock(&sceneLoaderMutex_m);
+    sceneLoaderRunning_m = false;
+    pthread_cond_signal(&sceneLoaderCond_m);
+    pthread_mutex_unlock(&sceneLoaderMutex_m);
+    pthread_join(sceneLoaderThread_m, NULL);
+
+    glfwDestroyWindow(sceneLoaderWindow_m);
+    sceneLoaderWindow_m = NULL;
+}
+
+bool SceneLoader_load(Scene_t *scene) {
+    if (!sceneLoaderRunning_m || scene->preload == NULL) return false;
+
+    pthread_mutex_lock(&sceneLoaderMutex_m);
+    bool idle = sceneLoaderState_m == SCENE_LOADER_IDLE;
+    if (idle) {
+        sceneLoaderScene_m = scene;
+        __atomic_store_n(&sceneLoaderState_m, SCENE_LOADER_LOADING, __ATOMIC_RELEASE);
+        pthread_cond_signal(&sceneLoaderCond_m);
+    }
+    pthread_mutex_unlock(&sceneLoaderMutex_m);
+
+    return idle;
+}
+
+bool SceneLoader_isLoading() {
+    return __atomic_load_n(&sceneLoaderState_m, __ATOMIC_ACQUIRE) != SCENE_LOADER_IDLE;
+}
+
+Scene_t* SceneLoader_poll() {
+    // checked without the lock so a frame never waits on the loader
+    if (__atomic_load_n(&sceneLoaderState_m, __ATOMIC_ACQUIRE) != SCENE_LOADER_READY) return NULL;
+
+    Scene_t *scene = sceneLoaderScene_m;
+    sceneLoaderScene_m = NULL;
+    __atomic_store_n(&sceneLoaderState_m, SCENE_LOADER_IDLE, __ATOMIC_RELEASE);
+    return scene;
+}
@@ -0,0 +1,33 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "engine.h"
+
+/**
+ * Runs Scene_t preloads on a background thread that has its own GL context,
+ * shared with the main window's. Buffers, textures and shader programs made
+ * there can be used by the main thread once the scene is handed back, VAOs and
+ * FBOs can't since they aren't shared between contexts, those go in activate.
+ */
+
+// Creates the hidden loader context and starts the thread, main thread only.
+// Returns false if the shared context couldn't be made, scenes then preload inline
+bool SceneLoader_init(GLFWwindow *mainWindow);
+
+void SceneLoader_shutdown();
+
+// Starts preloading scene, false if the loader isn't running or is busy with another scene
+bool SceneLoader_load(Scene_t *scene);
+
+// True from SceneLoader_load until the scene has been handed back by SceneLoader_poll
+bool SceneLoader_isLoading();
+
+// Returns the scene once its preload has finished and all of its GL work has completed, otherwise NULL
+Scene_t* SceneLoader_poll();
+
+#endif
@@ -1,10 +1,22 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #define DEFINE_GLOBALS
 #include "globals.h"
 
 #include "util.h"
+#include "trace.h"
+#include "jobs.h"
+#include "rng.h"
+#include "archive.h"
+#include "arena.h"
+#include "memory.h"
+#include "loader.h"
+#include "resources.h"
+#include "texstream.h"
+#include "texpool.h"
+#include "postfx.h"
 #include "scenes.h"
 
 GLFWwindow *window;
@@ -17,6 +29,12 @@ int32_t cameraY = 0;
 
 bool running = true;
 
+// set by DW_STARTUP_BENCH, quits as soon as the first frame is up
+bool startupBench = false;
+
+// F3 toggles the heap usage per tag in the corner
+bool showMemoryPanel = false;
+
 // Our scene defaults to the main menu
 
 void DW_GLFWerrorCallback(int error, const char *description) {
@@ -32,6 +50,8 @@ void DW_keyCallback(GLFWwindow *window, int key, int scancode, int action, int m
         input->keyStates[key] = action; 
         input->currentMods = mods;
 
+        if (key == GLFW_KEY_F3 && action == GLFW_PRESS) showMemoryPanel = !showMemoryPanel;
+
         if (currentScene != NULL) currentScene->onKey(key, scancode, action, mods);
     }
 }
@@ -52,7 +72,10 @@ void DW_cursorPosCallback(GLFWwindow *window, double xpos, double ypos) {
 }
 
 bool DW_initWindow() {    
-    if (!glfwInit()) {
+    Trace_begin("glfwInit");
+    bool initialized = glfwInit();
+    Trace_end();
+    if (!initialized) {
         return true;
     }
 
@@ -62,8 +85,10 @@ bool DW_initWindow() {
     glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);  
 
+    Trace_begin("glfwCreateWindow");
     window = glfwCreateWindow(DISPLAY_WIDTH, DISPLAY_HEIGHT, "DeltaWing", NULL, NULL);
     glfwMakeContextCurrent(window);
+    Trace_end();
     glfwSwapInterval(1);
 
     // setup callbacks
@@ -78,7 +103,10 @@ bool DW_initWindow() {
         return true;
     }
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+    Trace_begin("gladLoadGL");
+    bool loaded = gladLoadGLLoader((GLADloadproc) glfwGetProcAddress);
+    Trace_end();
+    if (!loaded) {
         fprintf(stderr, "Error: Couldn't load OpenGL\n");
         return true;
     }
@@ -87,6 +115,7 @@ bool DW_initWindow() {
     const unsigned char *renderer = glGetString(GL_RENDERER);
     printf("OpenGL: %s\n", version);
     printf("Renderer: %s\n", renderer);
+    printf("Bindless textures: %s\n", TexturePool_initBindless((GLADloadproc) glfwGetProcAddress) ? "yes" : "no");
 
     glEnable(GL_DEBUG_OUTPUT);
     // Disable all messages for the INFO and DEBUG severity levels
@@ -100,61 +129,119 @@ bool DW_initWindow() {
     return false;
 }
 
+// Swaps to a scene that's ready to go, the previous one is exited first
+void DW_activateScene(Scene_t *scene) {
+    if (currentScene != NULL) currentScene->exit();
+
+    currentScene = scene;
+    Trace_begin("activate scene");
+    scene->activate();
+    Trace_end();
+}
+
 void DW_setScene(Scene_t *scene) {
-    if (scene != NULL) {
+    if (scene == NULL || SceneLoader_isLoading()) return;
 
-        if (currentScene != NULL) currentScene->exit();
+    // the current scene keeps running while the loader works, DW_updateScene does the swap
+    if (SceneLoader_load(scene)) return;
 
-        currentScene = scene;
-        scene->init();
+    // nothing to preload, or no loader thread to do it on
+    if (scene->preload != NULL) {
+        Trace_begin("scene preload");
+        scene->preload();
+        Trace_end();
     }
+    DW_activateScene(scene);
 }
 
-const float left = (DISPLAY_WIDTHF / 2.0f) - 256.0f;
-const float right = (DISPLAY_WIDTHF / 2.0f) + 256.0f;
-const float top = (DISPLAY_HEIGHTF / 2.0f) - 256.0f;
-const float bottom = (DISPLAY_HEIGHTF / 2.0f) + 256.0f;
-
-GLuint testTexture;
-Renderer_t *testRenderer;
+// Picks up a scene the loader has finished with, called once a frame
+void DW_updateScene() {
+    Scene_t *loaded = SceneLoader_poll();
+    if (loaded != NULL) DW_activateScene(loaded);
+}
 
 void DW_initGame() {
+    // everything random is derived from this, DW_SEED=<number> replays a run
+    const char *seedEnv = getenv("DW_SEED");
+    if (seedEnv != NULL) Rng_setSeed(strtoull(seedEnv, NULL, 0));
+    printf("Seed: %llu\n", (unsigned long long) Rng_getSeed());
+
+    // one mapping for every asset, loose files are used if there's no pack
+    Trace_begin("Archive_mount");
+    Archive_mount(DW_ASSET_PACK);
+    Trace_end();
+
+    // every buffer, texture, VAO and program goes through here
+    Resources_init();
+    // temporaries that only last a frame, or a function on any thread
+    FrameArena_init();
+
+    // worker threads for everything that doesn't need the GL context
+    Trace_begin("JobSystem_init");
+    JobSystem_init(0);
+    Trace_end();
+    // and one that does, for loading scenes in the background
+    Trace_begin("SceneLoader_init");
+    SceneLoader_init(window);
+    Trace_end();
+    // textures that show up mid-game get decoded on the workers and trickle in a few rows a frame
+    TextureStream_init();
+
     // Compile shaders for all of our vertex formats
+    Trace_begin("Shader_compileDefaultShaders");
     Shader_compileDefaultShaders();
+    Renderer_initVertexArrays();
+    Trace_end();
 
     // init render context
-    context = (Context_t*) malloc(sizeof(Context_t));
+    context = (Context_t*) Memory_alloc(MEMORY_TAG_RENDERER, sizeof(Context_t));
     Context_init(context, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    // the CRT look, DW_POSTFX=0 turns it off
+    Trace_begin("PostFx_init");
+    PostFx_init(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    const char *postFxEnv = getenv("DW_POSTFX");
+    if (postFxEnv != NULL && strcmp(postFxEnv, "0") == 0) PostFx_settings()->enabled = false;
+    // DW_DYNRES=0 keeps the scene at native resolution, any other number is the GPU budget in ms
+    const char *dynResEnv = getenv("DW_DYNRES");
+    if (dynResEnv != NULL) {
+        float budget = strtof(dynResEnv, NULL);
+        PostFx_settings()->dynamicResolution = budget > 0.0f;
+        if (budget > 0.0f) PostFx_settings()->targetFrameMs = budget;
+    }
+    Trace_end();
     // create font renderer
-    fontRenderer = (FontRenderer_t*) malloc(sizeof(FontRenderer_t));
+    Trace_begin("FontRenderer_init");
+    fontRenderer = (FontRenderer_t*) Memory_alloc(MEMORY_TAG_FONT, sizeof(FontRenderer_t));
     FontRenderer_init(fontRenderer, context, "assets/roboto_mono.fnt", 0.5f);
+    Trace_end();
+    // vector lines, one instanced draw per flush
+    Trace_begin("LineRenderer_init");
+    lineRenderer = (LineRenderer_t*) Memory_alloc(MEMORY_TAG_RENDERER, sizeof(LineRenderer_t));
+    LineRenderer_init(lineRenderer, context);
+    Trace_end();
 
     // Create keyboard input struct, with zeroes (false as default key states)
-    input = (Input_t*) calloc(1, sizeof(Input_t));
+    input = (Input_t*) Memory_calloc(MEMORY_TAG_ENGINE, 1, sizeof(Input_t));
 
     // Init default scene
-    currentScene = &Scene_MainMenu;
-    if (currentScene != NULL) currentScene->init();
-
-    testRenderer = (Renderer_t*) malloc(sizeof(Renderer_t));
-
-    Vertex_PT verticies[] = {
-        { { left, bottom, 0.0f }, { 0.0f, 0.0f } },
-        { { left, top, 0.0f }, { 0.0f, 1.0f } },
-        { { right, top, 0.0f }, { 1.0f, 1.0f } },
-        { { right, bottom, 0.0f }, { 1.0f, 0.0f } }
-    };
+    Trace_begin("DW_setScene");
+    DW_setScene(&Scene_MainMenu);
+    Trace_end();
+}
 
-    uint32_t indicies[] = {
-        0, 1, 2, 0, 2, 3
-    };
+// Called once the first frame with a scene in it has been swapped
+void DW_firstFrame() {
+    Trace_end();
+    Trace_mark("first frame");
+    printf("Startup: first frame after %.2f ms\n", Trace_now() / 1e6);
 
-    VertexBuffer_t vb;
-    VertexBuffer_init(&vb, sizeof(Vertex_PT), sizeof(verticies) / sizeof(Vertex_PT), sizeof(verticies), GL_STATIC_DRAW, verticies);
-    IndexBuffer_t ib;
-    IndexBuffer_init(&ib, 6, sizeof(indicies), indicies);
+    const char *tracePath = getenv("DW_TRACE");
+    if (tracePath != NULL) {
+        Trace_print();
+        Trace_writeJson(tracePath);
+    }
 
-    Renderer_init(testRenderer, context, VERTEX_FORMAT_PT, &vb, &ib);
+    if (startupBench) running = false;
 }
 
 void DW_exitGame() {
@@ -166,12 +253,40 @@ void DW_cleanup() {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
 
+    // waits for a preload that's still going, it might be using things we're about to free
+    SceneLoader_shutdown();
+
+    if (currentScene != NULL) {
+        currentScene->exit();
+        currentScene = NULL;
+    }
+
     // Free up vram and heap
     FontRenderer_free(fontRenderer);
+    LineRenderer_free(lineRenderer);
+    Memory_free(lineRenderer);
+    lineRenderer = NULL;
+    PostFx_shutdown();
+    Renderer_freeVertexArrays();
     Context_free(context);
+    Memory_free(context);
+    context = NULL;
 
-    free(input);
+    Memory_free(input);
     input = NULL;
+
+    TextureStream_shutdown();
+
+    // anything still referenced by now is a leak, it gets reported here
+    Resources_shutdown();
+    JobSystem_shutdown();
+
+    FrameArena_printStats();
+    FrameArena_shutdown();
+    Archive_unmount();
+
+    // everything should be back by now, whatever isn't gets listed with where it came from
+    Memory_printLeaks();
 }
 
 void DW_tick() {
@@ -180,23 +295,55 @@ void DW_tick() {
     }
 }
 
+// Live, peak and per frame allocation counts for each memory tag, bottom left
+static void DW_drawMemoryPanel() {
+    PostFx_overlay();
+
+    float lineHeight = fontRenderer->charHeight;
+    float y = DISPLAY_HEIGHTF - (MEMORY_TAG_COUNT + 1) * lineHeight - 2.0f;
+    FontRenderer_setColor(fontRenderer, (vec4) { 1.0f, 1.0f, 0.6f, 1.0f });
+    FontRenderer_drawString(fontRenderer, "tag        live KB   peak KB  blocks  allocs/frame", 2.0f, y);
+
+    for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        MemoryStats_t stats;
+        Memory_getStats(tag, &stats);
+        y += lineHeight;
+        FontRenderer_drawString(fontRenderer, FrameArena_printf("%-8s %9.1f %9.1f %7u %7u",
+            Memory_tagName(tag), stats.liveBytes / 1024.0f, stats.peakBytes / 1024.0f, stats.liveCount, stats.frameAllocs), 2.0f, y);
+    }
+}
+
 void DW_render(float partialTicks) {
+    PostFx_begin();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // draw current scene
     if (currentScene != NULL) {
         currentScene->render();
     }
+    if (showMemoryPanel) DW_drawMemoryPanel();
 
+    PostFx_end();
 }
 
 int main(int argc, char **argv) {
-
-    if (DW_initWindow()) return 1;
+    // DW_TRACE=<file.json> prints the startup phases and writes them out as a chrome trace
+    Trace_init();
+    startupBench = getenv("DW_STARTUP_BENCH") != NULL;
+    // ended by DW_firstFrame
+    Trace_begin("startup");
+
+    Trace_begin("DW_initWindow");
+    bool failed = DW_initWindow();
+    Trace_end();
+    if (failed) return 1;
     
+    Trace_begin("DW_initGame");
     DW_initGame();
+    Trace_end();
 
     glfwShowWindow(window);
+    bool presented = false;
 
     uint64_t lastTime = DW_currentTimeMillis();
     uint64_t accumulator = 0;
@@ -207,6 +354,9 @@ int main(int argc, char **argv) {
     glClearColor(.1f, .1f, .1f, 1.0f);
     // Game loop
     while (running) {
+        DW_updateScene();
+        TextureStream_update();
+
         uint64_t currentTime = DW_currentTimeMillis();
         uint64_t deltaTime = currentTime - lastTime;
         lastTime = currentTime;
@@ -227,6 +377,7 @@ int main(int argc, char **argv) {
         // Calculate partial ticks for smooth rendering
         const float partialTicks = (float)accumulator / MS_PER_TICK;
         context->partialTicks = partialTicks;
+        context->frameTime = deltaTime / 1000.0f;
         
         // Render
         DW_render(partialTicks);
@@ -242,11 +393,21 @@ int main(int argc, char **argv) {
             ticks = 0;
 
             lastFPSTime = currentTime;
-            printf("FPS %d TPS %d\n", fps, tps);
+            PostFxTimings_t timings;
+            PostFx_getTimings(&timings);
+            printf("FPS %d TPS %d GPU scene %.2f ms post %.2f ms scale %.2f\n", fps, tps, timings.passMs[POSTFX_PASS_SCENE], timings.postMs, PostFx_renderScale());
 
         }
 
         glfwSwapBuffers(window);
+        if (!presented && currentScene != NULL) {
+            presented = true;
+            DW_firstFrame();
+        }
+        // frees and recycles whatever the GPU is done with
+        Resources_endFrame();
+        FrameArena_endFrame();
+        Memory_endFrame();
         glfwPollEvents();
 
         if (glfwWindowShouldClose(window)) running = false;
@@ -0,0 +1,252 @@
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// in every live header, cleared on free so a double free gets caught
+#define MEMORY_MAGIC 0x444D454Du
+
+typedef struct MemoryHeader MemoryHeader_t;
+
+// sits right in front of the block, 16 bytes of padding keeps the block as aligned as malloc's
+struct MemoryHeader {
+    size_t size;
+    uint32_t tag;
+    uint32_t magic;
+#ifdef MEMORY_TRACK_SITES
+    const char *file;
+    uint32_t line;
+    MemoryHeader_t *prev;
+    MemoryHeader_t *next;
+#endif
+} __attribute__((aligned(16)));
+
+static const char *tagNames_m[MEMORY_TAG_COUNT] = {
+    "engine",
+    "renderer",
+    "font",
+    "scene",
+    "entity",
+    "asset"
+};
+
+static size_t liveBytes_m[MEMORY_TAG_COUNT];
+static size_t peakBytes_m[MEMORY_TAG_COUNT];
+static uint32_t liveCount_m[MEMORY_TAG_COUNT];
+static uint32_t frameAllocs_m[MEMORY_TAG_COUNT];
+static uint32_t lastFrameAllocs_m[MEMORY_TAG_COUNT];
+static uint64_t totalAllocs_m[MEMORY_TAG_COUNT];
+
+#ifdef MEMORY_TRACK_SITES
+// every live block, newest first
+static MemoryHeader_t *liveBlocks_m;
+static pthread_mutex_t liveLock_m = PTHREAD_MUTEX_INITIALIZER;
+
+static void Memory_link(MemoryHeader_t *header, const char *file, int line) {
+    header->file = file;
+    header->line = line;
+    header->prev = NULL;
+
+    pthread_mutex_lock(&liveLock_m);
+    header->next = liveBlocks_m;
+    if (liveBlocks_m != NULL) liveBlocks_m->prev = header;
+    liveBlocks_m = header;
+    pthread_mutex_unlock(&liveLock_m);
+}
+
+static void Memory_unlink(MemoryHeader_t *header) {
+    pthread_mutex_lock(&liveLock_m);
+    if (header->prev != NULL) header->prev->next = header->next;
+    else liveBlocks_m = header->next;
+    if (header->next != NULL) header->next->prev = header->prev;
+    pthread_mutex_unlock(&liveLock_m);
+}
+#else
+static void Memory_link(MemoryHeader_t *header, const char *file, int line) {}
+
+static void Memory_unlink(MemoryHeader_t *header) {}
+#endif
+
+static void Memory_count(uint32_t tag, size_t size) {
+    size_t live = __atomic_add_fetch(&liveBytes_m[tag], size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&liveCount_m[tag], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&frameAllocs_m[tag], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&totalAllocs_m[tag], 1, __ATOMIC_RELAXED);
+
+    size_t peak = __atomic_load_n(&peakBytes_m[tag], __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&peakBytes_m[tag], &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void Memory_uncount(uint32_t tag, size_t size) {
+    __atomic_sub_fetch(&liveBytes_m[tag], size, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&liveCount_m[tag], 1, __ATOMIC_RELAXED);
+}
+
+// NULL (with an error) if ptr isn't a live block of ours
+static MemoryHeader_t* Memory_header(void *ptr) {
+    MemoryHeader_t *header = (MemoryHeader_t*) ptr - 1;
+    if (header->magic != MEMORY_MAGIC || header->tag >= MEMORY_TAG_COUNT) {
+        fprintf(stderr, "Error: %p wasn't allocated by Memory_alloc, or was already freed\n", ptr);
+        return NULL;
+    }
+    return header;
+}
+
+void* Memory_allocAt(MemoryTag_e tag, size_t size, const char *file, int line) {
+    MemoryHeader_t *header = malloc(sizeof(MemoryHeader_t) + size);
+    if (header == NULL) {
+        fprintf(stderr, "Error: Out of memory allocating %zu bytes for %s at %s:%d\n", size, tagNames_m[tag], file, line);
+        return NULL;
+    }
+
+    header->size = size;
+    header->tag = tag;
+    header->magic = MEMORY_MAGIC;
+    Memory_link(header, file, line);
+    Memory_count(tag, size);
+    return header + 1;
+}
+
+void* Memory_callocAt(MemoryTag_e tag, size_t count, size_t size, const char *file, int line) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+
+    void *ptr = Memory_allocAt(tag, count * size, file, line);
+    if (ptr != NULL) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* Memory_reallocAt(MemoryTag_e tag, void *ptr, size_t size, const char *file, int line) {
+    if (ptr == NULL) return Memory_allocAt(tag, size, file, line);
+
+    MemoryHeader_t *header = Memory_header(ptr);
+    if (header == NULL) return NULL;
+
+    // out of the list while it might move, back in under the new call site
+    uint32_t oldTag = header->tag;
+    size_t oldSize = header->size;
+    Memory_unlink(header);
+
+    MemoryHeader_t *moved = realloc(header, sizeof(MemoryHeader_t) + size);
+    if (moved == NULL) {
+        fprintf(stderr, "Error: Out of memory growing %zu bytes to %zu for %s at %s:%d\n", oldSize, size, tagNames_m[oldTag], file, line);
+        Memory_link(header, file, line);
+        return NULL;
+    }
+
+    moved->size = size;
+    Memory_link(moved, file, line);
+    Memory_uncount(oldTag, oldSize);
+    Memory_count(oldTag, size);
+    return moved + 1;
+}
+
+char* Memory_strdupAt(MemoryTag_e tag, const char *str, const char *file, int line) {
+    size_t size = strlen(str) + 1;
+    char *copy = Memory_allocAt(tag, size, file, line);
+    if (copy != NULL) memcpy(copy, str, size);
+    return copy;
+}
+
+void Memory_free(void *ptr) {
+    if (ptr == NULL) return;
+
+    MemoryHeader_t *header = Memory_header(ptr);
+    if (header == NULL) return;
+
+    Memory_unlink(header);
+    Memory_uncount(header->tag, header->size);
+    header->magic = 0;
+    free(header);
+}
+
+const char* Memory_tagName(MemoryTag_e tag) {
+    return tag < MEMORY_TAG_COUNT ? tagNames_m[tag] : "?";
+}
+
+void Memory_getStats(MemoryTag_e tag, MemoryStats_t *stats) {
+    stats->liveBytes = __atomic_load_n(&liveBytes_m[tag], __ATOMIC_RELAXED);
+    stats->peakBytes = __atomic_load_n(&peakBytes_m[tag], __ATOMIC_RELAXED);
+    stats->liveCount = __atomic_load_n(&liveCount_m[tag], __ATOMIC_RELAXED);
+    stats->frameAllocs = lastFrameAllocs_m[tag];
+    stats->totalAllocs = __atomic_load_n(&totalAllocs_m[tag], __ATOMIC_RELAXED);
+}
+
+void Memory_endFrame() {
+    for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        lastFrameAllocs_m[tag] = __atomic_exchange_n(&frameAllocs_m[tag], 0, __ATOMIC_RELAXED);
+    }
+}
+
+#ifdef MEMORY_TRACK_SITES
+// call sites listed at most, the biggest ones come first
+#define MEMORY_MAX_LEAK_SITES 32
+
+typedef struct {
+    const char *file;
+    uint32_t line;
+    uint32_t tag;
+    uint32_t count;
+    size_t bytes;
+} MemoryLeakSite_t;
+
+static int compareLeakSites(const void *a, const void *b) {
+    const MemoryLeakSite_t *siteA = a;
+    const MemoryLeakSite_t *siteB = b;
+    return siteA->bytes < siteB->bytes ? 1 : siteA->bytes > siteB->bytes ? -1 : 0;
+}
+
+static void Memory_printLeakSites() {
+    MemoryLeakSite_t sites[MEMORY_MAX_LEAK_SITES];
+    uint32_t siteCount = 0;
+    uint32_t droppedBlocks = 0;
+
+    pthread_mutex_lock(&liveLock_m);
+    for (MemoryHeader_t *header = liveBlocks_m; header != NULL; header = header->next) {
+        uint32_t s = 0;
+        while (s < siteCount && (sites[s].line != header->line || sites[s].tag != header->tag || strcmp(sites[s].file, header->file) != 0)) s++;
+        if (s == siteCount) {
+            if (siteCount == MEMORY_MAX_LEAK_SITES) {
+                droppedBlocks++;
+                continue;
+            }
+            sites[siteCount++] = (MemoryLeakSite_t) { header->file, header->line, header->tag, 0, 0 };
+        }
+        sites[s].count++;
+        sites[s].bytes += header->size;
+    }
+    pthread_mutex_unlock(&liveLock_m);
+
+    qsort(sites, siteCount, sizeof(MemoryLeakSite_t), compareLeakSites);
+    for (uint32_t s = 0; s < siteCount; s++) {
+        printf("  %-8s %s:%u  %u blocks, %zu bytes\n", tagNames_m[sites[s].tag], sites[s].file, sites[s].line, sites[s].count, sites[s].bytes);
+    }
+    if (droppedBlocks > 0) printf("  and %u blocks from other places\n", droppedBlocks);
+}
+#endif
+
+bool Memory_printLeaks() {
+    bool leaked = false;
+    for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        if (__atomic_load_n(&liveCount_m[tag], __ATOMIC_RELAXED) > 0) leaked = true;
+    }
+
+    if (!leaked) {
+        printf("Memory: no leaks\n");
+        return false;
+    }
+
+    printf("Memory: still allocated at exit\n");
+    for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        MemoryStats_t stats;
+        Memory_getStats(tag, &stats);
+        if (stats.liveCount == 0) continue;
+        printf("  %-8s %u blocks, %zu bytes (peak %zu)\n", tagNames_m[tag], stats.liveCount, stats.liveBytes, stats.peakBytes);
+    }
+#ifdef MEMORY_TRACK_SITES
+    printf("By call site:\n");
+    Memory_printLeakSites();
+#endif
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// debug builds remember where every live block came from, for the leak report
+#ifndef NDEBUG
+#define MEMORY_TRACK_SITES
+#endif
+
+// which part of the engine an allocation is charged to
+typedef enum {
+    MEMORY_TAG_ENGINE,
+    MEMORY_TAG_RENDERER,
+    MEMORY_TAG_FONT,
+    MEMORY_TAG_SCENE,
+    MEMORY_TAG_ENTITY,
+    MEMORY_TAG_ASSET,
+    MEMORY_TAG_COUNT
+} MemoryTag_e;
+
+typedef struct {
+    size_t liveBytes;
+    size_t peakBytes;
+    uint32_t liveCount;
+    // allocations (reallocs included) during the last finished frame
+    uint32_t frameAllocs;
+    uint64_t totalAllocs;
+} MemoryStats_t;
+
+/**
+ * Heap allocations that know what they're for. Every block carries a small header
+ * with its size and tag, so live and peak bytes can be kept per tag, and with
+ * MEMORY_TRACK_SITES the file and line it was allocated from too. Anything still
+ * live at Memory_printLeaks gets reported by call site.
+ *
+ * Blocks from here have to go back through Memory_free, and never to plain free,
+ * so pointers that get handed to stb (which frees with free) stay on malloc.
+ * Safe from any thread.
+ */
+void* Memory_allocAt(MemoryTag_e tag, size_t size, const char *file, int line);
+
+void* Memory_callocAt(MemoryTag_e tag, size_t count, size_t size, const char *file, int line);
+
+// NULL ptr allocates, the block keeps the tag it was allocated with
+void* Memory_reallocAt(MemoryTag_e tag, void *ptr, size_t size, const char *file, int line);
+
+char* Memory_strdupAt(MemoryTag_e tag, const char *str, const char *file, int line);
+
+#define Memory_alloc(tag, size) Memory_allocAt(tag, size, __FILE__, __LINE__)
+#define Memory_calloc(tag, count, size) Memory_callocAt(tag, count, size, __FILE__, __LINE__)
+#define Memory_realloc(tag, ptr, size) Memory_reallocAt(tag, ptr, size, __FILE__, __LINE__)
+#define Memory_strdup(tag, str) Memory_strdupAt(tag, str, __FILE__, __LINE__)
+
+// NULL is fine
+void Memory_free(void *ptr);
+
+const char* Memory_tagName(MemoryTag_e tag);
+
+void Memory_getStats(MemoryTag_e tag, MemoryStats_t *stats);
+
+// Starts counting the next frame's allocations, main thread once a frame
+void Memory_endFrame();
+
+// Per tag totals of whatever is still live, and where it came from. True if there was any
+bool Memory_printLeaks();
+
+#endif
@@ -0,0 +1,203 @@
+#include <string.h>
+#include <stddef.h>
+
+#include "particles.h"
+#include "util.h"
+#include "memory.h"
+
+// SSBO binding points, shared by all the particle shaders
+#define BINDING_PARTICLES 0
+#define BINDING_FREE_LIST 1
+#define BINDING_ALIVE_LIST 2
+#define BINDING_COUNTERS 3
+#define BINDING_EMITTERS 4
+#define BINDING_ALIVE_INPUT 5
+
+// Pooled buffers come back with whatever was in them, anything that matters gets filled in.
+// Leaves it bound to GL_SHADER_STORAGE_BUFFER
+static GLuint ParticleSystem_createBuffer(BufferHandle_t *handle, size_t size, GLenum usage, void *data) {
+    *handle = Resources_acquireBuffer(size, usage);
+    GLuint buffer = Resources_bufferName(*handle);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    if (data != NULL) glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+    return buffer;
+}
+
+void ParticleSystem_init(ParticleSystem_t *ps, Context_t *context, uint32_t maxParticles) {
+    memset(ps, 0, sizeof(ParticleSystem_t));
+    ps->context = context;
+    Pcg32_init(&ps->rng, Rng_streamSeed(RNG_STREAM_PARTICLES, 0), 0);
+    ps->maxParticles = maxParticles;
+    glm_vec2_copy((vec2) { 0.0f, -200.0f }, ps->gravity);
+
+    // cached by the resource manager, so coming back to the scene doesn't recompile them
+    ps->programs[0] = Resources_loadComputeProgram("assets/particle_emit.cs.glsl");
+    ps->programs[1] = Resources_loadComputeProgram("assets/particle_prepare.cs.glsl");
+    ps->programs[2] = Resources_loadComputeProgram("assets/particle_update.cs.glsl");
+    ps->programs[3] = Resources_loadProgram("assets/particle.vs.glsl", "assets/particle.fs.glsl");
+    ps->emitShader = Resources_programName(ps->programs[0]);
+    ps->prepareShader = Resources_programName(ps->programs[1]);
+    ps->updateShader = Resources_programName(ps->programs[2]);
+    ps->renderShader = Resources_programName(ps->programs[3]);
+
+    // every slot starts dead (life = 0)
+    ps->particleSsbo = ParticleSystem_createBuffer(&ps->buffers[0], maxParticles * sizeof(Particle_t), GL_DYNAMIC_DRAW, NULL);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, NULL);
+
+    // free list is full to begin with, freeCount followed by the indices
+    size_t freeListSize = sizeof(int32_t) + maxParticles * sizeof(uint32_t);
+    uint32_t *freeList = Memory_alloc(MEMORY_TAG_RENDERER, freeListSize);
+    freeList[0] = maxParticles;
+    for (uint32_t i = 0; i < maxParticles; i++) {
+        freeList[i + 1] = i;
+    }
+
+    ps->freeListSsbo = ParticleSystem_createBuffer(&ps->buffers[1], freeListSize, GL_DYNAMIC_DRAW, freeList);
+    Memory_free(freeList);
+
+    ps->aliveListSsbos[0] = ParticleSystem_createBuffer(&ps->buffers[2], maxParticles * sizeof(uint32_t), GL_DYNAMIC_DRAW, NULL);
+    ps->aliveListSsbos[1] = ParticleSystem_createBuffer(&ps->buffers[3], maxParticles * sizeof(uint32_t), GL_DYNAMIC_DRAW, NULL);
+
+    // 4 vertex triangle strip per instance, nothing alive yet so nothing to draw or update
+    ParticleCounters_t counters = { .vertexCount = 4, .groups = { 0, 1, 1 } };
+    ps->counterBuffer = ParticleSystem_createBuffer(&ps->buffers[4], sizeof(counters), GL_DYNAMIC_DRAW, &counters);
+
+    ps->emitterSsbo = ParticleSystem_createBuffer(&ps->buffers[5], PARTICLE_MAX_EMITTERS * sizeof(EmitterGPU_t), GL_STREAM_DRAW, NULL);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ParticleSystem_createVertexArray(ParticleSystem_t *ps) {
+    // no attributes, the vertex shader reads straight from the SSBOs
+    ps->vertexArray = Resources_createVertexArray();
+    ps->vao = Resources_vertexArrayName(ps->vertexArray);
+}
+
+ParticleEmitter_t* ParticleSystem_addEmitter(ParticleSystem_t *ps) {
+    // reuse an inactive slot first
+    for (uint32_t i = 0; i < ps->emitterCount; i++) {
+        if (!ps->emitters[i].active) {
+            memset(&ps->emitters[i], 0, sizeof(ParticleEmitter_t));
+            ps->emitters[i].active = true;
+            return &ps->emitters[i];
+        }
+    }
+
+    if (ps->emitterCount >= PARTICLE_MAX_EMITTERS) {
+        fprintf(stderr, "Error: Particle system is out of emitters (max %d).\n", PARTICLE_MAX_EMITTERS);
+        return NULL;
+    }
+
+    ParticleEmitter_t *emitter = &ps->emitters[ps->emitterCount++];
+    memset(emitter, 0, sizeof(ParticleEmitter_t));
+    emitter->active = true;
+    return emitter;
+}
+
+void ParticleSystem_removeEmitter(ParticleSystem_t *ps, ParticleEmitter_t *emitter) {
+    emitter->active = false;
+}
+
+void ParticleSystem_burst(ParticleSystem_t *ps, ParticleEmitter_t *emitter, uint32_t count) {
+    emitter->pendingBurst += count;
+}
+
+void ParticleSystem_update(ParticleSystem_t *ps, float dt) {
+    // work out how many each emitter spawns this frame, this is the only per-emitter CPU work
+    EmitterGPU_t gpuEmitters[PARTICLE_MAX_EMITTERS];
+    uint32_t gpuCount = 0;
+    uint32_t spawnTotal = 0;
+
+    for (uint32_t i = 0; i < ps->emitterCount; i++) {
+        ParticleEmitter_t *em = &ps->emitters[i];
+        if (!em->active) continue;
+
+        em->accumulator += em->rate * dt;
+        uint32_t spawn = (uint32_t) em->accumulator + em->pendingBurst;
+        em->accumulator -= (uint32_t) em->accumulator;
+        em->pendingBurst = 0;
+
+        if (spawn == 0) continue;
+
+        EmitterGPU_t *gpu = &gpuEmitters[gpuCount++];
+        glm_vec4_copy(em->color, gpu->color);
+        glm_vec2_copy(em->pos, gpu->pos);
+        glm_vec2_copy(em->velocity, gpu->velocity);
+        glm_vec2_copy(em->spread, gpu->spread);
+        gpu->life = em->life;
+        gpu->size = em->size;
+        gpu->spawnOffset = spawnTotal;
+        gpu->spawnCount = spawn;
+        spawnTotal += spawn;
+    }
+
+    // last frame's output is this frame's input
+    ps->aliveOutput ^= 1;
+    GLuint aliveInput = ps->aliveListSsbos[ps->aliveOutput ^ 1];
+    GLuint aliveOutput = ps->aliveListSsbos[ps->aliveOutput];
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_PARTICLES, ps->particleSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_FREE_LIST, ps->freeListSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_ALIVE_LIST, aliveOutput);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_COUNTERS, ps->counterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_EMITTERS, ps->emitterSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_ALIVE_INPUT, aliveInput);
+
+    if (spawnTotal > 0) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ps->emitterSsbo);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpuCount * sizeof(EmitterGPU_t), gpuEmitters);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glUseProgram(ps->emitShader);
+        glUniform1ui(glGetUniformLocation(ps->emitShader, "spawnTotal"), spawnTotal);
+        glUniform1ui(glGetUniformLocation(ps->emitShader, "emitterCount"), gpuCount);
+        glUniform1ui(glGetUniformLocation(ps->emitShader, "seed"), Pcg32_next(&ps->rng));
+        glDispatchCompute((spawnTotal + PARTICLE_GROUP_SIZE - 1) / PARTICLE_GROUP_SIZE, 1, 1);
+
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // sizes the update to what's alive plus what just spawned, and resets the counts,
+    // so the CPU never has to know how many particles there are
+    glUseProgram(ps->prepareShader);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    glUseProgram(ps->updateShader);
+    glUniform1f(glGetUniformLocation(ps->updateShader, "dt"), dt);
+    glUniform2f(glGetUniformLocation(ps->updateShader, "gravity"), ps->gravity[0], ps->gravity[1]);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ps->counterBuffer);
+    glDispatchComputeIndirect(offsetof(ParticleCounters_t, groups));
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    // the draw reads both the SSBOs and the indirect command
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void ParticleSystem_render(ParticleSystem_t *ps) {
+    glUseProgram(ps->renderShader);
+    glBindVertexArray(ps->vao);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_PARTICLES, ps->particleSsbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_ALIVE_LIST, ps->aliveListSsbos[ps->aliveOutput]);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ps->counterBuffer);
+
+    glUniformMatrix4fv(glGetUniformLocation(ps->renderShader, "projection"), 1, GL_FALSE, (float*) &ps->context->projectionMatrix);
+    glUniformMatrix4fv(glGetUniformLocation(ps->renderShader, "model"), 1, GL_FALSE, (float*) MatrixStack_peek(ps->context->matrixStack));
+
+    glDrawArraysIndirect(GL_TRIANGLE_STRIP, NULL);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void ParticleSystem_free(ParticleSystem_t *ps) {
+    for (int i = 0; i < 6; i++) {
+        Resources_releaseBuffer(ps->buffers[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        Resources_releaseProgram(ps->programs[i]);
+    }
+    Resources_releaseVertexArray(ps->vertexArray);
+}
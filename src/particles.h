@@ -0,0 +1,129 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "renderer.h"
+#include "rng.h"
+
+#define PARTICLE_MAX_EMITTERS 64
+// threads per compute work group, must match local_size_x in the shaders
+#define PARTICLE_GROUP_SIZE 256
+
+// GPU side particle, matches the std430 layout in particle.*.glsl
+typedef struct {
+    vec2 pos;
+    vec2 velocity;
+    vec4 color;
+    float age;
+    // <= 0 means the slot is dead
+    float life;
+    float size;
+    float pad;
+} Particle_t;
+
+// GPU side emitter for the spawn pass, std430 layout
+typedef struct {
+    vec4 color;
+    vec2 pos;
+    vec2 velocity;
+    vec2 spread;
+    float life;
+    float size;
+    uint32_t spawnOffset;
+    uint32_t spawnCount;
+    float pad[2];
+} EmitterGPU_t;
+
+// counter buffer layout, matches the Counters block in particle_*.cs.glsl
+typedef struct {
+    // DrawArraysIndirectCommand
+    uint32_t vertexCount;
+    uint32_t instanceCount;
+    uint32_t first;
+    uint32_t baseInstance;
+    // DispatchIndirectCommand for the update pass
+    uint32_t groups[3];
+    uint32_t spawned;
+    uint32_t inputCount;
+} ParticleCounters_t;
+
+/**
+ * CPU side emitter, this is all the CPU ever touches. Spawning, integration
+ * and rendering of the particles themselves all happen on the GPU.
+ */
+typedef struct {
+    bool active;
+    vec2 pos;
+    // base velocity in units per second, spread is a random +/- added on top
+    vec2 velocity;
+    vec2 spread;
+    vec4 color;
+    // particles per second, 0 for burst only emitters
+    float rate;
+    float life;
+    float size;
+
+    // fractional particles left over from last frame
+    float accumulator;
+    // one-shot spawns queued with ParticleSystem_burst
+    uint32_t pendingBurst;
+} ParticleEmitter_t;
+
+typedef struct {
+    uint32_t maxParticles;
+    vec2 gravity;
+
+    ParticleEmitter_t emitters[PARTICLE_MAX_EMITTERS];
+    uint32_t emitterCount;
+
+    // particles, free list (count + indices), two alive lists, counters, emitters
+    GLuint particleSsbo;
+    GLuint freeListSsbo;
+    // swapped every update, one is last frame's survivors (plus spawns), the update
+    // pass writes this frame's into the other, which is the one that gets drawn
+    GLuint aliveListSsbos[2];
+    uint32_t aliveOutput;
+    // indirect draw command, then the update's indirect dispatch and the list counts
+    GLuint counterBuffer;
+    GLuint emitterSsbo;
+    // owns the buffers above, same order
+    BufferHandle_t buffers[6];
+
+    GLuint emitShader;
+    GLuint prepareShader;
+    GLuint updateShader;
+    GLuint renderShader;
+    ProgramHandle_t programs[4];
+    // empty vao, everything comes out of the SSBOs
+    GLuint vao;
+    VertexArrayHandle_t vertexArray;
+
+    // seeds each emit dispatch, from the particle stream so runs replay the same
+    Pcg32_t rng;
+    Context_t *context;
+} ParticleSystem_t;
+
+// Makes the buffers and shaders, fine to call from the loader thread. Only memory scales with
+// maxParticles, the prepare pass sizes the update's dispatch to the live count. Size it for
+// the most that are ever alive at once
+void ParticleSystem_init(ParticleSystem_t *ps, Context_t *context, uint32_t maxParticles);
+
+// Has to happen on the main thread before the first render, VAOs aren't shared between contexts
+void ParticleSystem_createVertexArray(ParticleSystem_t *ps);
+
+// Returns a zeroed, active emitter owned by the system or NULL if we're out
+ParticleEmitter_t* ParticleSystem_addEmitter(ParticleSystem_t *ps);
+
+void ParticleSystem_removeEmitter(ParticleSystem_t *ps, ParticleEmitter_t *emitter);
+
+// Queues count particles to spawn from the emitter on the next update
+void ParticleSystem_burst(ParticleSystem_t *ps, ParticleEmitter_t *emitter, uint32_t count);
+
+// Spawns and simulates on the GPU, dt is in seconds
+void ParticleSystem_update(ParticleSystem_t *ps, float dt);
+
+// One indirect draw for every live particle
+void ParticleSystem_render(ParticleSystem_t *ps);
+
+void ParticleSystem_free(ParticleSystem_t *ps);
+
+#endif
@@ -0,0 +1,140 @@
+#include "physics.h"
+
+#include <cglm/simd/intrin.h>
+
+// The kernels rely on pos and prevPos sitting next to each other in GameObj_t,
+// so both can be loaded/stored as a single 4 float vector.
+//
+// min/max are written as ternaries that match the x86 minps/maxps semantics,
+// and gravity is selected with a mask instead of multiplied in, that way
+// every path does the exact same float ops in the same order.
+
+static inline float scalarMax(float a, float b) {
+    return a > b ? a : b;
+}
+
+static inline float scalarMin(float a, float b) {
+    return a < b ? a : b;
+}
+
+static inline void integrateOne(GameObj_t *obj, const PhysicsParams_t *p) {
+    for (int i = 0; i < 2; i++) {
+        float v = obj->velocity[i];
+        if (v > -p->terminalVelocity[i]) {
+            v = v + p->gravity[i];
+        }
+        v = scalarMax(v, -p->maxVelocity[i]);
+        v = scalarMin(v, p->maxVelocity[i]);
+
+        obj->velocity[i] = v;
+        obj->prevPos[i] = obj->pos[i];
+        obj->pos[i] = obj->pos[i] + v;
+    }
+}
+
+void Physics_integrateScalar(GameObj_t *objs, size_t count, const PhysicsParams_t *params) {
+    for (size_t i = 0; i < count; i++) {
+        integrateOne(&objs[i], params);
+    }
+}
+
+#if defined(CGLM_SSE2_FP)
+
+// [x y] in the low half, zeroes in the high half
+static inline __m128 loadVec2(const float *v) {
+    return _mm_castpd_ps(_mm_load_sd((const double*) v));
+}
+
+static inline __m128 stepVelocity(__m128 v, __m128 gravity, __m128 negTerminal, __m128 minVel, __m128 maxVel) {
+    __m128 applyMask = _mm_cmpgt_ps(v, negTerminal);
+    __m128 withGravity = _mm_add_ps(v, gravity);
+    v = _mm_or_ps(_mm_and_ps(applyMask, withGravity), _mm_andnot_ps(applyMask, v));
+    // operand order matters here to match scalarMax/scalarMin
+    v = _mm_max_ps(v, minVel);
+    return _mm_min_ps(v, maxVel);
+}
+
+void Physics_integrate(GameObj_t *objs, size_t count, const PhysicsParams_t *params) {
+    const PhysicsParams_t *p = params;
+    size_t i = 0;
+
+#if defined(CGLM_AVX_FP)
+    // two objects per iteration, one per 128 bit lane
+    __m256 gravity8 = _mm256_setr_ps(p->gravity[0], p->gravity[1], 0.0f, 0.0f, p->gravity[0], p->gravity[1], 0.0f, 0.0f);
+    __m256 negTerminal8 = _mm256_setr_ps(-p->terminalVelocity[0], -p->terminalVelocity[1], 0.0f, 0.0f,
+                                         -p->terminalVelocity[0], -p->terminalVelocity[1], 0.0f, 0.0f);
+    __m256 minVel8 = _mm256_setr_ps(-p->maxVelocity[0], -p->maxVelocity[1], 0.0f, 0.0f, -p->maxVelocity[0], -p->maxVelocity[1], 0.0f, 0.0f);
+    __m256 maxVel8 = _mm256_setr_ps(p->maxVelocity[0], p->maxVelocity[1], 0.0f, 0.0f, p->maxVelocity[0], p->maxVelocity[1], 0.0f, 0.0f);
+
+    for (; i + 2 <= count; i += 2) {
+        GameObj_t *a = &objs[i];
+        GameObj_t *b = &objs[i + 1];
+
+        __m256 pos = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a->pos)), _mm_loadu_ps(b->pos), 1);
+        __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(loadVec2(a->velocity)), loadVec2(b->velocity), 1);
+
+        __m256 applyMask = _mm256_cmp_ps(v, negTerminal8, _CMP_GT_OQ);
+        v = _mm256_blendv_ps(v, _mm256_add_ps(v, gravity8), applyMask);
+        v = _mm256_min_ps(_mm256_max_ps(v, minVel8), maxVel8);
+
+        // [newPos, oldPos] in each lane
+        __m256 newPos = _mm256_add_ps(pos, v);
+        __m256 out = _mm256_shuffle_ps(newPos, pos, _MM_SHUFFLE(1, 0, 1, 0));
+
+        _mm_storeu_ps(a->pos, _mm256_castps256_ps128(out));
+        _mm_storeu_ps(b->pos, _mm256_extractf128_ps(out, 1));
+        _mm_storel_pi((__m64*) a->velocity, _mm256_castps256_ps128(v));
+        _mm_storel_pi((__m64*) b->velocity, _mm256_extractf128_ps(v, 1));
+    }
+#endif
+
+    __m128 gravity = _mm_setr_ps(p->gravity[0], p->gravity[1], 0.0f, 0.0f);
+    __m128 negTerminal = _mm_setr_ps(-p->terminalVelocity[0], -p->terminalVelocity[1], 0.0f, 0.0f);
+    __m128 minVel = _mm_setr_ps(-p->maxVelocity[0], -p->maxVelocity[1], 0.0f, 0.0f);
+    __m128 maxVel = _mm_setr_ps(p->maxVelocity[0], p->maxVelocity[1], 0.0f, 0.0f);
+
+    for (; i < count; i++) {
+        GameObj_t *obj = &objs[i];
+
+        __m128 pos = _mm_loadu_ps(obj->pos);
+        __m128 v = stepVelocity(loadVec2(obj->velocity), gravity, negTerminal, minVel, maxVel);
+
+        __m128 newPos = _mm_add_ps(pos, v);
+        _mm_storeu_ps(obj->pos, _mm_movelh_ps(newPos, pos));
+        _mm_storel_pi((__m64*) obj->velocity, v);
+    }
+}
+
+#elif defined(CGLM_NEON_FP)
+
+void Physics_integrate(GameObj_t *objs, size_t count, const PhysicsParams_t *params) {
+    const PhysicsParams_t *p = params;
+
+    float32x2_t gravity = vld1_f32(p->gravity);
+    float32x2_t maxVel = vld1_f32(p->maxVelocity);
+    float32x2_t minVel = vneg_f32(maxVel);
+    float32x2_t negTerminal = vneg_f32(vld1_f32(p->terminalVelocity));
+
+    for (size_t i = 0; i < count; i++) {
+        GameObj_t *obj = &objs[i];
+
+        float32x4_t pos = vld1q_f32(obj->pos);
+        float32x2_t v = vld1_f32(obj->velocity);
+
+        uint32x2_t applyMask = vcgt_f32(v, negTerminal);
+        v = vbsl_f32(applyMask, vadd_f32(v, gravity), v);
+        v = vmin_f32(vmax_f32(v, minVel), maxVel);
+
+        float32x2_t oldPos = vget_low_f32(pos);
+        vst1q_f32(obj->pos, vcombine_f32(vadd_f32(oldPos, v), oldPos));
+        vst1_f32(obj->velocity, v);
+    }
+}
+
+#else
+
+void Physics_integrate(GameObj_t *objs, size_t count, const PhysicsParams_t *params) {
+    Physics_integrateScalar(objs, count, params);
+}
+
+#endif
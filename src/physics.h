@@ -0,0 +1,30 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <stddef.h>
+
+#include "engine.h"
+
+// Parameters shared by every object integrated in one batch
+typedef struct {
+    // velocity added every tick
+    vec2 gravity;
+    // gravity is only applied to an axis while the velocity on that axis
+    // is still above -terminalVelocity (ie. we haven't hit max fall speed yet)
+    vec2 terminalVelocity;
+    // after gravity, velocity is clamped to [-maxVelocity, maxVelocity]
+    vec2 maxVelocity;
+} PhysicsParams_t;
+
+/**
+ * Steps an array of game objects forward by one tick:
+ * gravity, velocity clamping, prevPos = pos (for DW_lerp), pos += velocity.
+ * Uses AVX, SSE2 or NEON depending on what we were compiled with,
+ * results are bit-identical to Physics_integrateScalar for finite values.
+ */
+void Physics_integrate(GameObj_t *objs, size_t count, const PhysicsParams_t *params);
+
+// Plain C version of the same step, always available for reference/testing
+void Physics_integrateScalar(GameObj_t *objs, size_t count, const PhysicsParams_t *params);
+
+#endif
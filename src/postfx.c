@@ -0,0 +1,415 @@
+#include "postfx.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#include "renderer.h"
+#include "resources.h"
+
+typedef struct {
+    TextureHandle_t texture;
+    GLuint fbo;
+    uint32_t width;
+    uint32_t height;
+} PostFxTarget_t;
+
+static PostFxSettings_t postFxSettings_m = {
+    .enabled = true,
+    .bloom = true,
+    .bloomScale = 2,
+    .threshold = 0.7f,
+    .knee = 0.2f,
+    .bloomStrength = 0.6f,
+    .curvature = 0.04f,
+    .scanlineStrength = 0.25f,
+    .scanlineCount = 240.0f,
+    .chromatic = 0.004f,
+    .vignette = 0.25f,
+    .dynamicResolution = true,
+    .targetFrameMs = 14.0f,
+    .minScale = 0.5f,
+    .maxScale = 1.0f,
+    .sharpen = 0.25f
+};
+
+static PostFxTarget_t sceneTarget_m;
+// always native size, cleared to transparent when a frame uses it
+static PostFxTarget_t overlayTarget_m;
+// ping-pong pair at bloom resolution, the blurred result always ends up in [0]
+static PostFxTarget_t bloomTargets_m[2];
+static uint32_t bloomScale_m;
+
+// the scene only fills sceneWidth_m x sceneHeight_m of its target, from the bottom left
+static float renderScale_m = 1.0f;
+static uint32_t sceneWidth_m;
+static uint32_t sceneHeight_m;
+static bool overlayActive_m;
+// where the composite goes, the window unless something else asked
+static GLuint outputFramebuffer_m = 0;
+
+static VertexArrayHandle_t postFxVertexArray_m;
+static ProgramHandle_t brightProgram_m;
+static ProgramHandle_t blurProgram_m;
+static ProgramHandle_t crtProgram_m;
+
+static GLint brightTapOffsetLoc_m;
+static GLint brightThresholdLoc_m;
+static GLint brightKneeLoc_m;
+static GLint brightUvScaleLoc_m;
+static GLint brightUvMaxLoc_m;
+static GLint brightOverlayAmountLoc_m;
+static GLint blurDirectionLoc_m;
+static GLint crtBloomStrengthLoc_m;
+static GLint crtCurvatureLoc_m;
+static GLint crtScanlineStrengthLoc_m;
+static GLint crtScanlineCountLoc_m;
+static GLint crtChromaticLoc_m;
+static GLint crtVignetteLoc_m;
+static GLint crtUvScaleLoc_m;
+static GLint crtUvMaxLoc_m;
+static GLint crtSceneTexelLoc_m;
+static GLint crtSharpenLoc_m;
+static GLint crtOverlayAmountLoc_m;
+
+// [0] is taken at PostFx_begin, [pass + 1] when the pass is done
+static GLuint timerQueries_m[POSTFX_TIMER_FRAMES][POSTFX_PASS_TOTAL + 1];
+// which of those were written for a frame, 0 if it wasn't timed
+static uint32_t timerMasks_m[POSTFX_TIMER_FRAMES];
+// render scale each slot was drawn at
+static float timerScales_m[POSTFX_TIMER_FRAMES];
+static uint64_t postFxFrame_m;
+static PostFxTimings_t postFxTimings_m;
+
+static const char *postFxPassNames[POSTFX_PASS_TOTAL] = { "scene", "overlay", "bright", "blur h", "blur v", "composite" };
+
+static void PostFxTarget_create(PostFxTarget_t *target, uint32_t width, uint32_t height) {
+    target->width = width;
+    target->height = height;
+
+    target->texture = Resources_acquireTexture(width, height, GL_RGBA8, 1);
+    DW_setTextureParams();
+    // the blur and the curvature read past the edges
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // FBOs aren't shared between contexts, so they stay out of the resource manager
+    glGenFramebuffers(1, &target->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Resources_textureName(target->texture), 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Error: Post processing target %ux%u is incomplete.\n", width, height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static void PostFxTarget_free(PostFxTarget_t *target) {
+    glDeleteFramebuffers(1, &target->fbo);
+    Resources_releaseTexture(target->texture);
+    target->fbo = 0;
+    target->texture.id = 0;
+}
+
+static void createBloomTargets() {
+    uint32_t scale = postFxSettings_m.bloomScale >= 4 ? 4 : 2;
+    uint32_t width = (sceneTarget_m.width + scale - 1) / scale;
+    uint32_t height = (sceneTarget_m.height + scale - 1) / scale;
+
+    for (int i = 0; i < 2; i++) {
+        PostFxTarget_create(&bloomTargets_m[i], width, height);
+    }
+    bloomScale_m = scale;
+}
+
+void PostFx_init(uint32_t width, uint32_t height) {
+    PostFxTarget_create(&sceneTarget_m, width, height);
+    PostFxTarget_create(&overlayTarget_m, width, height);
+    createBloomTargets();
+    renderScale_m = 1.0f;
+
+    postFxVertexArray_m = Resources_createVertexArray();
+
+    brightProgram_m = Resources_loadProgram("assets/fullscreen.vs.glsl", "assets/bright.fs.glsl");
+    blurProgram_m = Resources_loadProgram("assets/fullscreen.vs.glsl", "assets/blur.fs.glsl");
+    crtProgram_m = Resources_loadProgram("assets/fullscreen.vs.glsl", "assets/crt.fs.glsl");
+
+    GLuint bright = Resources_programName(brightProgram_m);
+    glUseProgram(bright);
+    glUniform1i(glGetUniformLocation(bright, "source"), 0);
+    glUniform1i(glGetUniformLocation(bright, "overlay"), 1);
+    brightUvScaleLoc_m = glGetUniformLocation(bright, "uvScale");
+    brightUvMaxLoc_m = glGetUniformLocation(bright, "uvMax");
+    brightOverlayAmountLoc_m = glGetUniformLocation(bright, "overlayAmount");
+    brightTapOffsetLoc_m = glGetUniformLocation(bright, "tapOffset");
+    brightThresholdLoc_m = glGetUniformLocation(bright, "threshold");
+    brightKneeLoc_m = glGetUniformLocation(bright, "knee");
+
+    GLuint blur = Resources_programName(blurProgram_m);
+    glUseProgram(blur);
+    glUniform1i(glGetUniformLocation(blur, "source"), 0);
+    blurDirectionLoc_m = glGetUniformLocation(blur, "direction");
+
+    GLuint crt = Resources_programName(crtProgram_m);
+    glUseProgram(crt);
+    glUniform1i(glGetUniformLocation(crt, "scene"), 0);
+    glUniform1i(glGetUniformLocation(crt, "bloom"), 1);
+    glUniform1i(glGetUniformLocation(crt, "overlay"), 2);
+    crtUvScaleLoc_m = glGetUniformLocation(crt, "uvScale");
+    crtUvMaxLoc_m = glGetUniformLocation(crt, "uvMax");
+    crtSceneTexelLoc_m = glGetUniformLocation(crt, "sceneTexel");
+    crtSharpenLoc_m = glGetUniformLocation(crt, "sharpen");
+    crtOverlayAmountLoc_m = glGetUniformLocation(crt, "overlayAmount");
+    crtBloomStrengthLoc_m = glGetUniformLocation(crt, "bloomStrength");
+    crtCurvatureLoc_m = glGetUniformLocation(crt, "curvature");
+    crtScanlineStrengthLoc_m = glGetUniformLocation(crt, "scanlineStrength");
+    crtScanlineCountLoc_m = glGetUniformLocation(crt, "scanlineCount");
+    crtChromaticLoc_m = glGetUniformLocation(crt, "chromatic");
+    crtVignetteLoc_m = glGetUniformLocation(crt, "vignette");
+    glUseProgram(0);
+
+    glGenQueries(POSTFX_TIMER_FRAMES * (POSTFX_PASS_TOTAL + 1), &timerQueries_m[0][0]);
+    for (int i = 0; i < POSTFX_TIMER_FRAMES; i++) {
+        timerMasks_m[i] = 0;
+    }
+    postFxFrame_m = 0;
+}
+
+void PostFx_shutdown() {
+    glDeleteQueries(POSTFX_TIMER_FRAMES * (POSTFX_PASS_TOTAL + 1), &timerQueries_m[0][0]);
+
+    Resources_releaseProgram(brightProgram_m);
+    Resources_releaseProgram(blurProgram_m);
+    Resources_releaseProgram(crtProgram_m);
+    Resources_releaseVertexArray(postFxVertexArray_m);
+
+    PostFxTarget_free(&sceneTarget_m);
+    PostFxTarget_free(&overlayTarget_m);
+    for (int i = 0; i < 2; i++) {
+        PostFxTarget_free(&bloomTargets_m[i]);
+    }
+}
+
+PostFxSettings_t* PostFx_settings() {
+    return &postFxSettings_m;
+}
+
+const char* PostFx_passName(PostFxPass_e pass) {
+    return pass < POSTFX_PASS_TOTAL ? postFxPassNames[pass] : "?";
+}
+
+void PostFx_getTimings(PostFxTimings_t *timings) {
+    *timings = postFxTimings_m;
+}
+
+void PostFx_setOutput(uint32_t framebuffer) {
+    outputFramebuffer_m = framebuffer;
+}
+
+float PostFx_renderScale() {
+    return postFxSettings_m.enabled ? renderScale_m : 1.0f;
+}
+
+// Reads back the frame that used this slot last time, if the GPU is done with it. True if there was one
+static bool resolveTimers(uint32_t slot) {
+    uint32_t mask = timerMasks_m[slot];
+    timerMasks_m[slot] = 0;
+    if (mask == 0) return false;
+
+    // the last timestamp written lands last, if it's there they all are
+    int last = 31 - __builtin_clz(mask);
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(timerQueries_m[slot][last], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    GLuint64 stamps[POSTFX_PASS_TOTAL + 1];
+    for (int i = 0; i <= last; i++) {
+        if (mask & (1u << i)) glGetQueryObjectui64v(timerQueries_m[slot][i], GL_QUERY_RESULT, &stamps[i]);
+    }
+
+    PostFxTimings_t timings = { 0 };
+    int prev = 0;
+    for (int pass = 0; pass < POSTFX_PASS_TOTAL; pass++) {
+        if (!(mask & (1u << (pass + 1)))) continue;
+        timings.passMs[pass] = (stamps[pass + 1] - stamps[prev]) / 1e6f;
+        if (pass != POSTFX_PASS_SCENE && pass != POSTFX_PASS_OVERLAY) timings.postMs += timings.passMs[pass];
+        timings.frameMs += timings.passMs[pass];
+        prev = pass + 1;
+    }
+    timings.renderScale = timerScales_m[slot];
+    postFxTimings_m = timings;
+    return true;
+}
+
+// Steers the scene's scale so the whole GPU frame lands a bit under the target
+static void updateRenderScale(const PostFxTimings_t *timings) {
+    PostFxSettings_t *settings = &postFxSettings_m;
+    float minScale = fminf(fmaxf(settings->minScale, 0.25f), 1.0f);
+    float maxScale = fminf(fmaxf(settings->maxScale, minScale), 1.0f);
+
+    float target = settings->targetFrameMs;
+    float sceneMs = timings->passMs[POSTFX_PASS_SCENE];
+    // inside this band it's left alone, so it doesn't hunt around the target
+    if (sceneMs <= 0.0f || (timings->frameMs <= target && timings->frameMs >= target * 0.8f)) {
+        renderScale_m = fminf(fmaxf(renderScale_m, minScale), maxScale);
+        return;
+    }
+
+    // the post passes cost the same at any scale, only the scene's share moves,
+    // and that goes with the pixel count so the square of the scale
+    float sceneBudget = target * 0.9f - (timings->frameMs - sceneMs);
+    float ideal = sceneBudget > 0.0f ? timings->renderScale * sqrtf(sceneBudget / sceneMs) : minScale;
+
+    // timings are a few frames late, so drop quickly but climb back slowly
+    float step = ideal - renderScale_m;
+    step = fminf(fmaxf(step, -0.1f), 0.02f);
+    float scale = roundf((renderScale_m + step) * 64.0f) / 64.0f;
+    renderScale_m = fminf(fmaxf(scale, minScale), maxScale);
+}
+
+static void timestamp(uint32_t index) {
+    uint32_t slot = postFxFrame_m % POSTFX_TIMER_FRAMES;
+    glQueryCounter(timerQueries_m[slot][index], GL_TIMESTAMP);
+    timerMasks_m[slot] |= 1u << index;
+}
+
+void PostFx_begin() {
+    if (!postFxSettings_m.enabled) return;
+
+    uint32_t slot = postFxFrame_m % POSTFX_TIMER_FRAMES;
+    if (resolveTimers(slot) && postFxSettings_m.dynamicResolution) {
+        updateRenderScale(&postFxTimings_m);
+    }
+    if (!postFxSettings_m.dynamicResolution) renderScale_m = 1.0f;
+    timerScales_m[slot] = renderScale_m;
+
+    sceneWidth_m = (uint32_t) (sceneTarget_m.width * renderScale_m + 0.5f);
+    sceneHeight_m = (uint32_t) (sceneTarget_m.height * renderScale_m + 0.5f);
+    if (sceneWidth_m < 1) sceneWidth_m = 1;
+    if (sceneHeight_m < 1) sceneHeight_m = 1;
+    overlayActive_m = false;
+
+    timestamp(0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneTarget_m.fbo);
+    glViewport(0, 0, sceneWidth_m, sceneHeight_m);
+    // so the clear only touches the part that's used
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, sceneWidth_m, sceneHeight_m);
+}
+
+void PostFx_overlay() {
+    if (!postFxSettings_m.enabled || overlayActive_m) return;
+    timestamp(POSTFX_PASS_SCENE + 1);
+    glDisable(GL_SCISSOR_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, overlayTarget_m.fbo);
+    glViewport(0, 0, overlayTarget_m.width, overlayTarget_m.height);
+    static const GLfloat clear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clear);
+    // alpha adds up properly, and the colour comes out premultiplied for the composite
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    overlayActive_m = true;
+}
+
+// One full screen triangle into target, 0 for the window
+static void drawPass(GLuint fbo, uint32_t width, uint32_t height, PostFxPass_e pass) {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    timestamp(pass + 1);
+}
+
+void PostFx_end() {
+    if (!postFxSettings_m.enabled) return;
+    if (overlayActive_m) {
+        timestamp(POSTFX_PASS_OVERLAY + 1);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        timestamp(POSTFX_PASS_SCENE + 1);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    PostFxSettings_t *settings = &postFxSettings_m;
+    uint32_t scale = settings->bloomScale >= 4 ? 4 : 2;
+    if (scale != bloomScale_m) {
+        for (int i = 0; i < 2; i++) {
+            PostFxTarget_free(&bloomTargets_m[i]);
+        }
+        createBloomTargets();
+    }
+
+    // every pass overwrites its whole target
+    glDisable(GL_BLEND);
+    glBindVertexArray(Resources_vertexArrayName(postFxVertexArray_m));
+    glActiveTexture(GL_TEXTURE0);
+
+    GLuint sceneTexture = Resources_textureName(sceneTarget_m.texture);
+    GLuint bloomTextures[2] = {
+        Resources_textureName(bloomTargets_m[0].texture),
+        Resources_textureName(bloomTargets_m[1].texture)
+    };
+    uint32_t bloomWidth = bloomTargets_m[0].width;
+    uint32_t bloomHeight = bloomTargets_m[0].height;
+
+    // the passes work in screen uv, these map it onto the used part of the scene, and
+    // keep the filtering from reading past it into whatever a bigger frame left there
+    float uvScale[2] = { (float) sceneWidth_m / sceneTarget_m.width, (float) sceneHeight_m / sceneTarget_m.height };
+    float uvMax[2] = { (sceneWidth_m - 0.5f) / sceneTarget_m.width, (sceneHeight_m - 0.5f) / sceneTarget_m.height };
+    float overlayAmount = overlayActive_m ? 1.0f : 0.0f;
+    GLuint overlayTexture = Resources_textureName(overlayTarget_m.texture);
+
+    if (settings->bloom) {
+        // downsample and threshold in one go
+        glUseProgram(Resources_programName(brightProgram_m));
+        glUniform2f(brightTapOffsetLoc_m, scale * 0.25f / sceneTarget_m.width, scale * 0.25f / sceneTarget_m.height);
+        glUniform1f(brightThresholdLoc_m, settings->threshold);
+        glUniform1f(brightKneeLoc_m, settings->knee);
+        glUniform2fv(brightUvScaleLoc_m, 1, uvScale);
+        glUniform2fv(brightUvMaxLoc_m, 1, uvMax);
+        glUniform1f(brightOverlayAmountLoc_m, overlayAmount);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, overlayTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sceneTexture);
+        drawPass(bloomTargets_m[0].fbo, bloomWidth, bloomHeight, POSTFX_PASS_BRIGHT);
+
+        glUseProgram(Resources_programName(blurProgram_m));
+        glUniform2f(blurDirectionLoc_m, 1.0f / bloomWidth, 0.0f);
+        glBindTexture(GL_TEXTURE_2D, bloomTextures[0]);
+        drawPass(bloomTargets_m[1].fbo, bloomWidth, bloomHeight, POSTFX_PASS_BLUR_H);
+
+        glUniform2f(blurDirectionLoc_m, 0.0f, 1.0f / bloomHeight);
+        glBindTexture(GL_TEXTURE_2D, bloomTextures[1]);
+        drawPass(bloomTargets_m[0].fbo, bloomWidth, bloomHeight, POSTFX_PASS_BLUR_V);
+    }
+
+    glUseProgram(Resources_programName(crtProgram_m));
+    glUniform1f(crtBloomStrengthLoc_m, settings->bloom ? settings->bloomStrength : 0.0f);
+    glUniform1f(crtCurvatureLoc_m, settings->curvature);
+    glUniform1f(crtScanlineStrengthLoc_m, settings->scanlineStrength);
+    glUniform1f(crtScanlineCountLoc_m, settings->scanlineCount);
+    glUniform1f(crtChromaticLoc_m, settings->chromatic);
+    glUniform1f(crtVignetteLoc_m, settings->vignette);
+    glUniform2fv(crtUvScaleLoc_m, 1, uvScale);
+    glUniform2fv(crtUvMaxLoc_m, 1, uvMax);
+    glUniform2f(crtSceneTexelLoc_m, 1.0f / sceneWidth_m, 1.0f / sceneHeight_m);
+    glUniform1f(crtSharpenLoc_m, sceneWidth_m < sceneTarget_m.width ? settings->sharpen : 0.0f);
+    glUniform1f(crtOverlayAmountLoc_m, overlayAmount);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, bloomTextures[0]);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, overlayTexture);
+    drawPass(outputFramebuffer_m, sceneTarget_m.width, sceneTarget_m.height, POSTFX_PASS_COMPOSITE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glEnable(GL_BLEND);
+
+    postFxFrame_m++;
+}
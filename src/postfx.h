@@ -0,0 +1,100 @@
+#ifndef POSTFX_H
+#define POSTFX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// frames of timer queries in flight, results are read this many frames late so nothing stalls
+#define POSTFX_TIMER_FRAMES 4
+
+typedef enum {
+    // everything drawn into the offscreen target, not post processing but useful next to it
+    POSTFX_PASS_SCENE,
+    // text and HUD at native resolution, after PostFx_overlay
+    POSTFX_PASS_OVERLAY,
+    POSTFX_PASS_BRIGHT,
+    POSTFX_PASS_BLUR_H,
+    POSTFX_PASS_BLUR_V,
+    POSTFX_PASS_COMPOSITE,
+
+    POSTFX_PASS_TOTAL
+} PostFxPass_e;
+
+typedef struct {
+    // off renders straight to the window, with no extra cost at all
+    bool enabled;
+
+    bool bloom;
+    // 2 for half resolution, 4 for quarter. Changing it resizes the bloom targets
+    uint32_t bloomScale;
+    float threshold;
+    float knee;
+    float bloomStrength;
+
+    float curvature;
+    float scanlineStrength;
+    float scanlineCount;
+    float chromatic;
+    float vignette;
+
+    // scales the scene pass so the GPU frame stays inside targetFrameMs
+    bool dynamicResolution;
+    float targetFrameMs;
+    float minScale;
+    float maxScale;
+    // how much the upscale sharpens, only while the scale is below 1
+    float sharpen;
+} PostFxSettings_t;
+
+typedef struct {
+    // milliseconds of GPU time, 0 for passes that were skipped
+    float passMs[POSTFX_PASS_TOTAL];
+    // every pass except the scene and the overlay
+    float postMs;
+    // all of them, what the resolution scale is steered by
+    float frameMs;
+    // the scene's render scale that frame was timed at
+    float renderScale;
+} PostFxTimings_t;
+
+/**
+ * Renders the scene into an offscreen target, then puts it on the screen through
+ * the CRT look: a bright pass and a separable blur at half or quarter resolution
+ * for bloom, then one composite that does curvature, chromatic fringing, scanlines
+ * and vignette. Each pass is one full screen triangle, and the targets are only
+ * made when the size changes. Main thread only.
+ *
+ * With dynamic resolution the scene is drawn into a smaller corner of its target,
+ * sized by a controller fed with the GPU timings, and upscaled by the composite.
+ * Anything drawn after PostFx_overlay stays at native resolution.
+ */
+void PostFx_init(uint32_t width, uint32_t height);
+
+void PostFx_shutdown();
+
+// Changed in place, applied from the next frame
+PostFxSettings_t* PostFx_settings();
+
+// Call before drawing the scene, everything until PostFx_end goes to the offscreen target
+void PostFx_begin();
+
+// Switches from the scene to the native resolution overlay, for text and HUD. Optional,
+// everything stays in the scene otherwise
+void PostFx_overlay();
+
+// Runs the passes and leaves the output framebuffer bound
+void PostFx_end();
+
+// Framebuffer the composite is drawn into, 0 (the window) by default. Has to be the same size
+// PostFx_init was given
+void PostFx_setOutput(uint32_t framebuffer);
+
+// The scale the scene is being drawn at right now, 1 is native
+float PostFx_renderScale();
+
+// Most recent frame the GPU has finished timing
+void PostFx_getTimings(PostFxTimings_t *timings);
+
+const char* PostFx_passName(PostFxPass_e pass);
+
+#endif
@@ -2,7 +2,11 @@
 #include <stddef.h>
 
 #include "util.h"
+#include "archive.h"
+#include "arena.h"
+#include "texfile.h"
 #include "renderer.h"
+#include "memory.h"
 
 // our image loading library
 #define STB_IMAGE_IMPLEMENTATION
@@ -18,33 +22,116 @@ size_t VertexFormat_sizeOf(VertexFormat_e format) {
     case VERTEX_FORMAT_PC: return sizeof(Vertex_PC);
     case VERTEX_FORMAT_PT: return sizeof(Vertex_PT);
     case VERTEX_FORMAT_PCT: return sizeof(Vertex_PCT);
+    case VERTEX_FORMAT_P2C8: return sizeof(Vertex_P2C8);
+    case VERTEX_FORMAT_S16C8: return sizeof(Vertex_S16C8);
+    case VERTEX_FORMAT_P2T16: return sizeof(Vertex_P2T16);
+    case VERTEX_FORMAT_P2C8T16: return sizeof(Vertex_P2C8T16);
     default: return 0;
     }
 }
 
-Texture_t DW_loadTexture(char* texPath) {
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    
+VertexFormat_e VertexFormat_base(VertexFormat_e format) {
+    switch (format) {
+    case VERTEX_FORMAT_P2C8:
+    case VERTEX_FORMAT_S16C8:
+        return VERTEX_FORMAT_PC;
+    case VERTEX_FORMAT_P2T16:
+        return VERTEX_FORMAT_PT;
+    case VERTEX_FORMAT_P2C8T16:
+        return VERTEX_FORMAT_PCT;
+    default:
+        return format;
+    }
+}
+
+bool VertexFormat_hasTexture(VertexFormat_e format) {
+    return VertexFormat_base(format) != VERTEX_FORMAT_PC;
+}
+
+void Vertex_packColor(vec4 color, uint8_t rgba[4]) {
+    for (int i = 0; i < 4; i++) {
+        float c = color[i] < 0.0f ? 0.0f : color[i] > 1.0f ? 1.0f : color[i];
+        rgba[i] = (uint8_t) (c * 255.0f + 0.5f);
+    }
+}
+
+void Vertex_packUv(vec2 uv, uint16_t packed[2]) {
+    for (int i = 0; i < 2; i++) {
+        float c = uv[i] < 0.0f ? 0.0f : uv[i] > 1.0f ? 1.0f : uv[i];
+        packed[i] = (uint16_t) (c * 65535.0f + 0.5f);
+    }
+}
+
+bool DW_loadImage(Image_t *image, const char *path) {
+    // straight out of the pack mapping when there is one
+    Asset_t asset;
+    if (Asset_load(&asset, path)) {
+        stbi_set_flip_vertically_on_load_thread(true);
+        image->pixels = stbi_load_from_memory(asset.data, (int) asset.size, &image->width, &image->height, &image->channels, 0);
+        Asset_free(&asset);
+    } else {
+        image->pixels = NULL;
+    }
+
+    if (!image->pixels) {
+        fprintf(stderr, "Error: Loading image with stbi_load failed: %s\n", path);
+        image->width = 0;
+        image->height = 0;
+        image->channels = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void DW_freeImage(Image_t *image) {
+    stbi_image_free(image->pixels);
+    image->pixels = NULL;
+}
+
+void DW_setTextureParams() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // atlases cap this
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+}
 
-    int width, height, channels;
+bool DW_hasS3TC() {
+    static int supported = -1;
+    if (supported < 0) {
+        supported = 0;
 
-    stbi_set_flip_vertically_on_load(true);
-    uint8_t *data = stbi_load(texPath, &width, &height, &channels, 0);
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char *ext = (const char*) glGetStringi(GL_EXTENSIONS, i);
+            if (strcmp(ext, "GL_EXT_texture_compression_s3tc") == 0) supported = 1;
+        }
+    }
+    return supported;
+}
 
-    if (data) {
-        GLenum format = (channels == 3) ? GL_RGB : GL_RGBA;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+Texture_t DW_createTexture(Image_t *image) {
+    // immutable storage with a full mip chain, so the texture can be pooled by size and format
+    uint32_t width = image->pixels ? image->width : 1;
+    uint32_t height = image->pixels ? image->height : 1;
+    uint32_t levels = 1;
+    while ((width | height) >> levels) levels++;
+
+    GLenum internalFormat = (image->channels == 3) ? GL_RGB8 : GL_RGBA8;
+    TextureHandle_t handle = Resources_acquireTexture(width, height, internalFormat, levels);
+    DW_setTextureParams();
+
+    if (image->pixels) {
+        GLenum format = (image->channels == 3) ? GL_RGB : GL_RGBA;
+        // rgb rows aren't 4 byte aligned unless the width works out
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, image->pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(data);
-    } else {
-        fprintf(stderr, "Error: Loading image with stbi_load failed: %s\n", texPath);
     }
 
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -55,11 +142,103 @@ Texture_t DW_loadTexture(char* texPath) {
     }
 
     return (Texture_t) {
-        .width = width,
-        .height = height,
-        .channels = channels,
-        .texId = texture
+        .width = image->width,
+        .height = image->height,
+        .channels = image->channels,
+        .texId = Resources_textureName(handle),
+        .handle = handle
+    };
+}
+
+void DW_freeTexture(Texture_t *texture) {
+    Resources_releaseTexture(texture->handle);
+    texture->handle.id = 0;
+    texture->texId = 0;
+}
+
+GLenum DW_textureFileFormat(uint32_t format) {
+    switch (format) {
+    case TEXTURE_FORMAT_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXTURE_FORMAT_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    default: return GL_RGBA8;
+    }
+}
+
+bool DW_createTextureFromFile(Texture_t *texture, const uint8_t *data, size_t size) {
+    memset(texture, 0, sizeof(Texture_t));
+
+    const TextureFileHeader_t *header = TextureFile_validate(data, size);
+    if (header == NULL) {
+        fprintf(stderr, "Error: Not a valid version %d DWTX texture.\n", TEXTURE_FILE_VERSION);
+        return false;
+    }
+
+    GLenum internalFormat = DW_textureFileFormat(header->format);
+
+    if (TextureFormat_isCompressed(header->format) && !DW_hasS3TC()) {
+        fprintf(stderr, "Error: Driver doesn't support S3TC, can't use a BC compressed texture.\n");
+        return false;
+    }
+
+    TextureHandle_t handle = Resources_acquireTexture(header->width, header->height, internalFormat, header->levels);
+    DW_setTextureParams();
+
+    // every level is ready to go, no decoding, flipping or mip generation
+    const TextureFileLevel_t *levels = TextureFile_levels(header);
+    for (uint32_t i = 0; i < header->levels; i++) {
+        const TextureFileLevel_t *level = &levels[i];
+        if (TextureFormat_isCompressed(header->format)) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level->width, level->height, internalFormat, level->size, data + level->offset);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level->width, level->height, GL_RGBA, GL_UNSIGNED_BYTE, data + level->offset);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR) {
+        fprintf(stderr, "Error: GL error while uploading texture: %d\n", err);
+    }
+
+    *texture = (Texture_t) {
+        .width = header->width,
+        .height = header->height,
+        .channels = header->format == TEXTURE_FORMAT_BC1 ? 3 : 4,
+        .texId = Resources_textureName(handle),
+        .handle = handle
     };
+    return true;
+}
+
+bool DW_loadTextureFile(Texture_t *texture, const char *path) {
+    Asset_t asset;
+    if (!Asset_load(&asset, path)) return false;
+
+    bool loaded = DW_createTextureFromFile(texture, asset.data, asset.size);
+    Asset_free(&asset);
+    return loaded;
+}
+
+Texture_t DW_loadTexture(char* texPath) {
+    char pngPath[256];
+    size_t len = strlen(texPath);
+    if (len > 5 && strcmp(texPath + len - 5, ".dwtx") == 0) {
+        Texture_t texture = { 0 };
+        if (DW_loadTextureFile(&texture, texPath)) return texture;
+
+        // not converted, or the driver can't take it, the png it was made from still works
+        snprintf(pngPath, sizeof(pngPath), "%.*s.png", (int) (len - 5), texPath);
+        fprintf(stderr, "Error: Couldn't load %s, falling back to %s\n", texPath, pngPath);
+        texPath = pngPath;
+    }
+
+    Image_t image;
+    DW_loadImage(&image, texPath);
+
+    Texture_t texture = DW_createTexture(&image);
+    DW_freeImage(&image);
+    return texture;
 }
 
 /* 
@@ -150,10 +329,58 @@ uint32_t Shader_createProgram(const char *vertShader, const char *fragShader) {
     return program;
 }
 
+uint32_t Shader_createComputeProgram(const char *computeShader) {
+    uint32_t cs = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(cs, 1, &computeShader, NULL);
+    glCompileShader(cs);
+    Shader_checkSrcError(cs);
+
+    uint32_t program = glCreateProgram();
+    glAttachShader(program, cs);
+    glLinkProgram(program);
+    Shader_checkProgError(program);
+
+    glDetachShader(program, cs);
+    glDeleteShader(cs);
+
+    printf("Compiled GLSL compute program: %u\n", program);
+
+    return program;
+}
+
+uint32_t Shader_loadProgram(const char *vertexPath, const char *fragPath) {
+    Asset_t vs, fs;
+    bool vsLoaded = Asset_load(&vs, vertexPath);
+    bool fsLoaded = Asset_load(&fs, fragPath);
+
+    uint32_t program = 0;
+    if (vsLoaded && fsLoaded) {
+        program = Shader_createProgram((const char*) vs.data, (const char*) fs.data);
+    } else {
+        fprintf(stderr, "Error: Missing shader source for %s, %s\n", vertexPath, fragPath);
+    }
+
+    Asset_free(&vs);
+    Asset_free(&fs);
+    return program;
+}
+
+uint32_t Shader_loadComputeProgram(const char *computePath) {
+    Asset_t cs;
+    if (!Asset_load(&cs, computePath)) {
+        fprintf(stderr, "Error: Missing shader source for %s\n", computePath);
+        return 0;
+    }
+
+    uint32_t program = Shader_createComputeProgram((const char*) cs.data);
+    Asset_free(&cs);
+    return program;
+}
+
 void printLog(uint32_t object, GLsizei logLen, GLboolean isShader) {
     if (logLen <= 0) return;
     
-    char *logBuf = malloc(logLen * sizeof(char));
+    char *logBuf = Memory_alloc(MEMORY_TAG_RENDERER, logLen * sizeof(char));
     if (!logBuf) {
         fprintf(stderr, "Error: Failed to allocate memory for log\n");
         return;
@@ -166,7 +393,7 @@ void printLog(uint32_t object, GLsizei logLen, GLboolean isShader) {
     }
     
     printf("%s\n", logBuf);
-    free(logBuf);
+    Memory_free(logBuf);
 }
 
 void Shader_checkSrcError(uint32_t shader) {
@@ -207,6 +434,8 @@ void Shader_checkProgError(uint32_t program) {
 
 bool shadersCompiled = false;
 GLuint Shader_defaultShaderPrograms_m[VERTEX_FORMAT_TOTAL];
+// same as the defaults, but with a per instance Affine2D_t transform
+GLuint Shader_instancedShaderPrograms_m[VERTEX_FORMAT_TOTAL];
 
 void Shader_compileDefaultShaders() {
     if (shadersCompiled) {
@@ -220,13 +449,21 @@ void Shader_compileDefaultShaders() {
         switch (i)
         {
         case VERTEX_FORMAT_PC:
-            prog = Shader_createProgram(DW_loadSourceFile("assets/pc.vs.glsl"), DW_loadSourceFile("assets/pc.fs.glsl"));
+            prog = Shader_loadProgram("assets/pc.vs.glsl", "assets/pc.fs.glsl");
             break;
         case VERTEX_FORMAT_PT:
-            prog = Shader_createProgram(DW_loadSourceFile("assets/pt.vs.glsl"), DW_loadSourceFile("assets/pt.fs.glsl"));
+            prog = Shader_loadProgram("assets/pt.vs.glsl", "assets/pt.fs.glsl");
             break;
         case VERTEX_FORMAT_PCT:
-            prog = Shader_createProgram(DW_loadSourceFile("assets/pct.vs.glsl"), DW_loadSourceFile("assets/pct.fs.glsl"));
+            prog = Shader_loadProgram("assets/pct.vs.glsl", "assets/pct.fs.glsl");
+            break;
+        case VERTEX_FORMAT_P2C8:
+        case VERTEX_FORMAT_S16C8:
+        case VERTEX_FORMAT_P2T16:
+        case VERTEX_FORMAT_P2C8T16:
+            // the attributes come out of the fetch as the same floats, so the
+            // full format's program works as is. It's compiled already, it comes first
+            prog = Shader_defaultShaderPrograms_m[VertexFormat_base(i)];
             break;
         default:
             fprintf(stderr, "Error: Attempting to compile default shader for invalid vertex format.\n");
@@ -234,6 +471,16 @@ void Shader_compileDefaultShaders() {
         }
         Shader_defaultShaderPrograms_m[i] = prog;
     }
+
+    // instanced variants share the fragment shaders
+    Shader_instancedShaderPrograms_m[VERTEX_FORMAT_PC] = Shader_loadProgram("assets/pc_inst.vs.glsl", "assets/pc.fs.glsl");
+    Shader_instancedShaderPrograms_m[VERTEX_FORMAT_PT] = Shader_loadProgram("assets/pt_inst.vs.glsl", "assets/pt.fs.glsl");
+    Shader_instancedShaderPrograms_m[VERTEX_FORMAT_PCT] = Shader_loadProgram("assets/pct_inst.vs.glsl", "assets/pct.fs.glsl");
+    for (int i = VERTEX_FORMAT_PCT + 1; i < VERTEX_FORMAT_TOTAL; i++) {
+        Shader_instancedShaderPrograms_m[i] = Shader_instancedShaderPrograms_m[VertexFormat_base(i)];
+    }
+
+    shadersCompiled = true;
 }
 
 void Context_init(Context_t *c, uint32_t width, uint32_t height) {
@@ -250,124 +497,280 @@ void Context_init(Context_t *c, uint32_t width, uint32_t height) {
     glm_mat4_identity(transform);
     
     // push our identity transformation
-    c->matrixStack = malloc(sizeof(MatrixStack_t));
+    c->matrixStack = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(MatrixStack_t));
     MatrixStack_init(c->matrixStack);
     MatrixStack_push(c->matrixStack, transform);
 }
 
 void Context_free(Context_t *context) {
-    free(context->matrixStack);
+    Memory_free(context->matrixStack);
     context->matrixStack = NULL;
-
-    free(context);    
-    context = NULL;
 }
 
 void IndexBuffer_init(IndexBuffer_t *ib, size_t indexCount, size_t bufferSize, uint32_t *indexBuffer) {
     ib->indexCount = indexCount;
+    ib->indexType = GL_UNSIGNED_INT;
+    ib->indexSize = sizeof(uint32_t);
     ib->indexData = indexBuffer;
 
-    glGenBuffers(1, &ib->ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, bufferSize, indexBuffer, GL_STATIC_DRAW);
+    ib->handle = Resources_acquireBuffer(bufferSize, GL_STATIC_DRAW);
+    ib->ibo = Resources_bufferName(ib->handle);
+    if (indexBuffer != NULL) glNamedBufferSubData(ib->ibo, 0, bufferSize, indexBuffer);
+}
+
+void IndexBuffer_initTyped(IndexBuffer_t *ib, GLenum type, size_t indexCount, void *indexData) {
+    size_t indexSize;
+    switch (type) {
+    case GL_UNSIGNED_INT: indexSize = sizeof(uint32_t); break;
+    case GL_UNSIGNED_SHORT: indexSize = sizeof(uint16_t); break;
+    case GL_UNSIGNED_BYTE: indexSize = sizeof(uint8_t); break;
+    default:
+        fprintf(stderr, "Error: Invalid index type 0x%x, using 32 bit indices.\n", type);
+        type = GL_UNSIGNED_INT;
+        indexSize = sizeof(uint32_t);
+        break;
+    }
+
+    ib->indexCount = indexCount;
+    ib->indexType = type;
+    ib->indexSize = indexSize;
+    ib->indexData = indexData;
+
+    ib->handle = Resources_acquireBuffer(indexCount * indexSize, GL_STATIC_DRAW);
+    ib->ibo = Resources_bufferName(ib->handle);
+    if (indexData != NULL) glNamedBufferSubData(ib->ibo, 0, indexCount * indexSize, indexData);
+}
+
+void IndexBuffer_initCompact(IndexBuffer_t *ib, size_t indexCount, uint32_t *indexData) {
+    uint32_t maxIndex = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        if (indexData[i] > maxIndex) maxIndex = indexData[i];
+    }
+
+    // 8 bit indices get widened by the driver on some hardware, so 16 is as small as this goes
+    if (maxIndex > UINT16_MAX) {
+        IndexBuffer_initTyped(ib, GL_UNSIGNED_INT, indexCount, indexData);
+        return;
+    }
+
+    // runs on the loader thread too, each thread has its own scratch
+    Arena_t *scratch = FrameArena_scratch();
+    ArenaMark_t mark = Arena_mark(scratch);
+    uint16_t *narrow = Arena_alloc(scratch, indexCount * sizeof(uint16_t));
+    for (size_t i = 0; i < indexCount; i++) {
+        narrow[i] = (uint16_t) indexData[i];
+    }
+    IndexBuffer_initTyped(ib, GL_UNSIGNED_SHORT, indexCount, narrow);
+    Arena_rewind(scratch, mark);
+    ib->indexData = NULL;
 }
 
 void IndexBuffer_free(IndexBuffer_t *ib) {
-    glDeleteBuffers(1, &ib->ibo);
-    free(ib);
+    Resources_releaseBuffer(ib->handle);
+    Memory_free(ib);
 }
 
 void VertexBuffer_init(VertexBuffer_t *vb, size_t stride, size_t vertexCount, size_t bufferSize, GLenum usage, void *vertexData) {
     vb->stride = stride;
-    vb->bufferSize = bufferSize;
     vb->vertexCount = vertexCount;
 
-    glGenBuffers(1, &vb->vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vb->vbo);
-    glBufferData(GL_ARRAY_BUFFER, vb->bufferSize, vertexData, usage);
+    // might come out of the pool, and bigger than asked for
+    vb->handle = Resources_acquireBuffer(bufferSize, usage);
+    vb->vbo = Resources_bufferName(vb->handle);
+    vb->bufferSize = Resources_bufferSize(vb->handle);
+    if (vertexData != NULL) glNamedBufferSubData(vb->vbo, 0, bufferSize, vertexData);
+}
+
+void VertexBuffer_update(VertexBuffer_t *vb, size_t vertexCount, size_t size, void *data) {
+    vb->vertexCount = vertexCount;
+
+    if (size > vb->bufferSize) {
+        // same name, so VAOs pointing at it don't need to be rebuilt
+        Resources_resizeBuffer(vb->handle, size * 2);
+        vb->bufferSize = Resources_bufferSize(vb->handle);
+    }
+    glNamedBufferSubData(vb->vbo, 0, size, data);
+}
+
+void VertexBuffer_write(VertexBuffer_t *vb, size_t offset, size_t size, void *data) {
+    if (offset + size > vb->bufferSize) {
+        fprintf(stderr, "Error: Vertex buffer write of %zu bytes at %zu doesn't fit in %zu.\n", size, offset, vb->bufferSize);
+        return;
+    }
+
+    glNamedBufferSubData(vb->vbo, offset, size, data);
 }
 
 void VertexBuffer_free(VertexBuffer_t *vb) {
-    glDeleteBuffers(1, &vb->vbo);
-    free(vb);
+    Resources_releaseBuffer(vb->handle);
+    Memory_free(vb);
 }
 
-// This is assuming the VBO and IBO have already been initialized and had data passed to them.
-void Renderer_init(Renderer_t *renderer, Context_t *context, VertexFormat_e format, VertexBuffer_t *vb, IndexBuffer_t *ib) {
-    renderer->vertexFormat = format;
-    renderer->context = context;
-    renderer->shader = Shader_defaultShaderPrograms_m[format];
-    // default primitive is triangle strip as quads, but this will be
-    // replaced with an element buffer later on
-    renderer->primitive = GL_TRIANGLES;
-    renderer->vb = vb;
-    renderer->ib = ib;
-    
-    // Create vao
-    glGenVertexArrays(1, &renderer->vao);
-    glBindVertexArray(renderer->vao);
+// One VAO per format and per instancing, the layout is set up once and meshes just
+// swap the buffers in. [format][1] is the instanced one
+static VertexArrayHandle_t Renderer_vertexArrays_m[VERTEX_FORMAT_TOTAL][2];
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vb->stride, (void*) 0);
+// per instance Affine2D_t at locations 4-6, read from binding 1
+static void setupInstanceAttribs(GLuint vao) {
+    glVertexArrayBindingDivisor(vao, 1, 1);
 
-    glEnableVertexAttribArray(1);
+    GLuint offsets[3] = { offsetof(Affine2D_t, xAxis), offsetof(Affine2D_t, yAxis), offsetof(Affine2D_t, translation) };
+    for (GLuint i = 0; i < 3; i++) {
+        glEnableVertexArrayAttrib(vao, 4 + i);
+        glVertexArrayAttribFormat(vao, 4 + i, 2, GL_FLOAT, GL_FALSE, offsets[i]);
+        glVertexArrayAttribBinding(vao, 4 + i, 1);
+    }
+}
+
+// Attribute 'index' of the vertex read from binding 0
+static void setupAttrib(GLuint vao, GLuint index, GLint size, GLenum type, GLboolean normalized, size_t offset) {
+    glEnableVertexArrayAttrib(vao, index);
+    glVertexArrayAttribFormat(vao, index, size, type, normalized, (GLuint) offset);
+    glVertexArrayAttribBinding(vao, index, 0);
+}
+
+static void setupFormatAttribs(GLuint vao, VertexFormat_e format) {
     switch (format) {
     case VERTEX_FORMAT_PC:
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, vb->stride, (void*) offsetof(Vertex_PC, color));
+    case VERTEX_FORMAT_PT:
+    case VERTEX_FORMAT_PCT:
+        setupAttrib(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        break;
+    case VERTEX_FORMAT_S16C8:
+        // not normalized, so they come through as whole units
+        setupAttrib(vao, 0, 2, GL_SHORT, GL_FALSE, 0);
+        break;
+    default:
+        // the shaders' vec3 gets a z of 0
+        setupAttrib(vao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        break;
+    }
+
+    switch (format) {
+    case VERTEX_FORMAT_PC:
+        setupAttrib(vao, 1, 4, GL_FLOAT, GL_TRUE, offsetof(Vertex_PC, color));
         break;
     case VERTEX_FORMAT_PT:
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, vb->stride, (void*) offsetof(Vertex_PT, uv));
+        setupAttrib(vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex_PT, uv));
         break;
     case VERTEX_FORMAT_PCT:
-        glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, vb->stride, (void*) offsetof(Vertex_PCT, color));
-
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vb->stride, (void*) offsetof(Vertex_PCT, uv));
+        setupAttrib(vao, 1, 4, GL_FLOAT, GL_TRUE, offsetof(Vertex_PCT, color));
+        setupAttrib(vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex_PCT, uv));
+        break;
+    case VERTEX_FORMAT_P2C8:
+        setupAttrib(vao, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex_P2C8, color));
+        break;
+    case VERTEX_FORMAT_S16C8:
+        setupAttrib(vao, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex_S16C8, color));
+        break;
+    case VERTEX_FORMAT_P2T16:
+        setupAttrib(vao, 1, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(Vertex_P2T16, uv));
+        break;
+    case VERTEX_FORMAT_P2C8T16:
+        setupAttrib(vao, 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex_P2C8T16, color));
+        setupAttrib(vao, 2, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(Vertex_P2C8T16, uv));
         break;
     default:
-        fprintf(stderr, "Error: Attempted to create Renderer with unknown Vertex format.\n");
+        fprintf(stderr, "Error: Attempted to create a vertex array for unknown Vertex format.\n");
         break;
     }
+}
+
+void Renderer_initVertexArrays() {
+    for (int format = 0; format < VERTEX_FORMAT_TOTAL; format++) {
+        for (int instanced = 0; instanced < 2; instanced++) {
+            VertexArrayHandle_t vertexArray = Resources_createVertexArray();
+            GLuint vao = Resources_vertexArrayName(vertexArray);
+            setupFormatAttribs(vao, format);
+            if (instanced) setupInstanceAttribs(vao);
+            Renderer_vertexArrays_m[format][instanced] = vertexArray;
+        }
+    }
+}
+
+void Renderer_freeVertexArrays() {
+    for (int format = 0; format < VERTEX_FORMAT_TOTAL; format++) {
+        for (int instanced = 0; instanced < 2; instanced++) {
+            Resources_releaseVertexArray(Renderer_vertexArrays_m[format][instanced]);
+            Renderer_vertexArrays_m[format][instanced].id = 0;
+        }
+    }
+}
+
+// Doesn't touch any GL state, so renderers can be made on the loader thread
+void Renderer_init(Renderer_t *renderer, Context_t *context, VertexFormat_e format, VertexBuffer_t *vb, IndexBuffer_t *ib) {
+    renderer->vertexFormat = format;
+    renderer->context = context;
+    renderer->shader = Shader_defaultShaderPrograms_m[format];
+    // default primitive is triangle strip as quads, but this will be
+    // replaced with an element buffer later on
+    renderer->primitive = GL_TRIANGLES;
+    renderer->vb = vb;
+    renderer->ib = ib;
+    renderer->instanceVb = NULL;
+    renderer->vao = Resources_vertexArrayName(Renderer_vertexArrays_m[format][0]);
 
     renderer->projectionLoc = glGetUniformLocation(renderer->shader, "projection");
     renderer->modelLoc = glGetUniformLocation(renderer->shader, "model");
 
-    if (format != VERTEX_FORMAT_PC) {
+    if (VertexFormat_hasTexture(format)) {
         renderer->samplerLoc = glGetUniformLocation(renderer->shader, "textureIn");
     } else {
         renderer->samplerLoc = -1;
     }
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void Renderer_bind(Renderer_t *renderer) {
-    glBindVertexArray(renderer->vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->vb->vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer->ib->ibo);
+    // the shared VAO keeps the layout, only the buffers change between meshes
+    GLuint vao = renderer->vao;
+    glVertexArrayVertexBuffer(vao, 0, renderer->vb->vbo, 0, (GLsizei) renderer->vb->stride);
+    glVertexArrayElementBuffer(vao, renderer->ib->ibo);
+    if (renderer->instanceVb != NULL) {
+        glVertexArrayVertexBuffer(vao, 1, renderer->instanceVb->vbo, 0, sizeof(Affine2D_t));
+    }
+
+    glBindVertexArray(vao);
     glUseProgram(renderer->shader);
 }
-
 void Renderer_drawIndexed(Renderer_t *renderer, int start, size_t size) {
-    if (renderer->vertexFormat != VERTEX_FORMAT_PC) {
+    if (VertexFormat_hasTexture(renderer->vertexFormat)) {
         glUniform1i(renderer->samplerLoc, 0);
     }
     
     glUniformMatrix4fv(renderer->projectionLoc, 1, GL_FALSE, (float*) &renderer->context->projectionMatrix);
     glUniformMatrix4fv(renderer->modelLoc, 1, GL_FALSE, (float*) MatrixStack_peek(renderer->context->matrixStack));
-    glDrawElements(renderer->primitive, renderer->ib->indexCount, GL_UNSIGNED_INT, NULL);
+    IndexBuffer_t *ib = renderer->ib;
+    glDrawElements(renderer->primitive, size, ib->indexType, (void*) (start * ib->indexSize));
 }
 
 void Renderer_draw(Renderer_t *renderer) {
-    Renderer_drawIndexed(renderer, 0, renderer->vb->vertexCount);
+    Renderer_drawIndexed(renderer, 0, renderer->ib->indexCount);
+}
+
+void Renderer_setInstanceBuffer(Renderer_t *renderer, VertexBuffer_t *instanceVb) {
+    renderer->instanceVb = instanceVb;
+    renderer->shader = Shader_instancedShaderPrograms_m[renderer->vertexFormat];
+    renderer->vao = Resources_vertexArrayName(Renderer_vertexArrays_m[renderer->vertexFormat][1]);
+
+    // new program, new uniform locations
+    renderer->projectionLoc = glGetUniformLocation(renderer->shader, "projection");
+    renderer->modelLoc = glGetUniformLocation(renderer->shader, "model");
+    if (VertexFormat_hasTexture(renderer->vertexFormat)) {
+        renderer->samplerLoc = glGetUniformLocation(renderer->shader, "textureIn");
+    }
+}
+
+void Renderer_drawInstanced(Renderer_t *renderer, size_t instanceCount) {
+    if (VertexFormat_hasTexture(renderer->vertexFormat)) {
+        glUniform1i(renderer->samplerLoc, 0);
+    }
+
+    glUniformMatrix4fv(renderer->projectionLoc, 1, GL_FALSE, (float*) &renderer->context->projectionMatrix);
+    glUniformMatrix4fv(renderer->modelLoc, 1, GL_FALSE, (float*) MatrixStack_peek(renderer->context->matrixStack));
+    glDrawElementsInstanced(renderer->primitive, renderer->ib->indexCount, renderer->ib->indexType, NULL, instanceCount);
 }
 
 void Renderer_free(Renderer_t *renderer) {
-    IndexBuffer_free(renderer->ib);
-    VertexBuffer_free(renderer->vb);
-    glDeleteVertexArrays(1, &renderer->vao);
-    free(renderer);
+    Memory_free(renderer);
     renderer = NULL;
 }
@@ -8,6 +8,9 @@
 #include <GLFW/glfw3.h>
 #include <cglm/cglm.h>
 
+#include "transform.h"
+#include "resources.h"
+
 #define MAX_TRIANGLES 2048
 #define MAX_VERTICIES MAX_TRIANGLES * 3
 
@@ -19,10 +22,44 @@ typedef struct {
     uint32_t height;
     uint8_t channels;
     GLuint texId;
+    TextureHandle_t handle;
 } Texture_t;
 
+// Decoded pixels that haven't been uploaded yet
+typedef struct {
+    int width;
+    int height;
+    int channels;
+    uint8_t *pixels;
+} Image_t;
+
+// Loads a .dwtx container if the path ends in one, otherwise decodes the image
 Texture_t DW_loadTexture(char* texPath);
 
+// Uploads a DWTX container (see texfile.h) level by level, false if it's invalid or unsupported
+bool DW_createTextureFromFile(Texture_t *texture, const uint8_t *data, size_t size);
+
+bool DW_loadTextureFile(Texture_t *texture, const char *path);
+
+// Decodes an image file (flipped for GL), doesn't touch GL so it can run on a job
+bool DW_loadImage(Image_t *image, const char *path);
+
+void DW_freeImage(Image_t *image);
+
+// Uploads decoded pixels, has to be called on a thread with a GL context
+Texture_t DW_createTexture(Image_t *image);
+
+// Gives the texture back to the resource manager
+void DW_freeTexture(Texture_t *texture);
+
+// Wrap and filter for the texture bound to GL_TEXTURE_2D, pooled textures keep whatever the last user set
+void DW_setTextureParams();
+
+bool DW_hasS3TC();
+
+// GL internal format for a TextureFormat_e out of a DWTX header
+GLenum DW_textureFileFormat(uint32_t format);
+
 /**
  * A stack data structure for matricies
  * Mainly used for the model/transformation matrix in our case,
@@ -40,6 +77,15 @@ typedef enum {
     VERTEX_FORMAT_PT,
     // pos, color, tex
     VERTEX_FORMAT_PCT,
+    // compact 2D formats, they reuse the shaders of the full ones since the attribute
+    // fetch widens them to the same floats. vec2 pos, rgba8 color
+    VERTEX_FORMAT_P2C8,
+    // int16 pos in whole units, rgba8 color
+    VERTEX_FORMAT_S16C8,
+    // vec2 pos, unorm16 tex
+    VERTEX_FORMAT_P2T16,
+    // vec2 pos, rgba8 color, unorm16 tex
+    VERTEX_FORMAT_P2C8T16,
 
     VERTEX_FORMAT_TOTAL
 } VertexFormat_e;
@@ -60,11 +106,48 @@ typedef struct {
     vec2 uv;
 } Vertex_PCT;
 
+// 12 bytes
+typedef struct {
+    vec2 pos;
+    uint8_t color[4];
+} Vertex_P2C8;
+
+// 8 bytes
+typedef struct {
+    int16_t pos[2];
+    uint8_t color[4];
+} Vertex_S16C8;
+
+// 12 bytes
+typedef struct {
+    vec2 pos;
+    uint16_t uv[2];
+} Vertex_P2T16;
+
+// 16 bytes
+typedef struct {
+    vec2 pos;
+    uint8_t color[4];
+    uint16_t uv[2];
+} Vertex_P2C8T16;
+
 size_t VertexFormat_sizeOf(VertexFormat_e format);
 
+// The full format whose shaders a format uses, PC, PT or PCT
+VertexFormat_e VertexFormat_base(VertexFormat_e format);
+
+bool VertexFormat_hasTexture(VertexFormat_e format);
+
+// Packs a 0-1 colour for the rgba8 formats
+void Vertex_packColor(vec4 color, uint8_t rgba[4]);
+
+// Packs a 0-1 coordinate pair for the unorm16 formats
+void Vertex_packUv(vec2 uv, uint16_t packed[2]);
+
 typedef struct {
-    // vertex buffer object
+    // vertex buffer object, owned by handle
     GLuint vbo;
+    BufferHandle_t handle;
     // sizeof whichever vertex format we decide to go with
     size_t stride;
     // number of defined verticies in our buffer
@@ -74,15 +157,22 @@ typedef struct {
 } VertexBuffer_t;
 
 typedef struct {
-    // element buffer object
+    // element buffer object, owned by handle
     GLuint ibo;
+    BufferHandle_t handle;
     size_t indexCount;
-    uint32_t *indexData;
+    // GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE
+    GLenum indexType;
+    size_t indexSize;
+    // what it was made from, not copied. NULL when it was narrowed
+    void *indexData;
 } IndexBuffer_t;
 
 typedef struct {
     // delta time variable
     float partialTicks;
+    // seconds since the last frame, for things animated per frame instead of per tick
+    float frameTime;
     // display size
     uint32_t displayWidth;
     uint32_t displayHeight;
@@ -102,9 +192,14 @@ typedef struct {
     GLuint shader;
 
     VertexFormat_e vertexFormat;
+    // not owned by the renderer, they can be shared between renderers
     VertexBuffer_t *vb;
     IndexBuffer_t *ib;
+    // shared by every renderer with this format, not owned
     GLuint vao;
+    // per instance Affine2D_t transforms, NULL unless Renderer_setInstanceBuffer was called.
+    // not owned by the renderer
+    VertexBuffer_t *instanceVb;
 
     GLint projectionLoc;
     GLint modelLoc;
@@ -140,34 +235,73 @@ void MatrixStack_rotate(MatrixStack_t *stack, float angle, vec3 axis);
 
 void Context_init(Context_t *context, uint32_t width, uint32_t height);
 
+// Frees what the context owns, not the context itself
 void Context_free(Context_t *context);
 
 uint32_t Shader_createProgram(const char *vertexShader, const char *fragShader);
 
+uint32_t Shader_createComputeProgram(const char *computeShader);
+
+// Same as above but from asset paths, 0 if a source is missing
+uint32_t Shader_loadProgram(const char *vertexPath, const char *fragPath);
+
+uint32_t Shader_loadComputeProgram(const char *computePath);
+
 void Shader_checkSrcError(uint32_t shader);
 
 void Shader_checkProgError(uint32_t program);
 
 void Shader_compileDefaultShaders();
 
+// 32 bit indices
 void IndexBuffer_init(IndexBuffer_t *ib, size_t indexCount, size_t dataSize, uint32_t *indexData);
 
+// indexData holds indexCount indices of type, which is GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE
+void IndexBuffer_initTyped(IndexBuffer_t *ib, GLenum type, size_t indexCount, void *indexData);
+
+// Uploads 32 bit indices as 16 bit when they fit, which is every mesh we have
+void IndexBuffer_initCompact(IndexBuffer_t *ib, size_t indexCount, uint32_t *indexData);
+
+// Releases the buffer and frees ib
 void IndexBuffer_free(IndexBuffer_t *ib);
 
 void VertexBuffer_init(VertexBuffer_t *vb, size_t stride, size_t vertexCount, size_t bufferSize, GLenum usage, void *vertexData);
 
+// Replaces the buffer contents, growing the buffer if it doesn't fit
+void VertexBuffer_update(VertexBuffer_t *vb, size_t vertexCount, size_t size, void *data);
+
+// Overwrites part of the buffer in place, doesn't grow it or change vertexCount
+void VertexBuffer_write(VertexBuffer_t *vb, size_t offset, size_t size, void *data);
+
+// Releases the buffer and frees vb
 void VertexBuffer_free(VertexBuffer_t *vb);
 
 bool Renderer_checkBound(Renderer_t *renderer);
 
 void Renderer_bind(Renderer_t *renderer);
 
+// Makes the shared VAOs, one per vertex format (and one more for instancing) with the
+// attribute layout set up once. Main thread, after Shader_compileDefaultShaders
+void Renderer_initVertexArrays();
+
+void Renderer_freeVertexArrays();
+
+// Doesn't touch GL state, so it's fine on the loader thread
 void Renderer_init(Renderer_t *renderer, Context_t *context, VertexFormat_e format, VertexBuffer_t *vb, IndexBuffer_t *ib);
 
+// Draws size indices starting from index start
 void Renderer_drawIndexed(Renderer_t *renderer, int start, size_t size);
 
 void Renderer_draw(Renderer_t *renderer);
 
+// Switches the renderer to its instanced shader, reading one Affine2D_t per instance from instanceVb
+void Renderer_setInstanceBuffer(Renderer_t *renderer, VertexBuffer_t *instanceVb);
+
+// Draws the mesh once per transform in the instance buffer
+void Renderer_drawInstanced(Renderer_t *renderer, size_t instanceCount);
+
+// Frees only the renderer struct. The vertex/index buffers are left to their owner and the
+// shared per-format VAOs (Renderer_vertexArrays_m) go in Renderer_freeVertexArrays
 void Renderer_free(Renderer_t *renderer);
 
 #endif
\ No newline at end of file
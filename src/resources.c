@@ -0,0 +1,650 @@
+#include "resources.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "renderer.h"
+#include "memory.h"
+#include "archive.h"
+
+// buffers are handed out in power of two sizes from here up, so pooled ones actually get reused
+#define RESOURCE_MIN_BUFFER_SIZE 256
+#define RESOURCE_NONE -1
+// open addressed, at most half full even with every slot a program
+#define RESOURCE_PROGRAM_INDEX_SIZE (RESOURCE_MAX * 2)
+
+typedef enum {
+    RESOURCE_STATE_FREE,
+    RESOURCE_STATE_LIVE,
+    // released, waiting for the GPU to finish the frame it happened in
+    RESOURCE_STATE_PENDING,
+    // unreferenced and ready to be handed out again
+    RESOURCE_STATE_POOLED
+} ResourceState_e;
+
+typedef struct {
+    ResourceType_e type;
+    ResourceState_e state;
+    GLuint name;
+    uint16_t generation;
+    uint32_t refCount;
+
+    // buffers
+    size_t size;
+    GLenum usage;
+
+    // textures
+    GLenum format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    // 0 for a plain 2D texture
+    uint32_t layers;
+
+    // programs, the paths they were built from
+    char *key;
+
+    // frame it was released in, it's safe to reuse once that frame has completed
+    uint64_t releaseFrame;
+    // pending or pool list
+    int32_t next;
+} Resource_t;
+
+Resource_t resources_m[RESOURCE_MAX];
+int32_t resourceFreeSlots_m[RESOURCE_MAX];
+uint32_t resourceFreeCount_m = 0;
+
+int32_t resourcePending_m = RESOURCE_NONE;
+int32_t resourcePools_m[RESOURCE_TYPE_TOTAL];
+// program slots by key hash, programs only go away at shutdown so nothing is ever removed
+int32_t resourcePrograms_m[RESOURCE_PROGRAM_INDEX_SIZE];
+ResourceStats_t resourceStats_m;
+
+// frames submitted and frames the GPU is known to be done with
+uint64_t resourceFrame_m = 0;
+uint64_t resourceCompletedFrames_m = 0;
+GLsync resourceFences_m[RESOURCE_MAX_FRAMES];
+
+// creation happens outside of this, so a loader compiling shaders never stalls a frame
+pthread_mutex_t resourceMutex_m = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *resourceTypeNames[RESOURCE_TYPE_TOTAL] = { "buffer", "texture", "vertex array", "program" };
+
+static uint32_t Resource_toId(int32_t slot) {
+    return ((uint32_t) resources_m[slot].generation << 16) | (uint32_t) (slot + 1);
+}
+
+// Resolves a handle, NULL if it's stale or the wrong type
+static Resource_t* Resource_get(uint32_t id, ResourceType_e type) {
+    int32_t slot = (int32_t) (id & 0xFFFF) - 1;
+    if (slot < 0 || slot >= RESOURCE_MAX) return NULL;
+
+    Resource_t *res = &resources_m[slot];
+    if (res->state != RESOURCE_STATE_LIVE || res->type != type || res->generation != (id >> 16)) return NULL;
+    return res;
+}
+
+// Takes a free slot for a new object, lock has to be held
+static int32_t Resource_alloc(ResourceType_e type, GLuint name) {
+    if (resourceFreeCount_m == 0) {
+        fprintf(stderr, "Error: Out of resource slots (max %d).\n", RESOURCE_MAX);
+        return RESOURCE_NONE;
+    }
+
+    int32_t slot = resourceFreeSlots_m[--resourceFreeCount_m];
+    Resource_t *res = &resources_m[slot];
+    uint16_t generation = res->generation;
+    memset(res, 0, sizeof(Resource_t));
+
+    res->generation = generation;
+    res->type = type;
+    res->state = RESOURCE_STATE_LIVE;
+    res->name = name;
+    res->refCount = 1;
+    res->next = RESOURCE_NONE;
+
+    resourceStats_m.live++;
+    resourceStats_m.created++;
+    return slot;
+}
+
+// Deletes the GL object and gives the slot back, lock has to be held
+static void Resource_destroy(int32_t slot) {
+    Resource_t *res = &resources_m[slot];
+
+    switch (res->type) {
+    case RESOURCE_BUFFER: glDeleteBuffers(1, &res->name); break;
+    case RESOURCE_TEXTURE: glDeleteTextures(1, &res->name); break;
+    case RESOURCE_VERTEX_ARRAY: glDeleteVertexArrays(1, &res->name); break;
+    case RESOURCE_PROGRAM: glDeleteProgram(res->name); break;
+    default: break;
+    }
+
+    Memory_free(res->key);
+    res->key = NULL;
+    res->name = 0;
+    res->state = RESOURCE_STATE_FREE;
+    // anything still holding the old handle now misses
+    res->generation++;
+    resourceFreeSlots_m[resourceFreeCount_m++] = slot;
+}
+
+// Unlinks the first pooled object that passes match, lock has to be held
+static int32_t Resource_takePooled(ResourceType_e type, bool (*match)(Resource_t *res, void *data), void *data) {
+    int32_t prev = RESOURCE_NONE;
+    for (int32_t slot = resourcePools_m[type]; slot != RESOURCE_NONE; slot = resources_m[slot].next) {
+        Resource_t *res = &resources_m[slot];
+        if (!match(res, data)) {
+            prev = slot;
+            continue;
+        }
+
+        if (prev == RESOURCE_NONE) resourcePools_m[type] = res->next;
+        else resources_m[prev].next = res->next;
+
+        res->next = RESOURCE_NONE;
+        res->state = RESOURCE_STATE_LIVE;
+        res->refCount = 1;
+
+        resourceStats_m.pooled--;
+        resourceStats_m.pooledBytes -= res->size;
+        resourceStats_m.live++;
+        resourceStats_m.reused++;
+        return slot;
+    }
+
+    return RESOURCE_NONE;
+}
+
+static void Resource_retain(uint32_t id, ResourceType_e type) {
+    pthread_mutex_lock(&resourceMutex_m);
+    Resource_t *res = Resource_get(id, type);
+    if (res != NULL) {
+        res->refCount++;
+    } else {
+        fprintf(stderr, "Error: Attempted to retain invalid %s handle %08x.\n", resourceTypeNames[type], id);
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+}
+
+static void Resource_release(uint32_t id, ResourceType_e type) {
+    // releasing nothing is fine, makes freeing half initialized things easier
+    if (id == 0) return;
+
+    pthread_mutex_lock(&resourceMutex_m);
+    Resource_t *res = Resource_get(id, type);
+    if (res == NULL) {
+        fprintf(stderr, "Error: Attempted to release invalid %s handle %08x.\n", resourceTypeNames[type], id);
+    } else if (--res->refCount == 0) {
+        resourceStats_m.live--;
+
+        if (type == RESOURCE_PROGRAM) {
+            // nothing to wait for, the program just stays compiled for the next load
+            res->state = RESOURCE_STATE_POOLED;
+            resourceStats_m.pooled++;
+        } else {
+            // the frame being recorded might still draw with it
+            res->state = RESOURCE_STATE_PENDING;
+            res->releaseFrame = __atomic_load_n(&resourceFrame_m, __ATOMIC_ACQUIRE);
+            res->next = resourcePending_m;
+            resourcePending_m = (int32_t) (res - resources_m);
+            resourceStats_m.pending++;
+        }
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+}
+
+void Resources_init() {
+    memset(resources_m, 0, sizeof(resources_m));
+    memset(&resourceStats_m, 0, sizeof(ResourceStats_t));
+
+    // handed out from the bottom up
+    resourceFreeCount_m = 0;
+    for (int32_t i = RESOURCE_MAX - 1; i >= 0; i--) {
+        resourceFreeSlots_m[resourceFreeCount_m++] = i;
+    }
+
+    resourcePending_m = RESOURCE_NONE;
+    for (int i = 0; i < RESOURCE_TYPE_TOTAL; i++) {
+        resourcePools_m[i] = RESOURCE_NONE;
+    }
+    for (int i = 0; i < RESOURCE_PROGRAM_INDEX_SIZE; i++) {
+        resourcePrograms_m[i] = RESOURCE_NONE;
+    }
+
+    resourceFrame_m = 0;
+    resourceCompletedFrames_m = 0;
+}
+
+void Resources_shutdown() {
+    // everything pending might still be in use
+    glFinish();
+
+    pthread_mutex_lock(&resourceMutex_m);
+    uint32_t leaked[RESOURCE_TYPE_TOTAL] = { 0 };
+    for (int32_t slot = 0; slot < RESOURCE_MAX; slot++) {
+        Resource_t *res = &resources_m[slot];
+        if (res->state == RESOURCE_STATE_FREE) continue;
+
+        if (res->state == RESOURCE_STATE_LIVE) leaked[res->type]++;
+        Resource_destroy(slot);
+    }
+
+    for (int i = 0; i < RESOURCE_TYPE_TOTAL; i++) {
+        if (leaked[i] > 0) {
+            fprintf(stderr, "Error: %u %s(s) were never released.\n", leaked[i], resourceTypeNames[i]);
+        }
+    }
+    printf("Resources: %u created, %u reused\n", resourceStats_m.created, resourceStats_m.reused);
+
+    resourcePending_m = RESOURCE_NONE;
+    for (int i = 0; i < RESOURCE_TYPE_TOTAL; i++) {
+        resourcePools_m[i] = RESOURCE_NONE;
+    }
+    for (int i = 0; i < RESOURCE_PROGRAM_INDEX_SIZE; i++) {
+        resourcePrograms_m[i] = RESOURCE_NONE;
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    for (uint64_t frame = resourceCompletedFrames_m; frame < resourceFrame_m; frame++) {
+        glDeleteSync(resourceFences_m[frame % RESOURCE_MAX_FRAMES]);
+    }
+    resourceCompletedFrames_m = resourceFrame_m;
+}
+
+void Resources_endFrame() {
+    uint64_t frame = resourceFrame_m;
+    resourceFences_m[frame % RESOURCE_MAX_FRAMES] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    __atomic_store_n(&resourceFrame_m, frame + 1, __ATOMIC_RELEASE);
+
+    // check the oldest fences without waiting, only block if the ring is full
+    while (resourceCompletedFrames_m < resourceFrame_m) {
+        GLsync fence = resourceFences_m[resourceCompletedFrames_m % RESOURCE_MAX_FRAMES];
+        bool full = resourceFrame_m - resourceCompletedFrames_m >= RESOURCE_MAX_FRAMES;
+
+        GLenum result = glClientWaitSync(fence, 0, full ? 1000000000 : 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            if (!full) break;
+            continue;
+        }
+        if (result == GL_WAIT_FAILED) {
+            fprintf(stderr, "Error: Waiting on a resource fence failed, finishing instead.\n");
+            glFinish();
+        }
+
+        glDeleteSync(fence);
+        resourceCompletedFrames_m++;
+    }
+
+    pthread_mutex_lock(&resourceMutex_m);
+    int32_t prev = RESOURCE_NONE;
+    int32_t slot = resourcePending_m;
+    while (slot != RESOURCE_NONE) {
+        Resource_t *res = &resources_m[slot];
+        int32_t next = res->next;
+
+        if (res->releaseFrame >= resourceCompletedFrames_m) {
+            prev = slot;
+            slot = next;
+            continue;
+        }
+
+        if (prev == RESOURCE_NONE) resourcePending_m = next;
+        else resources_m[prev].next = next;
+        resourceStats_m.pending--;
+
+        bool poolable = res->type == RESOURCE_BUFFER || res->type == RESOURCE_TEXTURE;
+        if (poolable && resourceStats_m.pooledBytes + res->size <= RESOURCE_POOL_BUDGET) {
+            res->state = RESOURCE_STATE_POOLED;
+            res->next = resourcePools_m[res->type];
+            resourcePools_m[res->type] = slot;
+            resourceStats_m.pooled++;
+            resourceStats_m.pooledBytes += res->size;
+        } else {
+            Resource_destroy(slot);
+        }
+
+        slot = next;
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+}
+
+uint64_t Resources_currentFrame() {
+    return __atomic_load_n(&resourceFrame_m, __ATOMIC_ACQUIRE);
+}
+
+bool Resources_frameDone(uint64_t frame) {
+    return frame < resourceCompletedFrames_m;
+}
+
+void Resources_getStats(ResourceStats_t *stats) {
+    pthread_mutex_lock(&resourceMutex_m);
+    *stats = resourceStats_m;
+    pthread_mutex_unlock(&resourceMutex_m);
+}
+
+static size_t Resources_bucketSize(size_t size) {
+    size_t bucket = RESOURCE_MIN_BUFFER_SIZE;
+    while (bucket < size) bucket <<= 1;
+    return bucket;
+}
+
+typedef struct {
+    size_t size;
+    GLenum usage;
+} BufferMatch_t;
+
+static bool Resources_matchBuffer(Resource_t *res, void *data) {
+    BufferMatch_t *match = data;
+    return res->size == match->size && res->usage == match->usage;
+}
+
+BufferHandle_t Resources_acquireBuffer(size_t size, GLenum usage) {
+    BufferMatch_t match = { Resources_bucketSize(size), usage };
+
+    pthread_mutex_lock(&resourceMutex_m);
+    int32_t slot = Resource_takePooled(RESOURCE_BUFFER, Resources_matchBuffer, &match);
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot != RESOURCE_NONE) {
+        return (BufferHandle_t) { Resource_toId(slot) };
+    }
+
+    GLuint name;
+    glCreateBuffers(1, &name);
+    if (usage == GL_STATIC_DRAW) {
+        // static data is written once and never resized, so it can have immutable storage
+        glNamedBufferStorage(name, match.size, NULL, GL_DYNAMIC_STORAGE_BIT);
+    } else {
+        glNamedBufferData(name, match.size, NULL, usage);
+    }
+
+    pthread_mutex_lock(&resourceMutex_m);
+    slot = Resource_alloc(RESOURCE_BUFFER, name);
+    if (slot != RESOURCE_NONE) {
+        resources_m[slot].size = match.size;
+        resources_m[slot].usage = usage;
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot == RESOURCE_NONE) {
+        glDeleteBuffers(1, &name);
+        return (BufferHandle_t) { 0 };
+    }
+    return (BufferHandle_t) { Resource_toId(slot) };
+}
+
+// GL name behind a handle, 0 if it's stale. Locked, a release on another thread can destroy the slot
+static GLuint Resource_name(uint32_t id, ResourceType_e type) {
+    pthread_mutex_lock(&resourceMutex_m);
+    Resource_t *res = Resource_get(id, type);
+    GLuint name = res != NULL ? res->name : 0;
+    pthread_mutex_unlock(&resourceMutex_m);
+    return name;
+}
+
+GLuint Resources_bufferName(BufferHandle_t handle) {
+    return Resource_name(handle.id, RESOURCE_BUFFER);
+}
+
+// locked too, Resources_resizeBuffer changes it
+size_t Resources_bufferSize(BufferHandle_t handle) {
+    pthread_mutex_lock(&resourceMutex_m);
+    Resource_t *res = Resource_get(handle.id, RESOURCE_BUFFER);
+    size_t size = res != NULL ? res->size : 0;
+    pthread_mutex_unlock(&resourceMutex_m);
+    return size;
+}
+
+void Resources_resizeBuffer(BufferHandle_t handle, size_t size) {
+    pthread_mutex_lock(&resourceMutex_m);
+    Resource_t *res = Resource_get(handle.id, RESOURCE_BUFFER);
+    if (res == NULL) {
+        pthread_mutex_unlock(&resourceMutex_m);
+        fprintf(stderr, "Error: Attempted to resize invalid buffer handle %08x.\n", handle.id);
+        return;
+    }
+
+    if (res->usage == GL_STATIC_DRAW) {
+        pthread_mutex_unlock(&resourceMutex_m);
+        fprintf(stderr, "Error: Attempted to resize static buffer %08x, its storage is immutable.\n", handle.id);
+        return;
+    }
+
+    res->size = Resources_bucketSize(size);
+    GLuint name = res->name;
+    size_t bytes = res->size;
+    GLenum usage = res->usage;
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    // the driver orphans the old storage, frames still reading it keep it alive
+    glNamedBufferData(name, bytes, NULL, usage);
+}
+
+void Resources_retainBuffer(BufferHandle_t handle) {
+    Resource_retain(handle.id, RESOURCE_BUFFER);
+}
+
+void Resources_releaseBuffer(BufferHandle_t handle) {
+    Resource_release(handle.id, RESOURCE_BUFFER);
+}
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    GLenum format;
+    uint32_t levels;
+    uint32_t layers;
+} TextureMatch_t;
+
+static bool Resources_matchTexture(Resource_t *res, void *data) {
+    TextureMatch_t *match = data;
+    return res->width == match->width && res->height == match->height && res->format == match->format
+        && res->levels == match->levels && res->layers == match->layers;
+}
+
+// roughly what the driver allocates, only used for the pool budget
+static size_t Resources_textureBytes(uint32_t width, uint32_t height, GLenum format, uint32_t levels) {
+    size_t bits;
+    switch (format) {
+    case GL_R8: bits = 8; break;
+    case GL_RG8: bits = 16; break;
+    case GL_RGBA16F: bits = 64; break;
+    case GL_RGBA32F: bits = 128; break;
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: bits = 4; break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: bits = 8; break;
+    default: bits = 32; break;
+    }
+
+    size_t size = (size_t) width * height * bits / 8;
+    // a full mip chain adds another third
+    return levels > 1 ? size + size / 3 : size;
+}
+
+TextureHandle_t Resources_acquireTexture(uint32_t width, uint32_t height, GLenum internalFormat, uint32_t levels) {
+    TextureMatch_t match = { width, height, internalFormat, levels, 0 };
+
+    pthread_mutex_lock(&resourceMutex_m);
+    int32_t slot = Resource_takePooled(RESOURCE_TEXTURE, Resources_matchTexture, &match);
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot != RESOURCE_NONE) {
+        glBindTexture(GL_TEXTURE_2D, resources_m[slot].name);
+        return (TextureHandle_t) { Resource_toId(slot) };
+    }
+
+    GLuint name;
+    glGenTextures(1, &name);
+    glBindTexture(GL_TEXTURE_2D, name);
+    glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+
+    pthread_mutex_lock(&resourceMutex_m);
+    slot = Resource_alloc(RESOURCE_TEXTURE, name);
+    if (slot != RESOURCE_NONE) {
+        Resource_t *res = &resources_m[slot];
+        res->width = width;
+        res->height = height;
+        res->format = internalFormat;
+        res->levels = levels;
+        res->size = Resources_textureBytes(width, height, internalFormat, levels);
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot == RESOURCE_NONE) {
+        glDeleteTextures(1, &name);
+        return (TextureHandle_t) { 0 };
+    }
+    return (TextureHandle_t) { Resource_toId(slot) };
+}
+
+TextureHandle_t Resources_acquireTextureArray(uint32_t width, uint32_t height, uint32_t layers, GLenum internalFormat, uint32_t levels) {
+    TextureMatch_t match = { width, height, internalFormat, levels, layers };
+
+    pthread_mutex_lock(&resourceMutex_m);
+    int32_t slot = Resource_takePooled(RESOURCE_TEXTURE, Resources_matchTexture, &match);
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot != RESOURCE_NONE) return (TextureHandle_t) { Resource_toId(slot) };
+
+    GLuint name;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &name);
+    glTextureStorage3D(name, levels, internalFormat, width, height, layers);
+
+    pthread_mutex_lock(&resourceMutex_m);
+    slot = Resource_alloc(RESOURCE_TEXTURE, name);
+    if (slot != RESOURCE_NONE) {
+        Resource_t *res = &resources_m[slot];
+        res->width = width;
+        res->height = height;
+        res->format = internalFormat;
+        res->levels = levels;
+        res->layers = layers;
+        res->size = Resources_textureBytes(width, height, internalFormat, levels) * layers;
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot == RESOURCE_NONE) {
+        glDeleteTextures(1, &name);
+        return (TextureHandle_t) { 0 };
+    }
+    return (TextureHandle_t) { Resource_toId(slot) };
+}
+
+GLuint Resources_textureName(TextureHandle_t handle) {
+    return Resource_name(handle.id, RESOURCE_TEXTURE);
+}
+
+void Resources_retainTexture(TextureHandle_t handle) {
+    Resource_retain(handle.id, RESOURCE_TEXTURE);
+}
+
+void Resources_releaseTexture(TextureHandle_t handle) {
+    Resource_release(handle.id, RESOURCE_TEXTURE);
+}
+
+VertexArrayHandle_t Resources_createVertexArray() {
+    // created rather than generated, so DSA calls work on it before it's ever bound
+    GLuint name;
+    glCreateVertexArrays(1, &name);
+
+    pthread_mutex_lock(&resourceMutex_m);
+    int32_t slot = Resource_alloc(RESOURCE_VERTEX_ARRAY, name);
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot == RESOURCE_NONE) {
+        glDeleteVertexArrays(1, &name);
+        return (VertexArrayHandle_t) { 0 };
+    }
+    return (VertexArrayHandle_t) { Resource_toId(slot) };
+}
+
+GLuint Resources_vertexArrayName(VertexArrayHandle_t handle) {
+    return Resource_name(handle.id, RESOURCE_VERTEX_ARRAY);
+}
+
+void Resources_releaseVertexArray(VertexArrayHandle_t handle) {
+    Resource_release(handle.id, RESOURCE_VERTEX_ARRAY);
+}
+
+// Index entry a key lives in, or the empty one it would go in, lock has to be held
+static uint32_t Resources_programIndex(const char *key) {
+    uint32_t index = (uint32_t) Archive_hash(key) & (RESOURCE_PROGRAM_INDEX_SIZE - 1);
+    while (resourcePrograms_m[index] != RESOURCE_NONE && strcmp(resources_m[resourcePrograms_m[index]].key, key) != 0) {
+        index = (index + 1) & (RESOURCE_PROGRAM_INDEX_SIZE - 1);
+    }
+    return index;
+}
+
+// Finds a cached program and takes a reference to it, lock has to be held
+static int32_t Resources_findProgram(const char *key) {
+    int32_t slot = resourcePrograms_m[Resources_programIndex(key)];
+    if (slot == RESOURCE_NONE) return RESOURCE_NONE;
+
+    Resource_t *res = &resources_m[slot];
+    if (res->state == RESOURCE_STATE_POOLED) {
+        res->state = RESOURCE_STATE_LIVE;
+        res->refCount = 0;
+        resourceStats_m.pooled--;
+        resourceStats_m.live++;
+    }
+    res->refCount++;
+    resourceStats_m.reused++;
+    return slot;
+}
+
+static ProgramHandle_t Resources_loadProgramKeyed(const char *key, const char *vertexPath, const char *fragPath, const char *computePath) {
+    pthread_mutex_lock(&resourceMutex_m);
+    int32_t slot = Resources_findProgram(key);
+    pthread_mutex_unlock(&resourceMutex_m);
+    if (slot != RESOURCE_NONE) return (ProgramHandle_t) { Resource_toId(slot) };
+
+    GLuint name = computePath != NULL ? Shader_loadComputeProgram(computePath) : Shader_loadProgram(vertexPath, fragPath);
+
+    if (name == 0) {
+        fprintf(stderr, "Error: Couldn't build program %s\n", key);
+        return (ProgramHandle_t) { 0 };
+    }
+
+    pthread_mutex_lock(&resourceMutex_m);
+    // someone else might have built the same one while we were compiling
+    slot = Resources_findProgram(key);
+    if (slot != RESOURCE_NONE) {
+        glDeleteProgram(name);
+    } else {
+        slot = Resource_alloc(RESOURCE_PROGRAM, name);
+        if (slot != RESOURCE_NONE) {
+            resources_m[slot].key = Memory_strdup(MEMORY_TAG_RENDERER, key);
+            resourcePrograms_m[Resources_programIndex(key)] = slot;
+        } else {
+            glDeleteProgram(name);
+        }
+    }
+    pthread_mutex_unlock(&resourceMutex_m);
+
+    if (slot == RESOURCE_NONE) return (ProgramHandle_t) { 0 };
+    return (ProgramHandle_t) { Resource_toId(slot) };
+}
+
+ProgramHandle_t Resources_loadProgram(const char *vertexPath, const char *fragPath) {
+    char key[512];
+    snprintf(key, sizeof(key), "%s|%s", vertexPath, fragPath);
+    return Resources_loadProgramKeyed(key, vertexPath, fragPath, NULL);
+}
+
+ProgramHandle_t Resources_loadComputeProgram(const char *computePath) {
+    return Resources_loadProgramKeyed(computePath, NULL, NULL, computePath);
+}
+
+GLuint Resources_programName(ProgramHandle_t handle) {
+    return Resource_name(handle.id, RESOURCE_PROGRAM);
+}
+
+void Resources_retainProgram(ProgramHandle_t handle) {
+    Resource_retain(handle.id, RESOURCE_PROGRAM);
+}
+
+void Resources_releaseProgram(ProgramHandle_t handle) {
+    Resource_release(handle.id, RESOURCE_PROGRAM);
+}
@@ -0,0 +1,142 @@
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <glad/glad.h>
+
+// GL objects that can be tracked at once
+#define RESOURCE_MAX 4096
+// frames we keep fences for, way more than a driver queues up
+#define RESOURCE_MAX_FRAMES 8
+// bytes of unused buffers and textures kept around to be handed out again
+#define RESOURCE_POOL_BUDGET (256u << 20)
+
+// S3TC is everywhere on desktop but glad only has core enums
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+typedef enum {
+    RESOURCE_BUFFER,
+    RESOURCE_TEXTURE,
+    RESOURCE_VERTEX_ARRAY,
+    RESOURCE_PROGRAM,
+
+    RESOURCE_TYPE_TOTAL
+} ResourceType_e;
+
+// Handles are slot + 1 in the low 16 bits and the slot's generation in the high 16,
+// so 0 is never valid and a stale handle can't reach whatever reused its slot
+typedef struct {
+    uint32_t id;
+} BufferHandle_t;
+
+typedef struct {
+    uint32_t id;
+} TextureHandle_t;
+
+typedef struct {
+    uint32_t id;
+} VertexArrayHandle_t;
+
+typedef struct {
+    uint32_t id;
+} ProgramHandle_t;
+
+typedef struct {
+    // objects someone holds a reference to
+    uint32_t live;
+    // waiting on a fence before they can be pooled or deleted
+    uint32_t pending;
+    // unreferenced, ready to be handed out again
+    uint32_t pooled;
+    size_t pooledBytes;
+
+    // acquires served by making a new GL object vs. out of the pool/cache
+    uint32_t created;
+    uint32_t reused;
+} ResourceStats_t;
+
+/**
+ * Owns every GL buffer, texture, VAO and program. Objects are reference counted,
+ * and when the last reference goes away they wait until the GPU has finished
+ * every frame that could have used them. Buffers and textures then go into a
+ * pool to be handed out again for the same size/format, programs stay cached
+ * by path, and VAOs are deleted.
+ *
+ * Safe to use from the loader thread, except VAOs and Resources_endFrame which
+ * are main thread only.
+ */
+void Resources_init();
+
+// Deletes everything and reports what was never released, call with the main context current
+void Resources_shutdown();
+
+// Fences the frame that was just submitted and retires releases whose frames are done. Never waits on the GPU
+void Resources_endFrame();
+
+// The frame being recorded, for objects kept outside of here that need the same wait before deleting
+uint64_t Resources_currentFrame();
+
+// True once the GPU has finished frame, as returned by Resources_currentFrame
+bool Resources_frameDone(uint64_t frame);
+
+void Resources_getStats(ResourceStats_t *stats);
+
+// Buffer with at least size bytes of storage, contents are undefined. Doesn't touch any bindings,
+// fill it with glNamedBufferSubData. GL_STATIC_DRAW buffers get immutable storage
+BufferHandle_t Resources_acquireBuffer(size_t size, GLenum usage);
+
+GLuint Resources_bufferName(BufferHandle_t handle);
+
+// Actual storage size, sizes are rounded up so buffers can be pooled
+size_t Resources_bufferSize(BufferHandle_t handle);
+
+// Reallocates storage in place, keeping the GL name so VAOs pointing at it stay valid.
+// Not for GL_STATIC_DRAW buffers. Doesn't touch any bindings
+void Resources_resizeBuffer(BufferHandle_t handle, size_t size);
+
+void Resources_retainBuffer(BufferHandle_t handle);
+
+void Resources_releaseBuffer(BufferHandle_t handle);
+
+// Immutable 2D texture storage, contents are undefined. Left bound to GL_TEXTURE_2D
+TextureHandle_t Resources_acquireTexture(uint32_t width, uint32_t height, GLenum internalFormat, uint32_t levels);
+
+// Immutable GL_TEXTURE_2D_ARRAY storage, pooled apart from plain 2D textures. Doesn't touch any bindings
+TextureHandle_t Resources_acquireTextureArray(uint32_t width, uint32_t height, uint32_t layers, GLenum internalFormat, uint32_t levels);
+
+GLuint Resources_textureName(TextureHandle_t handle);
+
+void Resources_retainTexture(TextureHandle_t handle);
+
+void Resources_releaseTexture(TextureHandle_t handle);
+
+// Main thread only, VAOs belong to the context they were made in
+VertexArrayHandle_t Resources_createVertexArray();
+
+GLuint Resources_vertexArrayName(VertexArrayHandle_t handle);
+
+void Resources_releaseVertexArray(VertexArrayHandle_t handle);
+
+// Compiled once per path pair and cached, later loads just add a reference
+ProgramHandle_t Resources_loadProgram(const char *vertexPath, const char *fragPath);
+
+ProgramHandle_t Resources_loadComputeProgram(const char *computePath);
+
+GLuint Resources_programName(ProgramHandle_t handle);
+
+void Resources_retainProgram(ProgramHandle_t handle);
+
+void Resources_releaseProgram(ProgramHandle_t handle);
+
+#endif
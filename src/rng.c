@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "rng.h"
+
+// intrin.h needs cglm's types set up first
+#include <cglm/types.h>
+#include <cglm/simd/intrin.h>
+
+uint64_t rngMasterSeed_m = RNG_DEFAULT_SEED;
+
+// odd constant from the golden ratio, spreads stream ids apart before mixing
+#define RNG_GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL
+
+void Rng_setSeed(uint64_t seed) {
+    rngMasterSeed_m = seed;
+}
+
+uint64_t Rng_getSeed() {
+    return rngMasterSeed_m;
+}
+
+uint64_t Rng_splitmix64(uint64_t *state) {
+    uint64_t z = (*state += RNG_GOLDEN_GAMMA);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t Rng_streamSeed(RngStream_e stream, uint64_t index) {
+    uint64_t state = rngMasterSeed_m ^ ((uint64_t) (stream + 1) * RNG_GOLDEN_GAMMA);
+    Rng_splitmix64(&state);
+    state ^= index;
+    return Rng_splitmix64(&state);
+}
+
+static inline uint32_t rotl32(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+// top 24 bits, every value is exactly representable as a float
+static inline float toFloat(uint32_t x) {
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+void Pcg32_init(Pcg32_t *rng, uint64_t seed, uint64_t sequence) {
+    rng->state = 0;
+    rng->inc = (sequence << 1) | 1;
+    Pcg32_next(rng);
+    rng->state += seed;
+    Pcg32_next(rng);
+}
+
+uint32_t Pcg32_next(Pcg32_t *rng) {
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+
+    uint32_t xorshifted = (uint32_t) (((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t) (old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+float Pcg32_nextFloat(Pcg32_t *rng) {
+    return toFloat(Pcg32_next(rng));
+}
+
+float Pcg32_range(Pcg32_t *rng, float min, float max) {
+    return min + Pcg32_nextFloat(rng) * (max - min);
+}
+
+// Lemire's multiply and reject, see "Fast Random Integer Generation in an Interval" (2019)
+uint32_t Pcg32_nextBounded(Pcg32_t *rng, uint32_t bound) {
+    if (bound == 0) return 0;
+
+    uint64_t m = (uint64_t) Pcg32_next(rng) * bound;
+    uint32_t low = (uint32_t) m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (uint64_t) Pcg32_next(rng) * bound;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+void Xoshiro128_init(Xoshiro128_t *rng, uint64_t seed) {
+    uint64_t state = seed;
+    uint64_t a = Rng_splitmix64(&state);
+    uint64_t b = Rng_splitmix64(&state);
+
+    rng->s[0] = (uint32_t) a;
+    rng->s[1] = (uint32_t) (a >> 32);
+    rng->s[2] = (uint32_t) b;
+    rng->s[3] = (uint32_t) (b >> 32);
+}
+
+uint32_t Xoshiro128_next(Xoshiro128_t *rng) {
+    uint32_t *s = rng->s;
+    uint32_t result = rotl32(s[0] + s[3], 7) + s[0];
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl32(s[3], 11);
+
+    return result;
+}
+
+float Xoshiro128_nextFloat(Xoshiro128_t *rng) {
+    return toFloat(Xoshiro128_next(rng));
+}
+
+void Xoshiro128_jump(Xoshiro128_t *rng) {
+    static const uint32_t JUMP[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 32; b++) {
+            if (JUMP[i] & (1u << b)) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            Xoshiro128_next(rng);
+        }
+    }
+
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
+
+void Xoshiro128x4_init(Xoshiro128x4_t *rng, uint64_t seed) {
+    Xoshiro128_t lane;
+    Xoshiro128_init(&lane, seed);
+
+    for (int l = 0; l < 4; l++) {
+        for (int w = 0; w < 4; w++) {
+            rng->s[w][l] = lane.s[w];
+        }
+        Xoshiro128_jump(&lane);
+    }
+}
+
+// one step of all 4 lanes, the same math as Xoshiro128_next
+static void Xoshiro128x4_step(Xoshiro128x4_t *rng, uint32_t out[4]) {
+#if defined(CGLM_SSE2_FP)
+    __m128i s0 = _mm_load_si128((__m128i*) rng->s[0]);
+    __m128i s1 = _mm_load_si128((__m128i*) rng->s[1]);
+    __m128i s2 = _mm_load_si128((__m128i*) rng->s[2]);
+    __m128i s3 = _mm_load_si128((__m128i*) rng->s[3]);
+
+    // SSE2 has no rotate, so shift both ways and or them back together
+    __m128i sum = _mm_add_epi32(s0, s3);
+    __m128i result = _mm_add_epi32(_mm_or_si128(_mm_slli_epi32(sum, 7), _mm_srli_epi32(sum, 25)), s0);
+    __m128i t = _mm_slli_epi32(s1, 9);
+
+    s2 = _mm_xor_si128(s2, s0);
+    s3 = _mm_xor_si128(s3, s1);
+    s1 = _mm_xor_si128(s1, s2);
+    s0 = _mm_xor_si128(s0, s3);
+    s2 = _mm_xor_si128(s2, t);
+    s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+    _mm_store_si128((__m128i*) rng->s[0], s0);
+    _mm_store_si128((__m128i*) rng->s[1], s1);
+    _mm_store_si128((__m128i*) rng->s[2], s2);
+    _mm_store_si128((__m128i*) rng->s[3], s3);
+    _mm_storeu_si128((__m128i*) out, result);
+#elif defined(CGLM_NEON_FP)
+    uint32x4_t s0 = vld1q_u32(rng->s[0]);
+    uint32x4_t s1 = vld1q_u32(rng->s[1]);
+    uint32x4_t s2 = vld1q_u32(rng->s[2]);
+    uint32x4_t s3 = vld1q_u32(rng->s[3]);
+
+    uint32x4_t sum = vaddq_u32(s0, s3);
+    uint32x4_t result = vaddq_u32(vsriq_n_u32(vshlq_n_u32(sum, 7), sum, 25), s0);
+    uint32x4_t t = vshlq_n_u32(s1, 9);
+
+    s2 = veorq_u32(s2, s0);
+    s3 = veorq_u32(s3, s1);
+    s1 = veorq_u32(s1, s2);
+    s0 = veorq_u32(s0, s3);
+    s2 = veorq_u32(s2, t);
+    s3 = vsriq_n_u32(vshlq_n_u32(s3, 11), s3, 21);
+
+    vst1q_u32(rng->s[0], s0);
+    vst1q_u32(rng->s[1], s1);
+    vst1q_u32(rng->s[2], s2);
+    vst1q_u32(rng->s[3], s3);
+    vst1q_u32(out, result);
+#else
+    for (int l = 0; l < 4; l++) {
+        Xoshiro128_t lane = {{ rng->s[0][l], rng->s[1][l], rng->s[2][l], rng->s[3][l] }};
+        out[l] = Xoshiro128_next(&lane);
+        for (int w = 0; w < 4; w++) {
+            rng->s[w][l] = lane.s[w];
+        }
+    }
+#endif
+}
+
+void Xoshiro128x4_fillU32(Xoshiro128x4_t *rng, uint32_t *out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        Xoshiro128x4_step(rng, out + i);
+    }
+
+    if (i < count) {
+        uint32_t tail[4];
+        Xoshiro128x4_step(rng, tail);
+        memcpy(out + i, tail, (count - i) * sizeof(uint32_t));
+    }
+}
+
+void Xoshiro128x4_fillFloat(Xoshiro128x4_t *rng, float *out, size_t count, float min, float max) {
+    float scale = (max - min) * (1.0f / 16777216.0f);
+    size_t i = 0;
+
+#if defined(CGLM_SSE2_FP)
+    __m128 vMin = _mm_set1_ps(min);
+    __m128 vScale = _mm_set1_ps(scale);
+
+    for (; i + 4 <= count; i += 4) {
+        uint32_t bits[4] __attribute__((aligned(16)));
+        Xoshiro128x4_step(rng, bits);
+
+        __m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_load_si128((__m128i*) bits), 8));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(f, vScale), vMin));
+    }
+#elif defined(CGLM_NEON_FP)
+    float32x4_t vMin = vdupq_n_f32(min);
+    float32x4_t vScale = vdupq_n_f32(scale);
+
+    for (; i + 4 <= count; i += 4) {
+        uint32_t bits[4];
+        Xoshiro128x4_step(rng, bits);
+
+        float32x4_t f = vcvtq_f32_u32(vshrq_n_u32(vld1q_u32(bits), 8));
+        vst1q_f32(out + i, vaddq_f32(vmulq_f32(f, vScale), vMin));
+    }
+#endif
+
+    while (i < count) {
+        uint32_t bits[4];
+        Xoshiro128x4_step(rng, bits);
+
+        for (int l = 0; l < 4 && i < count; l++, i++) {
+            out[i] = (float) (bits[l] >> 8) * scale + min;
+        }
+    }
+}
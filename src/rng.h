@@ -0,0 +1,84 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// used when DW_SEED isn't set, so runs are the same unless asked otherwise
+#define RNG_DEFAULT_SEED 0x44656c746157696eULL
+
+/**
+ * Each system that needs randomness gets its own stream. Streams are derived
+ * from the master seed, so one seed reproduces a whole run, and no generator
+ * state is shared between threads.
+ */
+typedef enum {
+    RNG_STREAM_LEVEL,
+    RNG_STREAM_PARTICLES,
+
+    RNG_STREAM_TOTAL
+} RngStream_e;
+
+// PCG-XSH-RR, 64 bits of state and a selectable sequence
+typedef struct {
+    uint64_t state;
+    uint64_t inc;
+} Pcg32_t;
+
+// xoshiro128++, 128 bits of state, jumpable for parallel sequences
+typedef struct {
+    uint32_t s[4];
+} Xoshiro128_t;
+
+// 4 xoshiro128++ generators, 2^64 steps apart, stepped together with SIMD. s[word][lane]
+typedef struct {
+    uint32_t s[4][4] __attribute__((aligned(16)));
+} Xoshiro128x4_t;
+
+// Sets the master seed every stream is derived from. Call before anything seeds itself
+void Rng_setSeed(uint64_t seed);
+
+uint64_t Rng_getSeed();
+
+// Seed for one stream, index picks an independent sub stream (a chunk index, an emitter...)
+uint64_t Rng_streamSeed(RngStream_e stream, uint64_t index);
+
+// Steps a splitmix64 state, used to expand seeds into generator state
+uint64_t Rng_splitmix64(uint64_t *state);
+
+void Pcg32_init(Pcg32_t *rng, uint64_t seed, uint64_t sequence);
+
+uint32_t Pcg32_next(Pcg32_t *rng);
+
+// [0, 1)
+float Pcg32_nextFloat(Pcg32_t *rng);
+
+// [min, max)
+float Pcg32_range(Pcg32_t *rng, float min, float max);
+
+// [0, bound), without modulo bias
+uint32_t Pcg32_nextBounded(Pcg32_t *rng, uint32_t bound);
+
+void Xoshiro128_init(Xoshiro128_t *rng, uint64_t seed);
+
+uint32_t Xoshiro128_next(Xoshiro128_t *rng);
+
+// [0, 1)
+float Xoshiro128_nextFloat(Xoshiro128_t *rng);
+
+// Skips ahead 2^64 steps, gives non-overlapping sequences from one seed
+void Xoshiro128_jump(Xoshiro128_t *rng);
+
+void Xoshiro128x4_init(Xoshiro128x4_t *rng, uint64_t seed);
+
+/**
+ * Batch fills, values come out lane interleaved (out[i * 4 + lane]) and are the
+ * same with or without SIMD. A count that isn't a multiple of 4 still uses up
+ * a whole step of every lane.
+ */
+void Xoshiro128x4_fillU32(Xoshiro128x4_t *rng, uint32_t *out, size_t count);
+
+// [min, max)
+void Xoshiro128x4_fillFloat(Xoshiro128x4_t *rng, float *out, size_t count, float min, float max);
+
+#endif
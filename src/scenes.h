@@ -5,7 +5,8 @@
 #include "scenes/world.h"
 
 Scene_t Scene_MainMenu = {
-    .init = MainMenu_init,
+    .preload = NULL,
+    .activate = MainMenu_activate,
     .tick = MainMenu_tick,
     .render = MainMenu_render,
     .exit = MainMenu_exit,
@@ -14,7 +15,8 @@ Scene_t Scene_MainMenu = {
 };
 
 Scene_t Scene_World = {
-    .init = World_init,
+    .preload = World_preload,
+    .activate = World_activate,
     .tick = World_tick,
     .render = World_render,
     .exit = World_exit,
@@ -1,6 +1,8 @@
 #include "mainmenu.h"
 
 #include "../globals.h"
+#include "../loader.h"
+#include "../postfx.h"
 
 // amount of menu options
 #define SELECTION_MAX 2
@@ -9,7 +11,12 @@ char* titleText = "DeltaWing, flappy clone";
 uint32_t titleWidth;
 uint8_t selectionIndex = 1;
 
-void MainMenu_init() {
+// wireframe delta wing over the title, nose pointing right
+vec2 logoOutline[] = {
+    { 48.0f, 0.0f }, { -32.0f, -36.0f }, { -20.0f, 0.0f }, { -32.0f, 36.0f }
+};
+
+void MainMenu_activate() {
     titleWidth = FontRenderer_getStringWidth(fontRenderer, titleText);
 }
 
@@ -18,6 +25,21 @@ void MainMenu_tick() {
 }
 
 void MainMenu_render() {
+    vec2 logoPosition = { DISPLAY_WIDTHF / 2.0f, (DISPLAY_HEIGHTF / 2.0f) - (fontRenderer->charHeight * 4.0f) };
+    vec2 logo[4];
+    for (int i = 0; i < 4; i++) {
+        glm_vec2_add(logoOutline[i], logoPosition, logo[i]);
+    }
+
+    vec4 logoColor = { 0.2f, 0.9f, 1.0f, 1.0f };
+    LineRenderer_setGlow(lineRenderer, 6.0f, 0.35f);
+    LineRenderer_addPolyline(lineRenderer, (const vec2*) logo, 4, true, 2.0f, logoColor);
+    LineRenderer_add(lineRenderer, logo[0], logo[2], 1.0f, logoColor);
+    LineRenderer_flush(lineRenderer);
+
+    // text stays at native resolution
+    PostFx_overlay();
+
     FontRenderer_setColor(fontRenderer, (vec4) { 1.0f, 0.0f, 0.0f, 1.0f });
     FontRenderer_drawString(fontRenderer, titleText, 
         (DISPLAY_WIDTHF / 2.0f) - (titleWidth / 2.0f),
@@ -39,6 +61,16 @@ void MainMenu_render() {
         14.0f,
         (DISPLAY_HEIGHTF / 2.0f) + (fontRenderer->charHeight * 2.0f)
     );
+
+    // the world loads in the background, so we keep drawing until it's ready
+    if (SceneLoader_isLoading()) {
+        char *loadingText[] = { "Loading", "Loading.", "Loading..", "Loading..." };
+        int frame = (int) (glfwGetTime() * 4.0) % 4;
+        FontRenderer_drawString(fontRenderer, loadingText[frame],
+            14.0f,
+            (DISPLAY_HEIGHTF / 2.0f) + (fontRenderer->charHeight * 4.0f)
+        );
+    }
 }
 
 void MainMenu_exit() {
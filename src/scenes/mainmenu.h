@@ -1,7 +1,7 @@
 #ifndef MAINMENU_H
 #define MAINMENU_H
 
-void MainMenu_init();
+void MainMenu_activate();
 
 void MainMenu_tick();
 
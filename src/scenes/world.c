@@ -1,7 +1,20 @@
 #include "world.h"
 
 #include "../engine.h"
+#include "../util.h"
+#include "../arena.h"
+#include "../camera.h"
+#include "../collision.h"
+#include "../culling.h"
+#include "../level.h"
+#include "../particles.h"
+#include "../postfx.h"
+#include "../rng.h"
+#include "../atlas.h"
+#include "../sprites.h"
+#include "../texstream.h"
 #include "../entities/player.h"
+#include "../memory.h"
 
 
 GameObj_t playerObj;
@@ -13,142 +26,514 @@ Entity_t player = {
     .kill = Player_kill
 };
 
-typedef struct {
-    vec2 pos;
-    float gap;
-} Pipe_t;
-
 Renderer_t *pipeRenderer;
-
 VertexBuffer_t *pipeVB;
 IndexBuffer_t *pipeIB;
+VertexBuffer_t *pipeInstanceVb;
 
+// every chunk slot's decoration mesh lives in one buffer, chunk slot * LEVEL_MAX_DECORATION_VERTICES onwards
+Renderer_t *decorationRenderer;
+VertexBuffer_t *decorationVB;
+IndexBuffer_t *decorationIB;
+uint32_t decorationIndices[LEVEL_POOL_SIZE * LEVEL_MAX_DECORATION_VERTICES];
 
-Pipe_t pipes[5];
-int pipeCount = 0;
+// each pool slot gets a chunk node, then its pipes and pickups as children,
+// so placing a chunk is one position change
+#define CHUNK_PIPE_NODES (LEVEL_MAX_OBSTACLES * 2)
+#define CHUNK_NODES (1 + CHUNK_PIPE_NODES + LEVEL_MAX_PICKUPS)
+#define MAX_PIPES (LEVEL_POOL_SIZE * CHUNK_PIPE_NODES)
+#define MAX_PICKUPS (LEVEL_POOL_SIZE * LEVEL_MAX_PICKUPS)
 
-int nextPipe = 0;
-int pipeTickTimer = 0;
+TransformSystem_t levelTransforms;
+LevelStreamer_t level;
 
-void genPipe() {
-    float random = (float) rand() / RAND_MAX;
-    Pipe_t pipe;
+const float PIPE_WIDTH = 50.0f;
+// tall enough to reach past the edge of the screen from any opening
+const float PIPE_HEIGHT = 800.0f;
+const float PICKUP_SIZE = 24.0f;
+// the gem is a diamond drawn into a square, so the sprite is wider than the hitbox
+const float PICKUP_SPRITE_SIZE = 32.0f;
+
+// player hitbox, roughly the size of the triangle
+const float PLAYER_SIZE = 40.0f;
+// units per tick the player flies forward
+const float PLAYER_SPEED = 10.0f;
+// keep the player a quarter of the way in from the left
+const float CAMERA_LEAD = DISPLAY_WIDTHF / 4.0f;
+
+uint32_t score = 0;
+
+// the exhaust keeps a few hundred alive and a crash bursts 4000 more
+#define MAX_PARTICLES (1 << 13)
+
+ParticleSystem_t particles;
+ParticleEmitter_t *exhaustEmitter;
+ParticleEmitter_t *explosionEmitter;
+
+SpatialHash_t pipeHash;
+CollisionPairArray_t pipeHits;
+Rect_t pipeRects[MAX_PIPES];
+uint32_t pipeRectCount = 0;
+
+// pickups grown by half the player, so the player's centre path can be cast against them
+SpatialHash_t pickupHash;
+CollisionHitArray_t pickupHits;
+Rect_t pickupRects[MAX_PICKUPS];
+LevelPickup_t *pickupRefs[MAX_PICKUPS];
+
+static uint32_t Chunk_node(LevelChunk_t *chunk) {
+    return chunk->slot * CHUNK_NODES;
+}
 
-    glm_vec2_copy((vec2) { DISPLAY_WIDTHF / 2.0f, 0.0f } ,pipe.pos);
-    pipe.gap = (random * 20.0f) + 10.0f;
-    pipes[nextPipe] = pipe;
-    if (pipeCount < 5) pipeCount++;
-    
-    if (nextPipe > 4) {
-        nextPipe = 0;
-    } else {
-        nextPipe++;
+static uint32_t Chunk_pipeNode(LevelChunk_t *chunk, uint32_t obstacle, uint32_t pipe) {
+    return Chunk_node(chunk) + 1 + obstacle * 2 + pipe;
+}
+
+static uint32_t Chunk_pickupNode(LevelChunk_t *chunk, uint32_t pickup) {
+    return Chunk_node(chunk) + 1 + CHUNK_PIPE_NODES + pickup;
+}
+
+// bottom of the bottom pipe and the top pipe, in chunk space
+void Obstacle_getPipes(LevelObstacle_t *obstacle, vec2 bottom, vec2 top) {
+    glm_vec2_copy((vec2) { obstacle->x, obstacle->gapY - obstacle->gapSize / 2.0f - PIPE_HEIGHT }, bottom);
+    glm_vec2_copy((vec2) { obstacle->x, obstacle->gapY + obstacle->gapSize / 2.0f }, top);
+}
+
+Rect_t Pipe_getRect(LevelChunk_t *chunk, vec2 pos) {
+    return (Rect_t) {
+        .pos = { chunk->x + pos[0] - PIPE_WIDTH / 2.0f, pos[1] },
+        .size = { PIPE_WIDTH, PIPE_HEIGHT }
+    };
+}
+
+Rect_t Pickup_getRect(LevelChunk_t *chunk, LevelPickup_t *pickup) {
+    return (Rect_t) {
+        .pos = { chunk->x + pickup->pos[0] - PICKUP_SIZE / 2.0f, pickup->pos[1] - PICKUP_SIZE / 2.0f },
+        .size = { PICKUP_SIZE, PICKUP_SIZE }
+    };
+}
+
+// Called by the streamer when a finished chunk comes in, places its nodes and uploads its decorations
+void World_onChunkLoaded(LevelChunk_t *chunk) {
+    Transform_setPosition(&levelTransforms, Chunk_node(chunk), (vec2) { chunk->x, 0.0f });
+
+    for (uint32_t i = 0; i < chunk->obstacleCount; i++) {
+        vec2 bottom, top;
+        Obstacle_getPipes(&chunk->obstacles[i], bottom, top);
+        Transform_setPosition(&levelTransforms, Chunk_pipeNode(chunk, i, 0), bottom);
+        Transform_setPosition(&levelTransforms, Chunk_pipeNode(chunk, i, 1), top);
+    }
+
+    for (uint32_t i = 0; i < chunk->pickupCount; i++) {
+        Transform_setPosition(&levelTransforms, Chunk_pickupNode(chunk, i), chunk->pickups[i].pos);
+    }
+
+    size_t vSize = VertexFormat_sizeOf(VERTEX_FORMAT_P2C8);
+    VertexBuffer_write(
+        decorationRenderer->vb,
+        chunk->slot * LEVEL_MAX_DECORATION_VERTICES * vSize,
+        chunk->decorationVertexCount * vSize,
+        chunk->decorationVertices
+    );
+}
+
+Rect_t Player_getRect(vec2 pos) {
+    return (Rect_t) {
+        .pos = { pos[0] - PLAYER_SIZE / 2.0f, pos[1] - PLAYER_SIZE / 2.0f },
+        .size = { PLAYER_SIZE, PLAYER_SIZE }
+    };
+}
+
+// Swept player box vs the pipes, so fast falls can't skip through one
+bool checkPlayerCollision() {
+    pipeRectCount = 0;
+    for (uint32_t c = 0; c < level.activeCount; c++) {
+        LevelChunk_t *chunk = level.active[c];
+        for (uint32_t i = 0; i < chunk->obstacleCount; i++) {
+            vec2 bottom, top;
+            Obstacle_getPipes(&chunk->obstacles[i], bottom, top);
+            pipeRects[pipeRectCount++] = Pipe_getRect(chunk, bottom);
+            pipeRects[pipeRectCount++] = Pipe_getRect(chunk, top);
+        }
+    }
+    SpatialHash_build(&pipeHash, pipeRects, pipeRectCount);
+
+    Rect_t prevBox = Player_getRect(playerObj.prevPos);
+    vec2 delta;
+    glm_vec2_sub(playerObj.pos, playerObj.prevPos, delta);
+
+    Rect_t box = prevBox;
+    glm_vec2_add(box.pos, delta, box.pos);
+
+    // broadphase with the whole area covered this tick, then the exact sweep
+    Rect_t sweptBounds;
+    Rect_union(&prevBox, &box, &sweptBounds);
+    SpatialHash_queryRects(&pipeHash, &sweptBounds, 1, &pipeHits);
+
+    for (uint32_t i = 0; i < pipeHits.size; i++) {
+        float t;
+        vec2 normal;
+        if (Rect_sweep(&prevBox, delta, &pipeRects[pipeHits.ptr[i].b], &t, normal)) {
+            return true;
+        }
     }
+
+    return false;
 }
 
-const float PIPE_WIDTH = 50.0f;
-const float PIPE_HEIGHT = 400.0f;
+// Where the player's centre went this tick vs the grown pickups, so a fast pass can't skip one
+void collectPickups() {
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < level.activeCount; c++) {
+        LevelChunk_t *chunk = level.active[c];
+        for (uint32_t i = 0; i < chunk->pickupCount; i++) {
+            LevelPickup_t *pickup = &chunk->pickups[i];
+            if (pickup->collected) continue;
+
+            Rect_t rect = Pickup_getRect(chunk, pickup);
+            glm_vec2_subs(rect.pos, PLAYER_SIZE / 2.0f, rect.pos);
+            glm_vec2_adds(rect.size, PLAYER_SIZE, rect.size);
+            pickupRects[count] = rect;
+            pickupRefs[count++] = pickup;
+        }
+    }
+    SpatialHash_build(&pickupHash, pickupRects, count);
 
-// the camera position is the centerpoint of the screen
-vec2 camPos = GLM_VEC2_ZERO;
-float camZoom = 1.0f;
+    vec2 delta;
+    glm_vec2_sub(playerObj.pos, playerObj.prevPos, delta);
+    SpatialHash_querySegment(&pickupHash, playerObj.prevPos, delta, &pickupHits);
+
+    for (uint32_t i = 0; i < pickupHits.size; i++) {
+        pickupRefs[pickupHits.ptr[i].index]->collected = true;
+        score++;
+    }
+}
+
+Camera_t camera;
+
+// sky and hills behind everything, streamed in after the scene starts. The hills scroll
+// at a fraction of the camera so they look far away
+#define HILLS_PARALLAX 0.2f
+SpriteBatch_t sprites;
+StreamedTexture_t *skyTexture;
+StreamedTexture_t *hillsTexture;
+
+// pickups are gems off one atlas page, each pickup slot keeps the same colour
+static const char *gemPaths[] = {
+    "assets/sprites/gem_gold.png",
+    "assets/sprites/gem_ruby.png",
+    "assets/sprites/gem_emerald.png"
+};
+#define GEM_COUNT (sizeof(gemPaths) / sizeof(gemPaths[0]))
+Atlas_t gemAtlas;
+uint32_t gemRegions[GEM_COUNT];
 
 mat4 overlayMatrix;
 
+// level bounds for culling, and the transform node behind each one
+CullBounds_t pipeBounds;
+CullStats_t pipeCullStats;
+uint32_t pipeNodes[MAX_PIPES];
+
+CullBounds_t pickupBounds;
+uint32_t pickupNodes[MAX_PICKUPS];
+
+// a row of half chunk cells over the loaded chunks, so off screen chunks get skipped whole
+#define CULL_CELL_SIZE (LEVEL_CHUNK_WIDTH / 2.0f)
+#define CULL_CELLS (LEVEL_POOL_SIZE * 2)
+CullGrid_t pipeGrid;
+CullGrid_t pickupGrid;
+
 void updateCamera() {
-    float width = DISPLAY_WIDTHF / camZoom;
-    float height = DISPLAY_HEIGHTF / camZoom;
-
-    mat4 camOrtho;
-    glm_ortho(
-        camPos[0] - (width / 2.f),
-        camPos[0] + (width / 2.f),
-        camPos[1] - (height / 2.f),
-        camPos[1] + (height / 2.f),
-        -1.0f,
-        0.0f,
-        camOrtho
-    );
+    // follow the player along the level
+    camera.pos[0] = DW_lerp(playerObj.prevPos[0], playerObj.pos[0], context->partialTicks) + CAMERA_LEAD;
+    Camera_update(&camera);
 
     glm_mat4_copy(context->projectionMatrix, overlayMatrix);
-    glm_mat4_copy(camOrtho, context->projectionMatrix);
+    glm_mat4_copy(camera.projection, context->projectionMatrix);
 }
 
-void World_init() {
-    player.init(&playerObj);
-    player.reset();
-    pipeTickTimer = -1;
-
-    size_t vSize = VertexFormat_sizeOf(VERTEX_FORMAT_PC);
-    Vertex_PC verticies[] = {
-        (Vertex_PC) { {-PIPE_WIDTH / 2.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 1.0f, 1.0f } }, // left bottom
-        (Vertex_PC) { {-PIPE_WIDTH / 2.0f, PIPE_HEIGHT, 0.0f}, { 1.0f, 0.0f, 1.0f, 1.0f} }, // left top
-        (Vertex_PC) { {PIPE_WIDTH / 2.0f, PIPE_HEIGHT, 0.0f}, {1.0f, 0.0f, 1.0f, 1.0f }}, // right top
-        (Vertex_PC) { {PIPE_WIDTH / 2.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 1.0f, 1.0f} } // right bottom
+// Runs on the loader thread, everything that doesn't need a VAO
+void World_preload() {
+    score = 0;
+
+    Camera_init(&camera, DISPLAY_WIDTHF, DISPLAY_HEIGHTF);
+    CullBounds_init(&pipeBounds, MAX_PIPES);
+    CullBounds_init(&pickupBounds, MAX_PICKUPS);
+    CullGrid_init(&pipeGrid, GLM_VEC2_ZERO, CULL_CELL_SIZE, CULL_CELLS, 1);
+    CullGrid_init(&pickupGrid, GLM_VEC2_ZERO, CULL_CELL_SIZE, CULL_CELLS, 1);
+
+    // pipes and pickups are whole units, so they fit the 8 byte format
+    size_t vSize = VertexFormat_sizeOf(VERTEX_FORMAT_S16C8);
+    int16_t pipeHalfWidth = (int16_t) (PIPE_WIDTH / 2.0f);
+    int16_t pipeHeight = (int16_t) PIPE_HEIGHT;
+    Vertex_S16C8 verticies[] = {
+        (Vertex_S16C8) { { -pipeHalfWidth, 0 }, { 255, 0, 255, 255 } }, // left bottom
+        (Vertex_S16C8) { { -pipeHalfWidth, pipeHeight }, { 255, 0, 255, 255 } }, // left top
+        (Vertex_S16C8) { { pipeHalfWidth, pipeHeight }, { 255, 0, 255, 255 } }, // right top
+        (Vertex_S16C8) { { pipeHalfWidth, 0 }, { 255, 0, 255, 255 } } // right bottom
     };
 
-    pipeVB = malloc(sizeof(VertexBuffer_t));
+    pipeVB = Memory_alloc(MEMORY_TAG_SCENE, sizeof(VertexBuffer_t));
     VertexBuffer_init(pipeVB, vSize, 4, 4 * vSize, GL_STATIC_DRAW, verticies);
 
     uint32_t indicies[] = {
         0, 1, 2, 0, 2, 3
     };
-    pipeIB = malloc(sizeof(IndexBuffer_t));
-    IndexBuffer_init(pipeIB, 6, sizeof(indicies), indicies);
+    pipeIB = Memory_alloc(MEMORY_TAG_SCENE, sizeof(IndexBuffer_t));
+    IndexBuffer_initCompact(pipeIB, 6, indicies);
 
-    pipeRenderer = malloc(sizeof(Renderer_t));
-    Renderer_init(pipeRenderer, context, VERTEX_FORMAT_PC, pipeVB, pipeIB);
+    pipeRenderer = Memory_alloc(MEMORY_TAG_SCENE, sizeof(Renderer_t));
+    Renderer_init(pipeRenderer, context, VERTEX_FORMAT_S16C8, pipeVB, pipeIB);
+
+    pipeInstanceVb = Memory_alloc(MEMORY_TAG_SCENE, sizeof(VertexBuffer_t));
+    VertexBuffer_init(pipeInstanceVb, sizeof(Affine2D_t), 0, MAX_PIPES * sizeof(Affine2D_t), GL_STREAM_DRAW, NULL);
+    Renderer_setInstanceBuffer(pipeRenderer, pipeInstanceVb);
+
+    // decorations are plain triangle lists, so the indices just count up
+    uint32_t decorationVertexCount = LEVEL_POOL_SIZE * LEVEL_MAX_DECORATION_VERTICES;
+    for (uint32_t i = 0; i < decorationVertexCount; i++) {
+        decorationIndices[i] = i;
+    }
+    // world space x keeps growing, so these stay float
+    size_t decorationSize = VertexFormat_sizeOf(VERTEX_FORMAT_P2C8);
+    decorationVB = Memory_alloc(MEMORY_TAG_SCENE, sizeof(VertexBuffer_t));
+    VertexBuffer_init(decorationVB, decorationSize, 0, decorationVertexCount * decorationSize, GL_DYNAMIC_DRAW, NULL);
+    decorationIB = Memory_alloc(MEMORY_TAG_SCENE, sizeof(IndexBuffer_t));
+    IndexBuffer_initCompact(decorationIB, decorationVertexCount, decorationIndices);
+
+    decorationRenderer = Memory_alloc(MEMORY_TAG_SCENE, sizeof(Renderer_t));
+    Renderer_init(decorationRenderer, context, VERTEX_FORMAT_P2C8, decorationVB, decorationIB);
+
+    TransformSystem_init(&levelTransforms, LEVEL_POOL_SIZE * CHUNK_NODES);
+    for (uint32_t slot = 0; slot < LEVEL_POOL_SIZE; slot++) {
+        uint32_t chunkNode = TransformSystem_create(&levelTransforms, TRANSFORM_NO_PARENT);
+        for (uint32_t i = 0; i < CHUNK_PIPE_NODES; i++) {
+            TransformSystem_create(&levelTransforms, chunkNode);
+        }
+        for (uint32_t i = 0; i < LEVEL_MAX_PICKUPS; i++) {
+            TransformSystem_create(&levelTransforms, chunkNode);
+        }
+    }
+
+    SpatialHash_init(&pipeHash, 256.0f, MAX_PIPES);
+    CollisionPairArray_init(&pipeHits, 16);
+    SpatialHash_init(&pickupHash, 256.0f, MAX_PICKUPS);
+    CollisionHitArray_init(&pickupHits, 16);
+
+    // the buffers and transforms have to exist before the first chunks come in
+    LevelStreamer_init(&level, Rng_streamSeed(RNG_STREAM_LEVEL, 0), World_onChunkLoaded);
+
+    ParticleSystem_init(&particles, context, MAX_PARTICLES);
+
+    // trail out the back of the plane, nose points to +x
+    exhaustEmitter = ParticleSystem_addEmitter(&particles);
+    exhaustEmitter->rate = 600.0f;
+    exhaustEmitter->life = 0.6f;
+    exhaustEmitter->size = 8.0f;
+    glm_vec2_copy((vec2) { -150.0f, 0.0f }, exhaustEmitter->velocity);
+    glm_vec2_copy((vec2) { 30.0f, 30.0f }, exhaustEmitter->spread);
+    glm_vec4_copy((vec4) { 1.0f, 0.6f, 0.1f, 0.8f }, exhaustEmitter->color);
+
+    // debris when we crash, only fires through bursts
+    explosionEmitter = ParticleSystem_addEmitter(&particles);
+    explosionEmitter->life = 1.2f;
+    explosionEmitter->size = 6.0f;
+    glm_vec2_copy((vec2) { 400.0f, 400.0f }, explosionEmitter->spread);
+    glm_vec4_copy((vec4) { 1.0f, 0.2f, 0.1f, 1.0f }, explosionEmitter->color);
+}
+
+void World_activate() {
+    ParticleSystem_createVertexArray(&particles);
+
+    // the clear colour stands in until these are uploaded, they're only drawn once ready
+    SpriteBatch_init(&sprites, context);
+    skyTexture = TextureStream_load("assets/sky.dwtx");
+    hillsTexture = TextureStream_load("assets/hills.dwtx");
+
+    // tiny, a gutter of 2 covers the one mip level they get shrunk to
+    Atlas_init(&gemAtlas, 256, 2);
+    for (uint32_t i = 0; i < GEM_COUNT; i++) {
+        gemRegions[i] = Atlas_add(&gemAtlas, gemPaths[i]);
+    }
+    Atlas_build(&gemAtlas);
+
+    // the player's mesh is tiny, not worth splitting up
+    player.init(&playerObj);
+    player.reset();
 }
 
 void World_tick() {
+    // constant forward speed, the camera follows us through the level
+    playerObj.velocity[0] = PLAYER_SPEED;
     player.tick();
 
+    LevelStreamer_update(&level, camera.view.pos[0], camera.view.pos[0] + camera.view.size[0]);
 
-    if (pipeTickTimer > 100 || pipeTickTimer < 0) {
-        pipeTickTimer = 0;
-        genPipe();
-    }
-    pipeTickTimer++;
+    collectPickups();
 
+    if (checkPlayerCollision()) {
+        glm_vec2_copy(playerObj.pos, explosionEmitter->pos);
+        ParticleSystem_burst(&particles, explosionEmitter, 4000);
+        player.reset();
 
-    for (int i = 0; i < pipeCount; i++) {
-        Pipe_t pipe = pipes[i];
-        float newX = pipe.pos[0] - 10.0f;
-        printf("pipeX %f newX %f \n", pipe.pos[0], newX);
-        pipe.pos[0] = newX;
+        // back to the start of the same level
+        LevelStreamer_reset(&level);
+        score = 0;
+    }
+}
+
+// Fills the screen, still under the overlay projection from last frame
+static void renderBackdrop() {
+    if (TextureStream_isReady(skyTexture)) {
+        SpriteBatch_add(&sprites, GLM_VEC2_ZERO, (vec2) { DISPLAY_WIDTHF, DISPLAY_HEIGHTF }, 0.0f, (vec4) { 0.0f, 0.0f, 1.0f, 1.0f }, GLM_VEC4_ONE);
+        SpriteBatch_flush(&sprites, TextureStream_texture(skyTexture)->texId);
+    }
 
-        // printf("moved pipe %d\n", i);
+    if (TextureStream_isReady(hillsTexture)) {
+        const Texture_t *hills = TextureStream_texture(hillsTexture);
+        // the texture repeats, so the scroll just wraps around
+        float scroll = DW_lerp(playerObj.prevPos[0], playerObj.pos[0], context->partialTicks) * HILLS_PARALLAX;
+        vec4 uvRect = { fmodf(scroll / hills->width, 1.0f), 0.0f, DISPLAY_WIDTHF / hills->width, 1.0f };
+        SpriteBatch_add(&sprites, (vec2) { 0.0f, DISPLAY_HEIGHTF - hills->height }, (vec2) { DISPLAY_WIDTHF, hills->height }, 0.0f, uvRect, GLM_VEC4_ONE);
+        SpriteBatch_flush(&sprites, hills->texId);
     }
 }
 
 void World_render() {
     glClearColor(0.361f, 0.835f, 0.917f, 1.0f);
 
+    renderBackdrop();
+
     // setup our camera matricies for the world
     updateCamera();
+
+    // background first, one draw per chunk slot on screen
+    Renderer_bind(decorationRenderer);
+    for (uint32_t c = 0; c < level.activeCount; c++) {
+        LevelChunk_t *chunk = level.active[c];
+        Rect_t chunkRect = {
+            .pos = { chunk->x, camera.view.pos[1] },
+            .size = { LEVEL_CHUNK_WIDTH, camera.view.size[1] }
+        };
+        if (chunk->decorationVertexCount == 0 || !Camera_isVisible(&camera, &chunkRect)) continue;
+
+        Renderer_drawIndexed(decorationRenderer, chunk->slot * LEVEL_MAX_DECORATION_VERTICES, chunk->decorationVertexCount);
+    }
+
+    glm_vec2_copy((vec2) {
+        DW_lerp(playerObj.prevPos[0], playerObj.pos[0], context->partialTicks) - 20.0f,
+        DW_lerp(playerObj.prevPos[1], playerObj.pos[1], context->partialTicks)
+    }, exhaustEmitter->pos);
+    ParticleSystem_update(&particles, context->frameTime);
+    ParticleSystem_render(&particles);
+
     player.render();
 
-    Renderer_bind(pipeRenderer);
-    for (int i = 0; i < pipeCount; i++) {
-        Pipe_t pipe = pipes[i];
-        MatrixStack_pushMatrix(context->matrixStack);
-        // printf("pipe %d xy %f %f\n", i, pipe.pos[0], pipe.pos[1]);
-        MatrixStack_translate(context->matrixStack, (vec3) { pipe.pos[0], pipe.pos[1], 0.0f });
-        Renderer_draw(pipeRenderer);
-        MatrixStack_popMatrix(context->matrixStack);
+    CullBounds_clear(&pipeBounds);
+    CullBounds_clear(&pickupBounds);
+    for (uint32_t c = 0; c < level.activeCount; c++) {
+        LevelChunk_t *chunk = level.active[c];
+
+        for (uint32_t i = 0; i < chunk->obstacleCount; i++) {
+            vec2 pipes[2];
+            Obstacle_getPipes(&chunk->obstacles[i], pipes[0], pipes[1]);
+
+            for (uint32_t j = 0; j < 2; j++) {
+                Rect_t bounds = Pipe_getRect(chunk, pipes[j]);
+                pipeNodes[CullBounds_add(&pipeBounds, &bounds)] = Chunk_pipeNode(chunk, i, j);
+            }
+        }
+
+        for (uint32_t i = 0; i < chunk->pickupCount; i++) {
+            if (chunk->pickups[i].collected) continue;
+
+            Rect_t bounds = Pickup_getRect(chunk, &chunk->pickups[i]);
+            pickupNodes[CullBounds_add(&pickupBounds, &bounds)] = Chunk_pickupNode(chunk, i);
+        }
+    }
+    TransformSystem_update(&levelTransforms);
+
+    // the level only grows to the right, so the grids start at the oldest chunk still loaded
+    if (level.activeCount > 0) {
+        pipeGrid.origin[0] = level.active[0]->x;
+        pickupGrid.origin[0] = level.active[0]->x;
+    }
+    CullGrid_build(&pipeGrid, &pipeBounds);
+    CullGrid_build(&pickupGrid, &pickupBounds);
+
+    // only what's on screen gets uploaded and drawn, the lists only last the frame
+    uint32_t *visiblePipes = FrameArena_alloc(pipeBounds.count * sizeof(uint32_t));
+    uint32_t *visiblePickups = FrameArena_alloc(pickupBounds.count * sizeof(uint32_t));
+    uint32_t maxVisible = pipeBounds.count > pickupBounds.count ? pipeBounds.count : pickupBounds.count;
+    Affine2D_t *visibleTransforms = FrameArena_alloc(maxVisible * sizeof(Affine2D_t));
+
+    uint32_t visibleCount = CullGrid_query(&pipeGrid, &camera.view, visiblePipes, &pipeCullStats);
+    for (uint32_t i = 0; i < visibleCount; i++) {
+        visibleTransforms[i] = *TransformSystem_getPacked(&levelTransforms, pipeNodes[visiblePipes[i]]);
+    }
+
+    if (visibleCount > 0) {
+        VertexBuffer_update(pipeInstanceVb, visibleCount, visibleCount * sizeof(Affine2D_t), visibleTransforms);
+        Renderer_bind(pipeRenderer);
+        Renderer_drawInstanced(pipeRenderer, visibleCount);
+    }
+
+    // the gems all share a page, so every pickup goes out in one flush
+    uint32_t visiblePickupCount = CullGrid_query(&pickupGrid, &camera.view, visiblePickups, NULL);
+    const Texture_t *gemPage = Atlas_page(&gemAtlas, gemRegions[0]);
+    for (uint32_t i = 0; gemPage != NULL && i < visiblePickupCount; i++) {
+        uint32_t node = pickupNodes[visiblePickups[i]];
+        const AtlasRegion_t *gem = Atlas_region(&gemAtlas, gemRegions[node % GEM_COUNT]);
+        const Affine2D_t *transform = TransformSystem_getPacked(&levelTransforms, node);
+
+        vec2 pos = { transform->translation[0] - PICKUP_SPRITE_SIZE / 2.0f, transform->translation[1] - PICKUP_SPRITE_SIZE / 2.0f };
+        // y is up in the world, so the region is read top to bottom
+        vec4 uvRect = { gem->uv[0], gem->uv[3], gem->uv[2] - gem->uv[0], gem->uv[1] - gem->uv[3] };
+        SpriteBatch_add(&sprites, pos, (vec2) { PICKUP_SPRITE_SIZE, PICKUP_SPRITE_SIZE }, 0.0f, uvRect, GLM_VEC4_ONE);
     }
+    if (gemPage != NULL) SpriteBatch_flush(&sprites, gemPage->texId);
 
-    // restore our orthogonal matrix for 2d overlay rendering
+    // restore our orthogonal matrix for 2d overlay rendering, text stays at native resolution
     glm_mat4_copy(overlayMatrix, context->projectionMatrix);
+    PostFx_overlay();
 
     FontRenderer_setColor(fontRenderer, GLM_VEC4_ONE);
-    FontRenderer_drawString(fontRenderer, "Score: 0", 2.0f, 2.0f);
+    FontRenderer_drawString(fontRenderer, FrameArena_printf("Score: %u", score), 2.0f, 2.0f);
+    FontRenderer_drawString(fontRenderer, FrameArena_printf("Visible: %u Culled: %u", pipeCullStats.visible, pipeCullStats.culled),
+        2.0f, 2.0f + fontRenderer->charHeight);
 }
 
 void World_exit() {
+    player.kill();
+
+    TextureStream_release(skyTexture);
+    TextureStream_release(hillsTexture);
+    SpriteBatch_free(&sprites);
+    Atlas_free(&gemAtlas);
+
+    // renderers don't own their buffers, those go separately
+    Renderer_free(pipeRenderer);
     VertexBuffer_free(pipeVB);
     IndexBuffer_free(pipeIB);
-    Renderer_free(pipeRenderer);
+    VertexBuffer_free(pipeInstanceVb);
+
+    Renderer_free(decorationRenderer);
+    VertexBuffer_free(decorationVB);
+    IndexBuffer_free(decorationIB);
+
+    LevelStreamer_free(&level);
+    TransformSystem_free(&levelTransforms);
+    CullBounds_free(&pipeBounds);
+    CullBounds_free(&pickupBounds);
+    CullGrid_free(&pipeGrid);
+    CullGrid_free(&pickupGrid);
+
+    ParticleSystem_free(&particles);
+    SpatialHash_free(&pipeHash);
+    CollisionPairArray_free(&pipeHits);
+    SpatialHash_free(&pickupHash);
+    CollisionHitArray_free(&pickupHits);
 }
 
 void World_onKey(int key, int scancode, int action, int mods) {
@@ -1,7 +1,9 @@
 #ifndef WORLD_H
 #define WORLD_H
 
-void World_init();
+void World_preload();
+
+void World_activate();
 
 void World_tick();
 
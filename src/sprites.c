@@ -0,0 +1,121 @@
+#include "sprites.h"
+#include "memory.h"
+
+#include <string.h>
+
+// SSBO binding point, sprite.vs.glsl reads from here
+#define BINDING_SPRITES 0
+
+static const char *fragmentPaths[SPRITE_PROGRAM_COUNT] = {
+    "assets/sprite.fs.glsl",
+    "assets/sprite_array.fs.glsl",
+    "assets/sprite_bindless.fs.glsl"
+};
+
+static SpriteProgram_t* SpriteBatch_program(SpriteBatch_t *batch, SpriteProgram_e type) {
+    SpriteProgram_t *program = &batch->programs[type];
+    if (program->shader != 0) return program;
+
+    program->handle = Resources_loadProgram("assets/sprite.vs.glsl", fragmentPaths[type]);
+    program->shader = Resources_programName(program->handle);
+    program->projectionLoc = glGetUniformLocation(program->shader, "projection");
+    program->modelLoc = glGetUniformLocation(program->shader, "model");
+    program->tintLoc = glGetUniformLocation(program->shader, "tint");
+    program->texturedLoc = glGetUniformLocation(program->shader, "textured");
+    program->textureLoc = glGetUniformLocation(program->shader, "textureIn");
+    return program;
+}
+
+void SpriteBatch_init(SpriteBatch_t *batch, Context_t *context) {
+    memset(batch->programs, 0, sizeof(batch->programs));
+    batch->context = context;
+    batch->spriteCapacity = 256;
+    batch->spriteCount = 0;
+    batch->sprites = Memory_alloc(MEMORY_TAG_RENDERER, batch->spriteCapacity * sizeof(Sprite_t));
+    glm_vec4_one(batch->tint);
+
+    // the plain one is what everything uses, so it's ready before the first frame
+    SpriteBatch_program(batch, SPRITE_PROGRAM_TEXTURE);
+
+    batch->vertexArray = Resources_createVertexArray();
+    batch->vao = Resources_vertexArrayName(batch->vertexArray);
+
+    batch->buffer = Resources_acquireBuffer(batch->spriteCapacity * sizeof(Sprite_t), GL_STREAM_DRAW);
+    batch->ssbo = Resources_bufferName(batch->buffer);
+}
+
+void SpriteBatch_free(SpriteBatch_t *batch) {
+    Resources_releaseBuffer(batch->buffer);
+    Resources_releaseVertexArray(batch->vertexArray);
+    for (int i = 0; i < SPRITE_PROGRAM_COUNT; i++) {
+        if (batch->programs[i].shader != 0) Resources_releaseProgram(batch->programs[i].handle);
+    }
+    Memory_free(batch->sprites);
+    batch->sprites = NULL;
+}
+
+void SpriteBatch_setTint(SpriteBatch_t *batch, vec4 tint) {
+    glm_vec4_copy(tint, batch->tint);
+}
+
+Sprite_t* SpriteBatch_reserve(SpriteBatch_t *batch, size_t count) {
+    if (batch->spriteCount + count > batch->spriteCapacity) {
+        while (batch->spriteCount + count > batch->spriteCapacity) batch->spriteCapacity *= 2;
+        batch->sprites = Memory_realloc(MEMORY_TAG_RENDERER, batch->sprites, batch->spriteCapacity * sizeof(Sprite_t));
+    }
+
+    Sprite_t *sprites = &batch->sprites[batch->spriteCount];
+    batch->spriteCount += count;
+    return sprites;
+}
+
+Sprite_t* SpriteBatch_add(SpriteBatch_t *batch, vec2 pos, vec2 size, float rotation, vec4 uvRect, vec4 color) {
+    Sprite_t *sprite = SpriteBatch_reserve(batch, 1);
+    glm_vec2_copy(pos, sprite->pos);
+    glm_vec2_copy(size, sprite->size);
+    glm_vec4_copy(uvRect, sprite->uvRect);
+    sprite->rotation = rotation;
+    Vertex_packColor(color, (uint8_t*) &sprite->color);
+    sprite->layer = 0;
+    sprite->pad = 0;
+    return sprite;
+}
+
+// Uploads the batch and draws it with program, whatever it samples has to be bound already
+static void SpriteBatch_draw(SpriteBatch_t *batch, SpriteProgram_t *program, bool textured) {
+    // orphan and refill, the previous draw can keep reading the old storage
+    size_t size = batch->spriteCount * sizeof(Sprite_t);
+    size_t bufferSize = Resources_bufferSize(batch->buffer);
+    Resources_resizeBuffer(batch->buffer, size > bufferSize ? size : bufferSize);
+    glNamedBufferSubData(batch->ssbo, 0, size, batch->sprites);
+
+    Context_t *context = batch->context;
+    glUseProgram(program->shader);
+    glUniformMatrix4fv(program->projectionLoc, 1, GL_FALSE, (float*) &context->projectionMatrix);
+    glUniformMatrix4fv(program->modelLoc, 1, GL_FALSE, (float*) MatrixStack_peek(context->matrixStack));
+    glUniform4fv(program->tintLoc, 1, batch->tint);
+    glUniform1i(program->texturedLoc, textured);
+    glUniform1i(program->textureLoc, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING_SPRITES, batch->ssbo);
+    glBindVertexArray(batch->vao);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei) (batch->spriteCount * 6));
+    glBindVertexArray(0);
+
+    batch->spriteCount = 0;
+}
+
+void SpriteBatch_flush(SpriteBatch_t *batch, GLuint texture) {
+    if (batch->spriteCount == 0) return;
+
+    if (texture != 0) glBindTextureUnit(0, texture);
+    SpriteBatch_draw(batch, SpriteBatch_program(batch, SPRITE_PROGRAM_TEXTURE), texture != 0);
+}
+
+void SpriteBatch_flushPool(SpriteBatch_t *batch, TexturePool_t *pool) {
+    if (batch->spriteCount == 0) return;
+
+    TexturePool_bind(pool, 0);
+    SpriteProgram_e type = pool->bindless ? SPRITE_PROGRAM_BINDLESS : SPRITE_PROGRAM_ARRAY;
+    SpriteBatch_draw(batch, SpriteBatch_program(batch, type), true);
+}
@@ -0,0 +1,91 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "renderer.h"
+#include "texpool.h"
+
+// GPU side sprite, matches the std430 layout in sprite.vs.glsl
+typedef struct {
+    // where the sprite's (0, 0) corner goes, and what it rotates around
+    vec2 pos;
+    vec2 size;
+    // u, v, width, height. v + height lands on pos, the same way up glyphs and flipped textures are
+    vec4 uvRect;
+    // radians
+    float rotation;
+    // rgba8, multiplied with the texel
+    uint32_t color;
+    // texture pool layer, for batches flushed with SpriteBatch_flushPool
+    uint32_t layer;
+    uint32_t pad;
+} Sprite_t;
+
+// fragment shader variants, loaded the first time a flush needs them
+typedef enum {
+    SPRITE_PROGRAM_TEXTURE,
+    SPRITE_PROGRAM_ARRAY,
+    SPRITE_PROGRAM_BINDLESS,
+    SPRITE_PROGRAM_COUNT
+} SpriteProgram_e;
+
+typedef struct {
+    ProgramHandle_t handle;
+    GLuint shader;
+
+    GLint projectionLoc;
+    GLint modelLoc;
+    GLint tintLoc;
+    GLint texturedLoc;
+    GLint textureLoc;
+} SpriteProgram_t;
+
+/**
+ * Draws quads without any vertex data. Each sprite is one record in a shader
+ * storage buffer, and the vertex shader makes the 6 corners of its two triangles
+ * out of gl_VertexID, so there are no attributes, no index buffer and nothing to
+ * fill per corner on the CPU. A flush is one glDrawArrays for the whole batch.
+ * Flushed against a TexturePool_t, every sprite samples its own layer, so sprites
+ * with different textures still go out in that one draw.
+ */
+typedef struct {
+    Context_t *context;
+
+    SpriteProgram_t programs[SPRITE_PROGRAM_COUNT];
+    // empty, core profile just needs one bound to draw
+    VertexArrayHandle_t vertexArray;
+    GLuint vao;
+    // orphaned and refilled every flush
+    BufferHandle_t buffer;
+    GLuint ssbo;
+
+    Sprite_t *sprites;
+    size_t spriteCount;
+    size_t spriteCapacity;
+
+    // multiplied into every sprite's colour, white unless set
+    vec4 tint;
+} SpriteBatch_t;
+
+void SpriteBatch_init(SpriteBatch_t *batch, Context_t *context);
+
+void SpriteBatch_free(SpriteBatch_t *batch);
+
+void SpriteBatch_setTint(SpriteBatch_t *batch, vec4 tint);
+
+// count sprites at the end of the batch for the caller to fill in, valid until the next add or flush
+Sprite_t* SpriteBatch_reserve(SpriteBatch_t *batch, size_t count);
+
+// Returns the sprite so its layer can be set, valid as long as one from SpriteBatch_reserve
+Sprite_t* SpriteBatch_add(SpriteBatch_t *batch, vec2 pos, vec2 size, float rotation, vec4 uvRect, vec4 color);
+
+// Draws everything added since the last flush with the current model matrix, sampling
+// texture on unit 0. 0 draws the sprites in their plain colour
+void SpriteBatch_flush(SpriteBatch_t *batch, GLuint texture);
+
+// Same, with each sprite sampling pool's layer sprite->layer on unit 0
+void SpriteBatch_flushPool(SpriteBatch_t *batch, TexturePool_t *pool);
+
+#endif
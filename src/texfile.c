@@ -0,0 +1,75 @@
+#include "texfile.h"
+
+#include <string.h>
+
+bool TextureFormat_isCompressed(TextureFormat_e format) {
+    return format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3;
+}
+
+size_t TextureFormat_levelSize(TextureFormat_e format, uint32_t width, uint32_t height) {
+    // partial blocks at the edges still take a whole block
+    size_t blocks = (size_t) ((width + 3) / 4) * ((height + 3) / 4);
+
+    switch (format) {
+    case TEXTURE_FORMAT_RGBA8: return (size_t) width * height * 4;
+    case TEXTURE_FORMAT_BC1: return blocks * 8;
+    case TEXTURE_FORMAT_BC3: return blocks * 16;
+    default: return 0;
+    }
+}
+
+const TextureFileHeader_t* TextureFile_validate(const uint8_t *data, size_t size) {
+    if (size < sizeof(TextureFileHeader_t)) return NULL;
+
+    const TextureFileHeader_t *header = (const TextureFileHeader_t*) data;
+    if (memcmp(header->magic, TEXTURE_FILE_MAGIC, 4) != 0 || header->version != TEXTURE_FILE_VERSION) return NULL;
+
+    if (header->format >= TEXTURE_FORMAT_TOTAL || header->width == 0 || header->height == 0 ||
+        header->levels == 0 || header->levels > TEXTURE_FILE_MAX_LEVELS) {
+        return NULL;
+    }
+
+    if (sizeof(TextureFileHeader_t) + header->levels * sizeof(TextureFileLevel_t) > size) return NULL;
+
+    const TextureFileLevel_t *levels = TextureFile_levels(header);
+    for (uint32_t i = 0; i < header->levels; i++) {
+        const TextureFileLevel_t *level = &levels[i];
+        uint32_t width = header->width >> i ? header->width >> i : 1;
+        uint32_t height = header->height >> i ? header->height >> i : 1;
+
+        if (level->width != width || level->height != height) return NULL;
+        if (level->size != TextureFormat_levelSize(header->format, width, height)) return NULL;
+        if (level->offset > size || level->size > size - level->offset) return NULL;
+    }
+
+    return header;
+}
+
+const TextureFileLevel_t* TextureFile_levels(const TextureFileHeader_t *header) {
+    return (const TextureFileLevel_t*) (header + 1);
+}
+
+void TextureFile_downsample(const uint8_t *src, uint32_t width, uint32_t height, uint32_t channels, uint8_t *dst) {
+    uint32_t dstWidth = width > 1 ? width / 2 : 1;
+    uint32_t dstHeight = height > 1 ? height / 2 : 1;
+
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        uint32_t y0 = y * 2 < height ? y * 2 : height - 1;
+        uint32_t y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            uint32_t x0 = x * 2 < width ? x * 2 : width - 1;
+            uint32_t x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+
+            const uint8_t *p00 = src + ((size_t) y0 * width + x0) * channels;
+            const uint8_t *p01 = src + ((size_t) y0 * width + x1) * channels;
+            const uint8_t *p10 = src + ((size_t) y1 * width + x0) * channels;
+            const uint8_t *p11 = src + ((size_t) y1 * width + x1) * channels;
+            uint8_t *out = dst + ((size_t) y * dstWidth + x) * channels;
+
+            for (uint32_t c = 0; c < channels; c++) {
+                out[c] = (uint8_t) ((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+            }
+        }
+    }
+}
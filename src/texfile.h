@@ -0,0 +1,65 @@
+#ifndef TEXFILE_H
+#define TEXFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * DWTX, textures the way the GPU wants them. Made offline by tools/texconv:
+ *
+ *   TextureFileHeader_t
+ *   TextureFileLevel_t[levels]    largest first
+ *   level data                    each level starts on a 16 byte boundary
+ *
+ * Levels are already flipped for GL (first row is the bottom) and already
+ * mipmapped, so loading one is a glTexStorage2D and a copy per level.
+ */
+#define TEXTURE_FILE_MAGIC "DWTX"
+#define TEXTURE_FILE_VERSION 1
+#define TEXTURE_FILE_ALIGNMENT 16
+// enough for a 64k texture
+#define TEXTURE_FILE_MAX_LEVELS 17
+
+typedef enum {
+    TEXTURE_FORMAT_RGBA8,
+    // 4x4 blocks of 8 bytes, rgb with no alpha
+    TEXTURE_FORMAT_BC1,
+    // 4x4 blocks of 16 bytes, bc1 colour plus interpolated alpha
+    TEXTURE_FORMAT_BC3,
+
+    TEXTURE_FORMAT_TOTAL
+} TextureFormat_e;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint32_t pad[2];
+} TextureFileHeader_t;
+
+typedef struct {
+    // from the start of the file
+    uint32_t offset;
+    uint32_t size;
+    uint32_t width;
+    uint32_t height;
+} TextureFileLevel_t;
+
+bool TextureFormat_isCompressed(TextureFormat_e format);
+
+// Bytes one level of the given size takes up
+size_t TextureFormat_levelSize(TextureFormat_e format, uint32_t width, uint32_t height);
+
+// Checks the header and every level against size, returns the header or NULL if anything's off
+const TextureFileHeader_t* TextureFile_validate(const uint8_t *data, size_t size);
+
+const TextureFileLevel_t* TextureFile_levels(const TextureFileHeader_t *header);
+
+// Next mip level with a 2x2 box filter, dst is half the size (at least 1), odd edges reuse their last row/column
+void TextureFile_downsample(const uint8_t *src, uint32_t width, uint32_t height, uint32_t channels, uint8_t *dst);
+
+#endif
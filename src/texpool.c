@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "texpool.h"
+#include "memory.h"
+
+// glad was generated without ARB_bindless_texture, so these get loaded by hand
+typedef GLuint64 (APIENTRYP GetTextureHandleFunc_t)(GLuint texture);
+typedef void (APIENTRYP MakeTextureHandleResidentFunc_t)(GLuint64 handle);
+typedef void (APIENTRYP MakeTextureHandleNonResidentFunc_t)(GLuint64 handle);
+
+static GetTextureHandleFunc_t getTextureHandle_m;
+static MakeTextureHandleResidentFunc_t makeTextureHandleResident_m;
+static MakeTextureHandleNonResidentFunc_t makeTextureHandleNonResident_m;
+static bool bindless_m = false;
+
+bool TexturePool_initBindless(GLADloadproc load) {
+    bindless_m = false;
+
+    const char *bindlessEnv = getenv("DW_BINDLESS");
+    if (bindlessEnv != NULL && strcmp(bindlessEnv, "0") == 0) return false;
+
+    bool supported = false;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char *ext = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if (strcmp(ext, "GL_ARB_bindless_texture") == 0) supported = true;
+    }
+    if (!supported) return false;
+
+    getTextureHandle_m = (GetTextureHandleFunc_t) load("glGetTextureHandleARB");
+    makeTextureHandleResident_m = (MakeTextureHandleResidentFunc_t) load("glMakeTextureHandleResidentARB");
+    makeTextureHandleNonResident_m = (MakeTextureHandleNonResidentFunc_t) load("glMakeTextureHandleNonResidentARB");
+    bindless_m = getTextureHandle_m != NULL && makeTextureHandleResident_m != NULL && makeTextureHandleNonResident_m != NULL;
+    return bindless_m;
+}
+
+bool TexturePool_hasBindless() {
+    return bindless_m;
+}
+
+// Clamped, so linear filtering never pulls in the opposite edge
+static void setParams(GLuint texture, uint32_t levels) {
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// levels that fit a width x height texture
+static uint32_t clampLevels(uint32_t levels, uint32_t width, uint32_t height) {
+    uint32_t size = width > height ? width : height;
+    uint32_t maxLevels = 1;
+    while (size > 1) {
+        size >>= 1;
+        maxLevels++;
+    }
+    return levels < maxLevels ? levels : maxLevels;
+}
+
+void TexturePool_init(TexturePool_t *pool, uint32_t width, uint32_t height, GLenum internalFormat, uint32_t levels, uint32_t capacity) {
+    memset(pool, 0, sizeof(TexturePool_t));
+    pool->bindless = bindless_m;
+    pool->width = width;
+    pool->height = height;
+    pool->internalFormat = internalFormat;
+    pool->levels = clampLevels(levels > 0 ? levels : 1, width, height);
+    pool->layerCapacity = capacity > 0 ? capacity : 1;
+    pool->freeLayers = Memory_alloc(MEMORY_TAG_RENDERER, pool->layerCapacity * sizeof(uint32_t));
+
+    if (pool->bindless) {
+        pool->textures = Memory_calloc(MEMORY_TAG_RENDERER, pool->layerCapacity, sizeof(GLuint));
+        pool->textureSizes = Memory_calloc(MEMORY_TAG_RENDERER, pool->layerCapacity, sizeof(uint32_t[2]));
+        pool->handles = Memory_calloc(MEMORY_TAG_RENDERER, pool->layerCapacity, sizeof(uint64_t));
+        pool->handleBuffer = Resources_acquireBuffer(pool->layerCapacity * sizeof(uint64_t), GL_DYNAMIC_DRAW);
+        pool->handlesDirty = true;
+    } else {
+        pool->array = Resources_acquireTextureArray(width, height, pool->layerCapacity, internalFormat, pool->levels);
+        setParams(Resources_textureName(pool->array), pool->levels);
+    }
+}
+
+void TexturePool_free(TexturePool_t *pool) {
+    if (pool->bindless) {
+        for (uint32_t i = 0; i < pool->layerCount; i++) {
+            if (pool->textures[i] == 0) continue;
+            makeTextureHandleNonResident_m(pool->handles[i]);
+            glDeleteTextures(1, &pool->textures[i]);
+        }
+        for (uint32_t i = 0; i < pool->retiredCount; i++) {
+            makeTextureHandleNonResident_m(pool->retiredHandles[i]);
+            glDeleteTextures(1, &pool->retired[i]);
+        }
+        Resources_releaseBuffer(pool->handleBuffer);
+    } else {
+        Resources_releaseTexture(pool->array);
+    }
+
+    Memory_free(pool->freeLayers);
+    Memory_free(pool->textures);
+    Memory_free(pool->textureSizes);
+    Memory_free(pool->handles);
+    Memory_free(pool->retired);
+    Memory_free(pool->retiredHandles);
+    Memory_free(pool->retiredFrames);
+    memset(pool, 0, sizeof(TexturePool_t));
+}
+
+static bool TexturePool_grow(TexturePool_t *pool) {
+    uint32_t capacity = pool->layerCapacity * 2;
+
+    if (pool->bindless) {
+        pool->textures = Memory_realloc(MEMORY_TAG_RENDERER, pool->textures, capacity * sizeof(GLuint));
+        pool->textureSizes = Memory_realloc(MEMORY_TAG_RENDERER, pool->textureSizes, capacity * sizeof(uint32_t[2]));
+        pool->handles = Memory_realloc(MEMORY_TAG_RENDERER, pool->handles, capacity * sizeof(uint64_t));
+        uint32_t added = capacity - pool->layerCapacity;
+        memset(pool->textures + pool->layerCapacity, 0, added * sizeof(GLuint));
+        memset(pool->textureSizes + pool->layerCapacity, 0, added * sizeof(uint32_t[2]));
+        memset(pool->handles + pool->layerCapacity, 0, added * sizeof(uint64_t));
+
+        // orphans the old handles, the next bind uploads all of them
+        Resources_resizeBuffer(pool->handleBuffer, capacity * sizeof(uint64_t));
+        pool->handlesDirty = true;
+    } else {
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        if (capacity > (uint32_t) maxLayers) capacity = maxLayers;
+        if (capacity <= pool->layerCapacity) {
+            fprintf(stderr, "Error: Texture pool is full, the driver allows %d array layers.\n", maxLayers);
+            return false;
+        }
+
+        // a bigger array with the layers copied over, the old one goes once the GPU is done with it
+        TextureHandle_t array = Resources_acquireTextureArray(pool->width, pool->height, capacity, pool->internalFormat, pool->levels);
+        GLuint oldName = Resources_textureName(pool->array);
+        GLuint newName = Resources_textureName(array);
+        for (uint32_t level = 0; level < pool->levels; level++) {
+            uint32_t width = pool->width >> level > 0 ? pool->width >> level : 1;
+            uint32_t height = pool->height >> level > 0 ? pool->height >> level : 1;
+            glCopyImageSubData(oldName, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                newName, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, pool->layerCount);
+        }
+        setParams(newName, pool->levels);
+
+        Resources_releaseTexture(pool->array);
+        pool->array = array;
+    }
+
+    pool->freeLayers = Memory_realloc(MEMORY_TAG_RENDERER, pool->freeLayers, capacity * sizeof(uint32_t));
+    pool->layerCapacity = capacity;
+    return true;
+}
+
+// Deletes the retired textures whose frame the GPU has finished, keeping the rest in order
+static void TexturePool_sweepRetired(TexturePool_t *pool) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < pool->retiredCount; i++) {
+        if (Resources_frameDone(pool->retiredFrames[i])) {
+            makeTextureHandleNonResident_m(pool->retiredHandles[i]);
+            glDeleteTextures(1, &pool->retired[i]);
+            continue;
+        }
+
+        pool->retired[kept] = pool->retired[i];
+        pool->retiredHandles[kept] = pool->retiredHandles[i];
+        pool->retiredFrames[kept] = pool->retiredFrames[i];
+        kept++;
+    }
+    pool->retiredCount = kept;
+}
+
+// Resident handles fix the sampler state, so these textures stay out of the resource pools
+static void TexturePool_createTexture(TexturePool_t *pool, uint32_t layer, uint32_t width, uint32_t height) {
+    GLuint texture = pool->textures[layer];
+    if (texture != 0) {
+        if (pool->textureSizes[layer][0] == width && pool->textureSizes[layer][1] == height) return;
+
+        // a draw in flight might still use the old one
+        pool->retired = Memory_realloc(MEMORY_TAG_RENDERER, pool->retired, (pool->retiredCount + 1) * sizeof(GLuint));
+        pool->retiredHandles = Memory_realloc(MEMORY_TAG_RENDERER, pool->retiredHandles, (pool->retiredCount + 1) * sizeof(uint64_t));
+        pool->retiredFrames = Memory_realloc(MEMORY_TAG_RENDERER, pool->retiredFrames, (pool->retiredCount + 1) * sizeof(uint64_t));
+        pool->retired[pool->retiredCount] = texture;
+        pool->retiredHandles[pool->retiredCount] = pool->handles[layer];
+        pool->retiredFrames[pool->retiredCount] = Resources_currentFrame();
+        pool->retiredCount++;
+    }
+
+    uint32_t levels = clampLevels(pool->levels, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, levels, pool->internalFormat, width, height);
+    setParams(texture, levels);
+
+    uint64_t handle = getTextureHandle_m(texture);
+    makeTextureHandleResident_m(handle);
+
+    pool->textures[layer] = texture;
+    pool->textureSizes[layer][0] = width;
+    pool->textureSizes[layer][1] = height;
+    pool->handles[layer] = handle;
+    pool->handlesDirty = true;
+}
+
+uint32_t TexturePool_add(TexturePool_t *pool, uint32_t width, uint32_t height, GLenum format, GLenum type, const void *pixels) {
+    if (!pool->bindless && (width != pool->width || height != pool->height)) {
+        fprintf(stderr, "Error: %ux%u texture doesn't fit a %ux%u texture array.\n", width, height, pool->width, pool->height);
+        return TEXTURE_POOL_NONE;
+    }
+
+    uint32_t layer;
+    if (pool->freeCount > 0) {
+        layer = pool->freeLayers[--pool->freeCount];
+    } else {
+        if (pool->layerCount == pool->layerCapacity && !TexturePool_grow(pool)) return TEXTURE_POOL_NONE;
+        layer = pool->layerCount++;
+    }
+
+    GLuint texture;
+    if (pool->bindless) {
+        TexturePool_createTexture(pool, layer, width, height);
+        texture = pool->textures[layer];
+        glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, pixels);
+    } else {
+        texture = Resources_textureName(pool->array);
+        glTextureSubImage3D(texture, 0, 0, 0, layer, width, height, 1, format, type, pixels);
+    }
+    if (pool->levels > 1) glGenerateTextureMipmap(texture);
+
+    return layer;
+}
+
+void TexturePool_remove(TexturePool_t *pool, uint32_t layer) {
+    if (layer >= pool->layerCount) return;
+
+    // a second remove would hand the same layer out to two adds
+    for (uint32_t i = 0; i < pool->freeCount; i++) {
+        if (pool->freeLayers[i] == layer) {
+            fprintf(stderr, "Error: Texture pool layer %u was already removed.\n", layer);
+            return;
+        }
+    }
+    pool->freeLayers[pool->freeCount++] = layer;
+}
+
+void TexturePool_bind(TexturePool_t *pool, GLuint unit) {
+    if (!pool->bindless) {
+        glBindTextureUnit(unit, Resources_textureName(pool->array));
+        return;
+    }
+
+    if (pool->retiredCount > 0) TexturePool_sweepRetired(pool);
+
+    GLuint buffer = Resources_bufferName(pool->handleBuffer);
+    if (pool->handlesDirty) {
+        glNamedBufferSubData(buffer, 0, pool->layerCount * sizeof(uint64_t), pool->handles);
+        pool->handlesDirty = false;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TEXTURE_POOL_BINDING, buffer);
+}
@@ -0,0 +1,78 @@
+#ifndef TEXPOOL_H
+#define TEXPOOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "resources.h"
+
+// returned by TexturePool_add when the texture couldn't go in
+#define TEXTURE_POOL_NONE UINT32_MAX
+
+// SSBO binding point the bindless handles go to, sprite_bindless.fs.glsl reads from here
+#define TEXTURE_POOL_BINDING 1
+
+/**
+ * A set of textures that a single draw can pick from per instance, by layer index.
+ *
+ * Where the driver has ARB_bindless_texture every layer is its own texture, made
+ * resident, with the 64 bit handles in a storage buffer, so layers can be any size.
+ * Everywhere else the layers are the slices of one GL_TEXTURE_2D_ARRAY and have to
+ * match the size the pool was made with. The layer indices work the same either way.
+ *
+ * A removed layer's slot is reused by the next add, and the texture behind it is
+ * only overwritten or retired then, so in flight draws never lose it. Main thread only.
+ */
+typedef struct {
+    bool bindless;
+
+    uint32_t width;
+    uint32_t height;
+    GLenum internalFormat;
+    uint32_t levels;
+
+    // slots handed out so far, and how many there's room for before growing
+    uint32_t layerCount;
+    uint32_t layerCapacity;
+    uint32_t *freeLayers;
+    uint32_t freeCount;
+
+    // array mode
+    TextureHandle_t array;
+
+    // bindless mode, one texture and handle per slot
+    GLuint *textures;
+    uint32_t (*textureSizes)[2];
+    uint64_t *handles;
+    BufferHandle_t handleBuffer;
+    bool handlesDirty;
+    // replaced by a different sized texture, kept resident until the frame they were
+    // retired in is done on the GPU
+    GLuint *retired;
+    uint64_t *retiredHandles;
+    uint64_t *retiredFrames;
+    uint32_t retiredCount;
+} TexturePool_t;
+
+// Looks up ARB_bindless_texture once the context is current, the loader is what glad was given.
+// DW_BINDLESS=0 sticks to texture arrays anyway
+bool TexturePool_initBindless(GLADloadproc load);
+
+bool TexturePool_hasBindless();
+
+// width and height are what every layer is in array mode, capacity is only where it starts
+void TexturePool_init(TexturePool_t *pool, uint32_t width, uint32_t height, GLenum internalFormat, uint32_t levels, uint32_t capacity);
+
+void TexturePool_free(TexturePool_t *pool);
+
+// Uploads pixels (format/type as for glTextureSubImage) into a free layer and returns its index
+uint32_t TexturePool_add(TexturePool_t *pool, uint32_t width, uint32_t height, GLenum format, GLenum type, const void *pixels);
+
+// Frees the layer for the next add, removing one that's already free is an error
+void TexturePool_remove(TexturePool_t *pool, uint32_t layer);
+
+// Array mode binds the array to unit, bindless puts the handles on TEXTURE_POOL_BINDING and
+// deletes retired textures the GPU is done with
+void TexturePool_bind(TexturePool_t *pool, GLuint unit);
+
+#endif
@@ -0,0 +1,482 @@
+#include "texstream.h"
+
+#include <string.h>
+
+#include "jobs.h"
+#include "archive.h"
+#include "texfile.h"
+#include "memory.h"
+
+// uploads issued from one PBO in a frame, the rest waits for the next frame
+#define STREAM_MAX_BANDS 64
+// PBO offsets of each band, matches the DWTX level alignment
+#define STREAM_ALIGNMENT 16
+
+typedef enum {
+    STREAM_DECODING,
+    STREAM_QUEUED,
+    STREAM_UPLOADING,
+    // everything has been submitted, waiting on the GPU
+    STREAM_FENCED,
+    STREAM_READY,
+    STREAM_FAILED
+} StreamState_e;
+
+// Uploads happen a unit at a time, a row of texels or a row of 4x4 blocks when compressed
+typedef struct {
+    const uint8_t *data;
+    uint32_t width;
+    uint32_t height;
+    size_t rowBytes;
+    uint32_t rows;
+} StreamLevel_t;
+
+struct StreamedTexture {
+    // what users see, the placeholder until the swap
+    Texture_t texture;
+    // the real texture, filled in over however many frames it takes.
+    // The decode job writes its size, texture gets a copy once the job is done
+    Texture_t target;
+    StreamState_e state;
+    bool released;
+
+    char *path;
+    JobCounter_t counter;
+    // set by the decode job, only read once counter is done
+    bool decodeFailed;
+    Image_t image;
+    Asset_t asset;
+
+    bool compressed;
+    GLenum internalFormat;
+    // transfer format, unused when compressed
+    GLenum format;
+    // texel rows per upload row
+    uint32_t rowHeight;
+    // levels past the base one for decoded images, in one allocation
+    uint8_t *mipmaps;
+    uint32_t levelCount;
+    StreamLevel_t levels[TEXTURE_FILE_MAX_LEVELS];
+
+    // upload progress
+    uint32_t level;
+    uint32_t row;
+    GLsync fence;
+
+    StreamedTexture_t *next;
+};
+
+typedef struct {
+    BufferHandle_t buffer;
+    // set after the frame that last used it, cleared once the GPU is done
+    GLsync fence;
+} StreamPbo_t;
+
+typedef struct {
+    StreamedTexture_t *stream;
+    uint32_t level;
+    uint32_t row;
+    uint32_t rows;
+    size_t offset;
+    // finishes the stream's last level
+    bool last;
+} StreamBand_t;
+
+static StreamedTexture_t *streams_m;
+static StreamedTexture_t *streamsTail_m;
+
+static StreamPbo_t streamPbos_m[TEXTURE_STREAM_PBO_COUNT];
+static uint32_t streamPboIndex_m;
+static size_t streamBudget_m = TEXTURE_STREAM_DEFAULT_BUDGET;
+
+static Texture_t placeholder_m;
+
+void TextureStream_init() {
+    // a flat grey pixel, doesn't stand out much while the real texture comes in
+    static const uint8_t grey[4] = { 128, 128, 128, 255 };
+    TextureHandle_t handle = Resources_acquireTexture(1, 1, GL_RGBA8, 1);
+    DW_setTextureParams();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    placeholder_m = (Texture_t) {
+        .channels = 4,
+        .texId = Resources_textureName(handle),
+        .handle = handle
+    };
+
+    for (int i = 0; i < TEXTURE_STREAM_PBO_COUNT; i++) {
+        streamPbos_m[i].buffer = Resources_acquireBuffer(streamBudget_m, GL_STREAM_DRAW);
+        streamPbos_m[i].fence = NULL;
+    }
+    streamPboIndex_m = 0;
+}
+
+static void freeSource(StreamedTexture_t *stream) {
+    if (stream->image.pixels != NULL) DW_freeImage(&stream->image);
+    if (stream->asset.data != NULL) Asset_free(&stream->asset);
+    Memory_free(stream->mipmaps);
+    stream->mipmaps = NULL;
+}
+
+static void destroyStream(StreamedTexture_t *stream) {
+    if (stream->fence != NULL) glDeleteSync(stream->fence);
+    // the resource manager holds on to it until the GPU is done
+    if (stream->target.handle.id != 0) DW_freeTexture(&stream->target);
+    freeSource(stream);
+    Memory_free(stream->path);
+    Memory_free(stream);
+}
+
+void TextureStream_shutdown() {
+    uint32_t leaked = 0;
+
+    StreamedTexture_t *stream = streams_m;
+    while (stream != NULL) {
+        StreamedTexture_t *next = stream->next;
+        if (!stream->released) leaked++;
+        // the job still has a pointer to it
+        JobSystem_wait(&stream->counter);
+        destroyStream(stream);
+        stream = next;
+    }
+    streams_m = NULL;
+    streamsTail_m = NULL;
+
+    if (leaked > 0) {
+        fprintf(stderr, "Error: %u streamed texture(s) were never released.\n", leaked);
+    }
+
+    for (int i = 0; i < TEXTURE_STREAM_PBO_COUNT; i++) {
+        if (streamPbos_m[i].fence != NULL) glDeleteSync(streamPbos_m[i].fence);
+        streamPbos_m[i].fence = NULL;
+        Resources_releaseBuffer(streamPbos_m[i].buffer);
+        streamPbos_m[i].buffer.id = 0;
+    }
+
+    DW_freeTexture(&placeholder_m);
+}
+
+void TextureStream_setBudget(size_t bytesPerFrame) {
+    streamBudget_m = bytesPerFrame;
+}
+
+// Worker side, no GL in here
+static void decodeStream(void *data) {
+    StreamedTexture_t *stream = (StreamedTexture_t*) data;
+
+    size_t len = strlen(stream->path);
+    if (len > 5 && strcmp(stream->path + len - 5, ".dwtx") == 0) {
+        if (!Asset_load(&stream->asset, stream->path)) {
+            fprintf(stderr, "Error: Couldn't find texture %s\n", stream->path);
+            stream->decodeFailed = true;
+            return;
+        }
+
+        const TextureFileHeader_t *header = TextureFile_validate(stream->asset.data, stream->asset.size);
+        if (header == NULL) {
+            fprintf(stderr, "Error: %s isn't a valid version %d DWTX texture.\n", stream->path, TEXTURE_FILE_VERSION);
+            stream->decodeFailed = true;
+            return;
+        }
+
+        // the levels are uploaded straight out of the asset, usually the pack mapping
+        stream->compressed = TextureFormat_isCompressed(header->format);
+        stream->internalFormat = DW_textureFileFormat(header->format);
+        stream->format = GL_RGBA;
+        stream->rowHeight = stream->compressed ? 4 : 1;
+        stream->levelCount = header->levels;
+        stream->target.channels = header->format == TEXTURE_FORMAT_BC1 ? 3 : 4;
+        stream->target.width = header->width;
+        stream->target.height = header->height;
+
+        const TextureFileLevel_t *levels = TextureFile_levels(header);
+        for (uint32_t i = 0; i < header->levels; i++) {
+            stream->levels[i] = (StreamLevel_t) {
+                .data = stream->asset.data + levels[i].offset,
+                .width = levels[i].width,
+                .height = levels[i].height,
+                .rowBytes = TextureFormat_levelSize(header->format, levels[i].width, stream->rowHeight),
+                .rows = (levels[i].height + stream->rowHeight - 1) / stream->rowHeight
+            };
+        }
+        return;
+    }
+
+    if (!DW_loadImage(&stream->image, stream->path)) {
+        stream->decodeFailed = true;
+        return;
+    }
+
+    Image_t *image = &stream->image;
+    // grey and grey+alpha get widened, everything else is uploaded as rgb(a)
+    if (image->channels < 3) {
+        size_t count = (size_t) image->width * image->height;
+        uint8_t *rgba = malloc(count * 4);
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t *src = image->pixels + i * image->channels;
+            rgba[i * 4 + 0] = src[0];
+            rgba[i * 4 + 1] = src[0];
+            rgba[i * 4 + 2] = src[0];
+            rgba[i * 4 + 3] = image->channels == 2 ? src[1] : 255;
+        }
+        // stbi frees with plain free, so DW_freeImage still works on this
+        DW_freeImage(image);
+        image->pixels = rgba;
+        image->channels = 4;
+    }
+
+    uint32_t width = image->width;
+    uint32_t height = image->height;
+    uint32_t channels = image->channels;
+
+    uint32_t levels = 1;
+    while ((width | height) >> levels && levels < TEXTURE_FILE_MAX_LEVELS) levels++;
+
+    // mips are built here too, glGenerateMipmap can take a whole frame on some drivers
+    size_t mipBytes = 0;
+    for (uint32_t i = 1; i < levels; i++) {
+        uint32_t w = width >> i ? width >> i : 1;
+        uint32_t h = height >> i ? height >> i : 1;
+        mipBytes += (size_t) w * h * channels;
+    }
+    stream->mipmaps = mipBytes > 0 ? Memory_alloc(MEMORY_TAG_ASSET, mipBytes) : NULL;
+
+    stream->compressed = false;
+    stream->internalFormat = channels == 3 ? GL_RGB8 : GL_RGBA8;
+    stream->format = channels == 3 ? GL_RGB : GL_RGBA;
+    stream->rowHeight = 1;
+    stream->levelCount = levels;
+    stream->target.channels = channels;
+    stream->target.width = width;
+    stream->target.height = height;
+
+    uint8_t *dst = stream->mipmaps;
+    const uint8_t *src = image->pixels;
+    for (uint32_t i = 0; i < levels; i++) {
+        uint32_t w = width >> i ? width >> i : 1;
+        uint32_t h = height >> i ? height >> i : 1;
+        if (i > 0) {
+            TextureFile_downsample(src, stream->levels[i - 1].width, stream->levels[i - 1].height, channels, dst);
+            src = dst;
+            dst += (size_t) w * h * channels;
+        }
+
+        stream->levels[i] = (StreamLevel_t) {
+            .data = src,
+            .width = w,
+            .height = h,
+            .rowBytes = (size_t) w * channels,
+            .rows = h
+        };
+    }
+}
+
+StreamedTexture_t* TextureStream_load(const char *path) {
+    StreamedTexture_t *stream = Memory_calloc(MEMORY_TAG_ASSET, 1, sizeof(StreamedTexture_t));
+    stream->texture = placeholder_m;
+    stream->state = STREAM_DECODING;
+    stream->path = Memory_strdup(MEMORY_TAG_ASSET, path);
+
+    if (streamsTail_m != NULL) streamsTail_m->next = stream;
+    else streams_m = stream;
+    streamsTail_m = stream;
+
+    JobSystem_run(decodeStream, stream, &stream->counter);
+    return stream;
+}
+
+const Texture_t* TextureStream_texture(StreamedTexture_t *stream) {
+    return &stream->texture;
+}
+
+bool TextureStream_isReady(StreamedTexture_t *stream) {
+    return stream->state == STREAM_READY;
+}
+
+uint32_t TextureStream_pendingCount() {
+    uint32_t count = 0;
+    for (StreamedTexture_t *stream = streams_m; stream != NULL; stream = stream->next) {
+        if (!stream->released && stream->state != STREAM_READY && stream->state != STREAM_FAILED) count++;
+    }
+    return count;
+}
+
+void TextureStream_release(StreamedTexture_t *stream) {
+    // freed by the next update, or once its decode job is done
+    stream->released = true;
+}
+
+// Storage for the real texture, once we know what it is
+static bool beginUpload(StreamedTexture_t *stream) {
+    if (stream->compressed && !DW_hasS3TC()) {
+        fprintf(stderr, "Error: Driver doesn't support S3TC, can't stream %s\n", stream->path);
+        return false;
+    }
+
+    TextureHandle_t handle = Resources_acquireTexture(stream->target.width, stream->target.height, stream->internalFormat, stream->levelCount);
+    DW_setTextureParams();
+
+    stream->target.texId = Resources_textureName(handle);
+    stream->target.handle = handle;
+    stream->level = 0;
+    stream->row = 0;
+    return true;
+}
+
+static StreamedTexture_t* nextUpload(StreamedTexture_t *stream) {
+    for (; stream != NULL; stream = stream->next) {
+        if (stream->released) continue;
+        if (stream->state == STREAM_QUEUED || stream->state == STREAM_UPLOADING) return stream;
+    }
+    return NULL;
+}
+
+static void submitBand(const StreamBand_t *band) {
+    StreamedTexture_t *stream = band->stream;
+    const StreamLevel_t *level = &stream->levels[band->level];
+
+    uint32_t y = band->row * stream->rowHeight;
+    uint32_t height = band->rows * stream->rowHeight;
+    // the last block row can hang over the edge
+    if (y + height > level->height) height = level->height - y;
+
+    // with a PBO bound the pointer is an offset into it
+    const void *offset = (const void*) (uintptr_t) band->offset;
+    glBindTexture(GL_TEXTURE_2D, stream->target.texId);
+    if (stream->compressed) {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, band->level, 0, y, level->width, height, stream->internalFormat, (GLsizei) (band->rows * level->rowBytes), offset);
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, band->level, 0, y, level->width, height, stream->format, GL_UNSIGNED_BYTE, offset);
+    }
+
+    if (band->last) {
+        // swapped in once this signals, so nothing draws with it half uploaded
+        stream->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        stream->state = STREAM_FENCED;
+    }
+}
+
+static void uploadFrame() {
+    StreamedTexture_t *stream = nextUpload(streams_m);
+    if (stream == NULL) return;
+
+    StreamPbo_t *pbo = &streamPbos_m[streamPboIndex_m];
+    if (pbo->fence != NULL) {
+        // the GPU is still reading it, try again next frame instead of stalling
+        if (glClientWaitSync(pbo->fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+        glDeleteSync(pbo->fence);
+        pbo->fence = NULL;
+    }
+
+    // always room for one row, otherwise a texture wider than the budget would never finish
+    size_t capacity = streamBudget_m;
+    const StreamLevel_t *first = &stream->levels[stream->state == STREAM_UPLOADING ? stream->level : 0];
+    if (first->rowBytes > capacity) capacity = first->rowBytes;
+    if (Resources_bufferSize(pbo->buffer) < capacity) Resources_resizeBuffer(pbo->buffer, capacity);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Resources_bufferName(pbo->buffer));
+    // unsynchronized is fine, the fence above says the GPU is done with the old contents
+    uint8_t *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, capacity,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped == NULL) {
+        fprintf(stderr, "Error: Couldn't map a texture streaming buffer.\n");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return;
+    }
+
+    // copy everything in first, GL can't read from the buffer while it's mapped
+    StreamBand_t bands[STREAM_MAX_BANDS];
+    uint32_t bandCount = 0;
+    size_t used = 0;
+    bool full = false;
+
+    for (; stream != NULL && !full; stream = nextUpload(stream->next)) {
+        if (stream->state == STREAM_QUEUED) {
+            if (!beginUpload(stream)) {
+                stream->state = STREAM_FAILED;
+                freeSource(stream);
+                continue;
+            }
+            stream->state = STREAM_UPLOADING;
+        }
+
+        while (stream->level < stream->levelCount) {
+            const StreamLevel_t *level = &stream->levels[stream->level];
+            size_t offset = (used + STREAM_ALIGNMENT - 1) & ~(size_t) (STREAM_ALIGNMENT - 1);
+            size_t space = capacity > offset ? capacity - offset : 0;
+
+            uint32_t rows = level->rows - stream->row;
+            if (rows > space / level->rowBytes) rows = (uint32_t) (space / level->rowBytes);
+            if (rows == 0 || bandCount == STREAM_MAX_BANDS) {
+                full = true;
+                break;
+            }
+
+            memcpy(mapped + offset, level->data + stream->row * level->rowBytes, rows * level->rowBytes);
+            bands[bandCount] = (StreamBand_t) { stream, stream->level, stream->row, rows, offset, false };
+            used = offset + rows * level->rowBytes;
+
+            stream->row += rows;
+            if (stream->row == level->rows) {
+                stream->level++;
+                stream->row = 0;
+            }
+            bands[bandCount++].last = stream->level == stream->levelCount;
+        }
+
+        // everything's in the PBO, the decoded copy isn't needed anymore
+        if (stream->level == stream->levelCount) freeSource(stream);
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // rgb rows aren't 4 byte aligned unless the width works out
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < bandCount; i++) {
+        submitBand(&bands[i]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    pbo->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    streamPboIndex_m = (streamPboIndex_m + 1) % TEXTURE_STREAM_PBO_COUNT;
+}
+
+void TextureStream_update() {
+    StreamedTexture_t *prev = NULL;
+    StreamedTexture_t *stream = streams_m;
+
+    while (stream != NULL) {
+        StreamedTexture_t *next = stream->next;
+
+        if (stream->state == STREAM_DECODING && JobCounter_isDone(&stream->counter)) {
+            stream->state = stream->decodeFailed ? STREAM_FAILED : STREAM_QUEUED;
+            if (stream->decodeFailed) freeSource(stream);
+            stream->texture.width = stream->target.width;
+            stream->texture.height = stream->target.height;
+        }
+
+        if (stream->state == STREAM_FENCED && glClientWaitSync(stream->fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+            glDeleteSync(stream->fence);
+            stream->fence = NULL;
+            stream->texture = stream->target;
+            stream->state = STREAM_READY;
+        }
+
+        if (stream->released && stream->state != STREAM_DECODING) {
+            if (prev != NULL) prev->next = next;
+            else streams_m = next;
+            if (streamsTail_m == stream) streamsTail_m = prev;
+            destroyStream(stream);
+        } else {
+            prev = stream;
+        }
+
+        stream = next;
+    }
+
+    uploadFrame();
+}
@@ -0,0 +1,54 @@
+#ifndef TEXSTREAM_H
+#define TEXSTREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "renderer.h"
+
+// PBOs the uploads rotate through, one is only written again once the GPU has read it
+#define TEXTURE_STREAM_PBO_COUNT 3
+// bytes copied into textures per frame unless TextureStream_setBudget says otherwise
+#define TEXTURE_STREAM_DEFAULT_BUDGET (4u << 20)
+
+typedef struct StreamedTexture StreamedTexture_t;
+
+/**
+ * Loads textures without stalling the render thread. Decoding runs as a job,
+ * then TextureStream_update copies at most budget bytes a frame into a ring of
+ * pixel buffer objects and uploads from there, a few rows at a time, so a big
+ * texture is spread over as many frames as it needs.
+ *
+ * Until a texture is done it shows a placeholder, it gets swapped for the real
+ * one once the GPU has finished the last upload. Main thread only.
+ */
+void TextureStream_init();
+
+// Waits for decodes that are still running, reports streams that were never released
+void TextureStream_shutdown();
+
+// Bytes a frame is allowed to upload, a single row is always let through even if it's bigger
+void TextureStream_setBudget(size_t bytesPerFrame);
+
+// Call once a frame, before rendering
+void TextureStream_update();
+
+// Starts loading a .dwtx container or an image, the returned texture is usable straight away
+StreamedTexture_t* TextureStream_load(const char *path);
+
+/**
+ * The placeholder until the upload has finished, then the real texture. Read texId
+ * from it every time instead of keeping a copy. width and height stay 0 until decoded.
+ */
+const Texture_t* TextureStream_texture(StreamedTexture_t *stream);
+
+bool TextureStream_isReady(StreamedTexture_t *stream);
+
+// Streams still decoding or uploading, eg. for a loading bar
+uint32_t TextureStream_pendingCount();
+
+// Frees the texture, or cancels it if it's still loading
+void TextureStream_release(StreamedTexture_t *stream);
+
+#endif
@@ -0,0 +1,133 @@
+#include "trace.h"
+
+#include <stdio.h>
+
+#include "util.h"
+
+static TraceEvent_t traceEvents_m[TRACE_MAX_EVENTS];
+static uint32_t traceCount_m;
+static uint64_t traceEpoch_m;
+static uint32_t traceThreads_m;
+
+// -1 until the thread records something
+static __thread int32_t traceThread_m = -1;
+static __thread uint32_t traceDepth_m;
+// event index of each open span, -1 if it was dropped
+static __thread int32_t traceStack_m[TRACE_MAX_DEPTH];
+
+void Trace_init() {
+    traceEpoch_m = DW_currentTimeNanos();
+
+    // every slot reads as open until Trace_end or Trace_mark publishes it, so a
+    // reader never picks up one that another thread is still filling in
+    for (uint32_t i = 0; i < TRACE_MAX_EVENTS; i++) {
+        traceEvents_m[i].end = UINT64_MAX;
+    }
+}
+
+uint64_t Trace_now() {
+    return DW_currentTimeNanos() - traceEpoch_m;
+}
+
+static TraceEvent_t* Trace_push(const char *name, int32_t *index) {
+    if (traceThread_m < 0) traceThread_m = __atomic_fetch_add(&traceThreads_m, 1, __ATOMIC_RELAXED);
+
+    uint32_t slot = __atomic_fetch_add(&traceCount_m, 1, __ATOMIC_RELAXED);
+    if (slot >= TRACE_MAX_EVENTS) {
+        *index = -1;
+        return NULL;
+    }
+
+    TraceEvent_t *event = &traceEvents_m[slot];
+    event->name = name;
+    event->thread = traceThread_m;
+    event->depth = traceDepth_m;
+    event->instant = false;
+    event->start = Trace_now();
+    *index = slot;
+    return event;
+}
+
+void Trace_begin(const char *name) {
+    int32_t index;
+    Trace_push(name, &index);
+
+    if (traceDepth_m < TRACE_MAX_DEPTH) traceStack_m[traceDepth_m] = index;
+    traceDepth_m++;
+}
+
+void Trace_end() {
+    if (traceDepth_m == 0) return;
+    traceDepth_m--;
+
+    if (traceDepth_m >= TRACE_MAX_DEPTH) return;
+    int32_t index = traceStack_m[traceDepth_m];
+    // readers on other threads skip spans that haven't ended
+    if (index >= 0) __atomic_store_n(&traceEvents_m[index].end, Trace_now(), __ATOMIC_RELEASE);
+}
+
+void Trace_mark(const char *name) {
+    int32_t index;
+    TraceEvent_t *event = Trace_push(name, &index);
+    if (event == NULL) return;
+
+    event->instant = true;
+    __atomic_store_n(&event->end, event->start, __ATOMIC_RELEASE);
+}
+
+static uint32_t Trace_count() {
+    uint32_t count = __atomic_load_n(&traceCount_m, __ATOMIC_RELAXED);
+    return count < TRACE_MAX_EVENTS ? count : TRACE_MAX_EVENTS;
+}
+
+void Trace_print() {
+    uint32_t count = Trace_count();
+    for (uint32_t i = 0; i < count; i++) {
+        const TraceEvent_t *event = &traceEvents_m[i];
+        uint64_t end = __atomic_load_n(&event->end, __ATOMIC_ACQUIRE);
+        if (end == UINT64_MAX) continue;
+
+        if (event->instant) {
+            printf("  %*s%s at %.2f ms\n", event->depth * 2, "", event->name, event->start / 1e6);
+        } else {
+            printf("  %*s%-*s %8.2f ms\n", event->depth * 2, "", 32 - (int) event->depth * 2, event->name, (end - event->start) / 1e6);
+        }
+    }
+}
+
+bool Trace_writeJson(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Couldn't open %s for writing\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    bool first = true;
+    uint32_t count = Trace_count();
+    for (uint32_t i = 0; i < count; i++) {
+        const TraceEvent_t *event = &traceEvents_m[i];
+        uint64_t end = __atomic_load_n(&event->end, __ATOMIC_ACQUIRE);
+        if (end == UINT64_MAX) continue;
+
+        fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+        for (const char *c = event->name; *c; c++) {
+            if (*c == '"' || *c == '\\') fputc('\\', file);
+            fputc(*c, file);
+        }
+
+        // chrome wants microseconds
+        if (event->instant) {
+            fprintf(file, "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", event->start / 1e3, event->thread);
+        } else {
+            fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                event->start / 1e3, (end - event->start) / 1e3, event->thread);
+        }
+        first = false;
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
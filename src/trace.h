@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// spans and marks kept for the whole run, later ones are dropped
+#define TRACE_MAX_EVENTS 4096
+// nesting per thread
+#define TRACE_MAX_DEPTH 32
+
+typedef struct {
+    // has to outlive the trace, string literals are what this is meant for
+    const char *name;
+    // nanoseconds since Trace_init
+    uint64_t start;
+    // UINT64_MAX until published, while the span is open or the slot is being filled in. Same as start for marks
+    uint64_t end;
+    uint32_t thread;
+    uint32_t depth;
+    bool instant;
+} TraceEvent_t;
+
+/**
+ * Records timed spans, mostly for startup. Spans nest per thread and can be
+ * started from any thread, ending one is just a timestamp so it's cheap enough
+ * to leave on. Trace_print gives a readable table, Trace_writeJson a Chrome
+ * trace (chrome://tracing or ui.perfetto.dev).
+ */
+
+// Call first thing, every timestamp is relative to this
+void Trace_init();
+
+void Trace_begin(const char *name);
+
+// Ends the innermost span this thread began
+void Trace_end();
+
+// A single point in time, eg. the first frame
+void Trace_mark(const char *name);
+
+// Nanoseconds since Trace_init
+uint64_t Trace_now();
+
+// Finished spans in the order they started, indented by depth
+void Trace_print();
+
+bool Trace_writeJson(const char *path);
+
+#endif
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transform.h"
+#include "memory.h"
+
+void TransformSystem_init(TransformSystem_t *ts, uint32_t capacity) {
+    ts->count = 0;
+    ts->capacity = capacity;
+    ts->nodes = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(TransformNode_t));
+    ts->packed = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(Affine2D_t));
+    ts->changed = Memory_alloc(MEMORY_TAG_SCENE, capacity * sizeof(uint8_t));
+}
+
+void TransformSystem_free(TransformSystem_t *ts) {
+    Memory_free(ts->nodes);
+    Memory_free(ts->packed);
+    Memory_free(ts->changed);
+
+    ts->nodes = NULL;
+    ts->packed = NULL;
+    ts->changed = NULL;
+    ts->count = 0;
+    ts->capacity = 0;
+}
+
+uint32_t TransformSystem_create(TransformSystem_t *ts, uint32_t parent) {
+    if (parent != TRANSFORM_NO_PARENT && parent >= ts->count) {
+        fprintf(stderr, "Error: Transform parent %u doesn't exist yet.\n", parent);
+        parent = TRANSFORM_NO_PARENT;
+    }
+
+    if (ts->count == ts->capacity) {
+        ts->capacity = ts->capacity ? ts->capacity * 2 : 16;
+        ts->nodes = Memory_realloc(MEMORY_TAG_SCENE, ts->nodes, ts->capacity * sizeof(TransformNode_t));
+        ts->packed = Memory_realloc(MEMORY_TAG_SCENE, ts->packed, ts->capacity * sizeof(Affine2D_t));
+        ts->changed = Memory_realloc(MEMORY_TAG_SCENE, ts->changed, ts->capacity * sizeof(uint8_t));
+    }
+
+    uint32_t index = ts->count++;
+    TransformNode_t *node = &ts->nodes[index];
+    glm_vec2_zero(node->pos);
+    glm_vec2_one(node->scale);
+    node->rotation = 0.0f;
+    node->parent = parent;
+    node->dirty = true;
+    glm_mat3_identity(node->world);
+
+    return index;
+}
+
+void TransformSystem_clear(TransformSystem_t *ts) {
+    ts->count = 0;
+}
+
+void Transform_setPosition(TransformSystem_t *ts, uint32_t node, vec2 pos) {
+    TransformNode_t *n = &ts->nodes[node];
+    if (n->pos[0] == pos[0] && n->pos[1] == pos[1]) return;
+
+    glm_vec2_copy(pos, n->pos);
+    n->dirty = true;
+}
+
+void Transform_setRotation(TransformSystem_t *ts, uint32_t node, float rotation) {
+    TransformNode_t *n = &ts->nodes[node];
+    if (n->rotation == rotation) return;
+
+    n->rotation = rotation;
+    n->dirty = true;
+}
+
+void Transform_setScale(TransformSystem_t *ts, uint32_t node, vec2 scale) {
+    TransformNode_t *n = &ts->nodes[node];
+    if (n->scale[0] == scale[0] && n->scale[1] == scale[1]) return;
+
+    glm_vec2_copy(scale, n->scale);
+    n->dirty = true;
+}
+
+// translate * rotate * scale, written out instead of going through 3 matrix multiplies
+static void buildLocal(TransformNode_t *node, mat3 dest) {
+    float c = cosf(node->rotation);
+    float s = sinf(node->rotation);
+
+    dest[0][0] = c * node->scale[0];
+    dest[0][1] = s * node->scale[0];
+    dest[0][2] = 0.0f;
+
+    dest[1][0] = -s * node->scale[1];
+    dest[1][1] = c * node->scale[1];
+    dest[1][2] = 0.0f;
+
+    dest[2][0] = node->pos[0];
+    dest[2][1] = node->pos[1];
+    dest[2][2] = 1.0f;
+}
+
+uint32_t TransformSystem_update(TransformSystem_t *ts) {
+    uint32_t updated = 0;
+
+    for (uint32_t i = 0; i < ts->count; i++) {
+        TransformNode_t *node = &ts->nodes[i];
+        bool parentChanged = node->parent != TRANSFORM_NO_PARENT && ts->changed[node->parent];
+
+        ts->changed[i] = node->dirty || parentChanged;
+        if (!ts->changed[i]) continue;
+
+        if (node->parent == TRANSFORM_NO_PARENT) {
+            buildLocal(node, node->world);
+        } else {
+            mat3 local;
+            buildLocal(node, local);
+            glm_mat3_mul(ts->nodes[node->parent].world, local, node->world);
+        }
+        node->dirty = false;
+
+        Affine2D_t *packed = &ts->packed[i];
+        packed->xAxis[0] = node->world[0][0];
+        packed->xAxis[1] = node->world[0][1];
+        packed->yAxis[0] = node->world[1][0];
+        packed->yAxis[1] = node->world[1][1];
+        packed->translation[0] = node->world[2][0];
+        packed->translation[1] = node->world[2][1];
+
+        updated++;
+    }
+
+    return updated;
+}
+
+Affine2D_t* TransformSystem_getPacked(TransformSystem_t *ts, uint32_t first) {
+    return &ts->packed[first];
+}
@@ -0,0 +1,70 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <cglm/cglm.h>
+
+#define TRANSFORM_NO_PARENT UINT32_MAX
+
+// 2x3 affine, laid out the way the *_inst vertex shaders read it per instance
+typedef struct {
+    vec2 xAxis;
+    vec2 yAxis;
+    vec2 translation;
+} Affine2D_t;
+
+typedef struct {
+    vec2 pos;
+    float rotation;
+    vec2 scale;
+
+    // index of the parent node, always lower than ours
+    uint32_t parent;
+    // local values changed since the last update
+    bool dirty;
+
+    // cached parent * local
+    mat3 world;
+} TransformNode_t;
+
+/**
+ * Flat array of 2D transform nodes. Parents always come before their children,
+ * so one forward pass over the array updates the whole hierarchy, and only nodes
+ * whose own or an ancestor's local transform changed get their matrices redone.
+ */
+typedef struct {
+    TransformNode_t *nodes;
+    // world transforms packed for instancing, same indices as nodes
+    Affine2D_t *packed;
+    // scratch flags for the update pass, set when a node's world matrix changed
+    uint8_t *changed;
+
+    uint32_t count;
+    uint32_t capacity;
+} TransformSystem_t;
+
+void TransformSystem_init(TransformSystem_t *ts, uint32_t capacity);
+
+void TransformSystem_free(TransformSystem_t *ts);
+
+// Adds an identity node and returns its index, parent has to already exist
+uint32_t TransformSystem_create(TransformSystem_t *ts, uint32_t parent);
+
+// Removes every node
+void TransformSystem_clear(TransformSystem_t *ts);
+
+void Transform_setPosition(TransformSystem_t *ts, uint32_t node, vec2 pos);
+
+void Transform_setRotation(TransformSystem_t *ts, uint32_t node, float rotation);
+
+void Transform_setScale(TransformSystem_t *ts, uint32_t node, vec2 scale);
+
+// Recomputes world matrices of dirty nodes and their children, returns how many were redone
+uint32_t TransformSystem_update(TransformSystem_t *ts);
+
+// Packed world affines for nodes [first, first + count), ready to upload as instance data
+Affine2D_t* TransformSystem_getPacked(TransformSystem_t *ts, uint32_t first);
+
+#endif
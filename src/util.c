@@ -2,48 +2,11 @@
 
 #include <stdio.h>
 #include <sys/time.h>
+#include <time.h>
 #include <stdlib.h>
 #include <stddef.h>
 
 
-const char* DW_loadSourceFile(const char *filePath) {
-    FILE *file = fopen(filePath, "rb");
-    
-    if (!file) {
-        fprintf(stderr, "Error: Unable to open source file %s\n", filePath);
-        return NULL;
-    }
-
-    // get file size
-    fseek(file, 0, SEEK_END);
-    uint32_t fileSize = ftell(file);
-    rewind(file);
-
-    char* textBuf = malloc(fileSize + 1);
-    if (!textBuf) {
-        fprintf(stderr, "Error: Failed to malloc text buffer for source file %s\n", filePath);
-        free(textBuf);
-        fclose(file);
-        return NULL;
-    }
-
-    // read all bytes into our buf
-    size_t bytesRead = fread(textBuf, 1, fileSize, file);
-    textBuf[fileSize] = '\0';
-
-    if (bytesRead < fileSize) {
-        fprintf(stderr, "Error: Failed reading source file %s bytesRead: %u fileSize: %u\n", filePath, bytesRead, fileSize);
-        free(textBuf);
-        fclose(file);
-        return NULL;
-    }
-
-    // add our null terminator
-
-    fclose(file);
-    return textBuf;
-}
-
 // skidded from stackoverflow, requires gnu lib sys/time.h
 int64_t DW_currentTimeMillis() {
     struct timeval time;
@@ -53,6 +16,12 @@ int64_t DW_currentTimeMillis() {
     return s1 + s2;
 }
 
+uint64_t DW_currentTimeNanos() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ull + time.tv_nsec;
+}
+
 // Sleep function that supports compilation across platforms
 #include <unistd.h>
 
@@ -3,10 +3,11 @@
 
 #include <stdint.h>
 
-const char* DW_loadSourceFile(const char* filePath);
-
 int64_t DW_currentTimeMillis();
 
+// Monotonic, only good for measuring intervals
+uint64_t DW_currentTimeNanos();
+
 void DW_sleepMillis(uint32_t ms);
 
 float DW_lerp(float then, float now, float delta);
@@ -0,0 +1,752 @@
+/**
+ * Golden image tests. Renders a fixed set of frames offscreen, reads them back and
+ * compares them against the references in tests/golden/, so renderer changes that
+ * are meant to be invisible can be checked to really be invisible.
+ *
+ * usage: DeltaWingGolden [-u] [-t timings.csv] [case...]
+ *   -u  write the references from this run instead of comparing
+ *   -t  also write each case's render time out as csv
+ *   only the named cases run if any are given
+ *
+ * Run from the repo root so it finds assets/. The references come from Mesa's llvmpipe,
+ * which gets picked by default (LIBGL_ALWAYS_SOFTWARE) and needs no GPU or display
+ * through a surfaceless EGL context. Without EGL it falls back to a hidden GLFW window.
+ * A failing case leaves <case>.actual.png and <case>.diff.png next to its reference.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFINE_GLOBALS
+#include "../src/globals.h"
+
+#include "../src/util.h"
+#include "../src/jobs.h"
+#include "../src/rng.h"
+#include "../src/archive.h"
+#include "../src/arena.h"
+#include "../src/memory.h"
+#include "../src/level.h"
+#include "../src/resources.h"
+#include "../src/postfx.h"
+#include "../src/sprites.h"
+#include "../src/texpool.h"
+#include "../src/texstream.h"
+#include "../src/scenes.h"
+
+#include <stb_image.h>
+
+#ifdef DW_GOLDEN_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "png.h"
+
+#define GOLDEN_DIR "tests/golden"
+// rasterizer rounding between driver versions, anything past this is a real change
+#define GOLDEN_CHANNEL_TOLERANCE 2
+// and this many pixels per million can go past it, for the odd edge pixel
+#define GOLDEN_PIXEL_TOLERANCE 100
+
+#define FORMAT_SIZE 128
+
+typedef struct {
+    const char *name;
+    uint32_t width;
+    uint32_t height;
+    // gets the state ready, untimed. Can be NULL
+    void (*setup)(int arg);
+    // draws the frame into the bound framebuffer, arg is the case's own
+    void (*render)(int arg);
+    int arg;
+} GoldenCase_t;
+
+typedef struct {
+    uint32_t failedPixels;
+    uint32_t maxDelta;
+} GoldenDiff_t;
+
+// defined in world.c, we wait on it so chunks come in on the same tick every run
+extern LevelStreamer_t level;
+
+GLFWwindow *window;
+
+static GLuint framebuffer_m;
+static GLuint colorTexture_m;
+static uint32_t framebufferWidth_m;
+static uint32_t framebufferHeight_m;
+
+static uint32_t worldTicks_m;
+
+void DW_exitGame() {
+
+}
+
+void DW_setScene(Scene_t *scene) {
+    if (currentScene != NULL) currentScene->exit();
+
+    // no loader thread here, everything happens in place
+    currentScene = scene;
+    if (scene->preload != NULL) scene->preload();
+    scene->activate();
+}
+
+static void DW_GLerrorCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam) {
+    fprintf(stderr, "GL ERROR: %s\n", message);
+}
+
+#ifdef DW_GOLDEN_EGL
+static bool initEgl() {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if (getPlatformDisplay != NULL) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API)) return false;
+
+    EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 6,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    // no surface at all, everything goes to our own framebuffer
+    EGLContext eglContext = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) return false;
+
+    if (!gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) return false;
+    TexturePool_initBindless((GLADloadproc) eglGetProcAddress);
+    return true;
+}
+#endif
+
+static bool initGlfw() {
+    if (!glfwInit()) return false;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    window = glfwCreateWindow(DISPLAY_WIDTH, DISPLAY_HEIGHT, "DeltaWing golden", NULL, NULL);
+    if (window == NULL) return false;
+
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) return false;
+    TexturePool_initBindless((GLADloadproc) glfwGetProcAddress);
+    return true;
+}
+
+static bool initContext() {
+    // the references come from llvmpipe, and Mesa only says 4.6 when asked to
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+    setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+
+    bool loaded = false;
+#ifdef DW_GOLDEN_EGL
+    loaded = initEgl();
+#endif
+    if (!loaded) loaded = initGlfw();
+    if (!loaded) {
+        fprintf(stderr, "Error: Couldn't create a GL context\n");
+        return false;
+    }
+
+    const char *renderer = (const char*) glGetString(GL_RENDERER);
+    printf("OpenGL: %s\n", glGetString(GL_VERSION));
+    printf("Renderer: %s\n", renderer);
+    printf("Bindless textures: %s\n", TexturePool_hasBindless() ? "yes" : "no");
+    if (strstr(renderer, "llvmpipe") == NULL) {
+        printf("Warning: the references were rendered with llvmpipe, expect differences\n");
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_FALSE);
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR, GL_DONT_CARE, 0, NULL, GL_TRUE);
+    glDebugMessageCallback((GLDEBUGPROC) DW_GLerrorCallback, 0);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return true;
+}
+
+// Same order as DW_initGame, minus the loader thread
+static void initGame() {
+    Rng_setSeed(RNG_DEFAULT_SEED);
+    Archive_mount(DW_ASSET_PACK);
+    Resources_init();
+    FrameArena_init();
+    JobSystem_init(0);
+    TextureStream_init();
+
+    Shader_compileDefaultShaders();
+    Renderer_initVertexArrays();
+
+    context = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(Context_t));
+    Context_init(context, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    PostFx_init(DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    // the scale depends on how fast this machine is, so it stays at native
+    PostFx_settings()->dynamicResolution = false;
+
+    fontRenderer = Memory_alloc(MEMORY_TAG_FONT, sizeof(FontRenderer_t));
+    FontRenderer_init(fontRenderer, context, "assets/roboto_mono.fnt", 0.5f);
+    lineRenderer = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(LineRenderer_t));
+    LineRenderer_init(lineRenderer, context);
+
+    input = Memory_calloc(MEMORY_TAG_ENGINE, 1, sizeof(Input_t));
+}
+
+static void cleanupGame() {
+    if (currentScene != NULL) {
+        currentScene->exit();
+        currentScene = NULL;
+    }
+
+    FontRenderer_free(fontRenderer);
+    LineRenderer_free(lineRenderer);
+    Memory_free(lineRenderer);
+    PostFx_shutdown();
+    Renderer_freeVertexArrays();
+    Context_free(context);
+    Memory_free(context);
+    Memory_free(input);
+    TextureStream_shutdown();
+
+    if (framebuffer_m != 0) {
+        glDeleteFramebuffers(1, &framebuffer_m);
+        glDeleteTextures(1, &colorTexture_m);
+    }
+
+    Resources_shutdown();
+    JobSystem_shutdown();
+    FrameArena_printStats();
+    FrameArena_shutdown();
+    Archive_unmount();
+    Memory_printLeaks();
+}
+
+static void bindFramebuffer(uint32_t width, uint32_t height) {
+    if (width != framebufferWidth_m || height != framebufferHeight_m) {
+        if (framebuffer_m != 0) {
+            glDeleteFramebuffers(1, &framebuffer_m);
+            glDeleteTextures(1, &colorTexture_m);
+        }
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &colorTexture_m);
+        glTextureStorage2D(colorTexture_m, 1, GL_RGBA8, width, height);
+        glCreateFramebuffers(1, &framebuffer_m);
+        glNamedFramebufferTexture(framebuffer_m, GL_COLOR_ATTACHMENT0, colorTexture_m, 0);
+        framebufferWidth_m = width;
+        framebufferHeight_m = height;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_m);
+    glViewport(0, 0, width, height);
+    PostFx_setOutput(framebuffer_m);
+}
+
+// One frame of the current scene the way DW_render does it
+static void renderScene(int arg) {
+    PostFx_begin();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (currentScene != NULL) currentScene->render();
+    PostFx_end();
+}
+
+static void setupMenu(int arg) {
+    if (currentScene != &Scene_MainMenu) DW_setScene(&Scene_MainMenu);
+
+    PostFx_settings()->enabled = true;
+    glClearColor(.1f, .1f, .1f, 1.0f);
+    // llvmpipe compiles shaders on their first draw, which shouldn't count
+    renderScene(0);
+}
+
+// The streamer makes chunks in microseconds, this just makes sure it's had the chance
+static void waitForLevel() {
+    do {
+        DW_sleepMillis(1);
+    } while (!__atomic_load_n(&level.sleeping, __ATOMIC_SEQ_CST));
+}
+
+// Streams finish whenever the GPU gets to them, so they're run to the end before a frame that shows them
+static void finishTextureStreams() {
+    while (TextureStream_pendingCount() > 0) {
+        TextureStream_update();
+        glFinish();
+        DW_sleepMillis(1);
+    }
+}
+
+// Runs the world up to arg ticks in, one frame per tick, flapping every so often so we fly through the level
+static void setupWorld(int arg) {
+    if (currentScene != &Scene_World || worldTicks_m > arg) {
+        DW_setScene(&Scene_World);
+        worldTicks_m = 0;
+        glClearColor(.1f, .1f, .1f, 1.0f);
+        finishTextureStreams();
+    }
+
+    PostFx_settings()->enabled = true;
+    context->partialTicks = 0.0f;
+    context->frameTime = MS_PER_TICK / 1000.0f;
+
+    while (worldTicks_m < arg) {
+        if (worldTicks_m % 12 == 0) currentScene->onKey(GLFW_KEY_SPACE, 0, GLFW_PRESS, 0);
+        currentScene->tick();
+        waitForLevel();
+        worldTicks_m++;
+        renderScene(0);
+        FrameArena_endFrame();
+    }
+}
+
+static void renderFont(int arg) {
+    PostFx_settings()->enabled = false;
+    glClearColor(.1f, .1f, .1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // every glyph, a line per colour
+    char glyphs[GLYPH_LAST - GLYPH_FIRST + 2];
+    for (int c = GLYPH_FIRST; c <= GLYPH_LAST; c++) {
+        glyphs[c - GLYPH_FIRST] = (char) c;
+    }
+    glyphs[GLYPH_LAST - GLYPH_FIRST + 1] = '\0';
+
+    vec4 colors[] = {
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        { 1.0f, 0.0f, 0.0f, 1.0f },
+        { 0.2f, 0.9f, 1.0f, 1.0f },
+        { 1.0f, 0.85f, 0.1f, 0.5f }
+    };
+    for (int i = 0; i < 4; i++) {
+        FontRenderer_setColor(fontRenderer, colors[i]);
+        FontRenderer_drawString(fontRenderer, glyphs, 4.0f, 4.0f + fontRenderer->charHeight * i);
+    }
+
+    // one long string, much bigger than the instance buffer starts out, running off the edge
+    char longText[1025];
+    for (int i = 0; i < 1024; i++) {
+        longText[i] = "DeltaWing 0123456789 "[i % 21];
+    }
+    longText[1024] = '\0';
+    FontRenderer_setColor(fontRenderer, colors[0]);
+    for (int i = 0; i < 8; i++) {
+        FontRenderer_drawString(fontRenderer, longText + i * 7, 4.0f - i * 13.0f, 160.0f + fontRenderer->charHeight * i);
+    }
+
+    // overlapping translucent strings, and ones with characters the font doesn't have
+    FontRenderer_setColor(fontRenderer, (vec4) { 1.0f, 0.0f, 1.0f, 0.5f });
+    FontRenderer_drawString(fontRenderer, "Overlapping translucent text", 40.0f, 520.0f);
+    FontRenderer_drawString(fontRenderer, "Overlapping translucent text", 44.0f, 524.0f);
+    FontRenderer_drawString(fontRenderer, "tab\tand\x7f delete", 40.0f, 600.0f);
+
+    // through the model matrix, which the glyphs have to follow
+    MatrixStack_t *stack = context->matrixStack;
+    for (int i = 0; i < 6; i++) {
+        MatrixStack_pushMatrix(stack);
+        MatrixStack_translate(stack, (vec3) { 900.0f, 500.0f, 0.0f });
+        MatrixStack_rotate(stack, i * GLM_PI_4f / 2.0f, (vec3) { 0.0f, 0.0f, 1.0f });
+        FontRenderer_setColor(fontRenderer, colors[i % 4]);
+        FontRenderer_drawString(fontRenderer, "rotated", 20.0f, 0.0f);
+        MatrixStack_popMatrix(stack);
+    }
+}
+
+// Nearest filtered checkerboard, so any uv precision loss moves an edge
+static GLuint createChecker() {
+    uint8_t checker[16 * 16 * 4];
+    for (int i = 0; i < 16 * 16; i++) {
+        bool on = ((i % 16) / 4 + (i / 16) / 4) % 2;
+        checker[i * 4] = on ? 255 : 0;
+        checker[i * 4 + 1] = on ? 0 : 255;
+        checker[i * 4 + 2] = i;
+        checker[i * 4 + 3] = 255;
+    }
+
+    GLuint texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_RGBA8, 16, 16);
+    glTextureSubImage2D(texture, 0, 0, 0, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+static size_t packVertex(VertexFormat_e format, vec2 pos, vec4 color, vec2 uv, uint8_t *out) {
+    switch (format) {
+        case VERTEX_FORMAT_PC: {
+            Vertex_PC v = { { pos[0], pos[1], 0.0f }, { color[0], color[1], color[2], color[3] } };
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        case VERTEX_FORMAT_PT: {
+            Vertex_PT v = { { pos[0], pos[1], 0.0f }, { uv[0], uv[1] } };
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        case VERTEX_FORMAT_PCT: {
+            Vertex_PCT v = { { pos[0], pos[1], 0.0f }, { color[0], color[1], color[2], color[3] }, { uv[0], uv[1] } };
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        case VERTEX_FORMAT_P2C8: {
+            Vertex_P2C8 v = { { pos[0], pos[1] } };
+            Vertex_packColor(color, v.color);
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        case VERTEX_FORMAT_S16C8: {
+            Vertex_S16C8 v = { { (int16_t) pos[0], (int16_t) pos[1] } };
+            Vertex_packColor(color, v.color);
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        case VERTEX_FORMAT_P2T16: {
+            Vertex_P2T16 v = { { pos[0], pos[1] } };
+            Vertex_packUv(uv, v.uv);
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        case VERTEX_FORMAT_P2C8T16: {
+            Vertex_P2C8T16 v = { { pos[0], pos[1] } };
+            Vertex_packColor(color, v.color);
+            Vertex_packUv(uv, v.uv);
+            memcpy(out, &v, sizeof(v));
+            break;
+        }
+        default:
+            break;
+    }
+    return VertexFormat_sizeOf(format);
+}
+
+// A quad per format, drawn once on its own and twice more instanced, with every index type between them
+static void renderFormat(int arg) {
+    VertexFormat_e format = (VertexFormat_e) arg;
+    PostFx_settings()->enabled = false;
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    Context_t formatContext;
+    Context_init(&formatContext, FORMAT_SIZE, FORMAT_SIZE);
+
+    vec2 positions[4] = { { 8.0f, 8.0f }, { 8.0f, 120.0f }, { 120.0f, 120.0f }, { 120.0f, 8.0f } };
+    vec4 colors[4] = { { 1.0f, 0.0f, 1.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 0.75f }, { 1.0f, 1.0f, 0.0f, 1.0f } };
+    vec2 uvs[4] = { { 0.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f } };
+
+    uint8_t vertices[4 * sizeof(Vertex_PCT)];
+    size_t stride = 0;
+    for (int i = 0; i < 4; i++) {
+        stride = packVertex(format, positions[i], colors[i], uvs[i], vertices + i * stride);
+    }
+
+    VertexBuffer_t *vb = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(VertexBuffer_t));
+    VertexBuffer_init(vb, stride, 4, 4 * stride, GL_STATIC_DRAW, vertices);
+
+    uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+    uint8_t byteIndices[6] = { 0, 1, 2, 0, 2, 3 };
+    IndexBuffer_t *ib = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(IndexBuffer_t));
+    if (format < VERTEX_FORMAT_P2C8) IndexBuffer_init(ib, 6, sizeof(indices), indices);
+    else if (format % 2 == 0) IndexBuffer_initTyped(ib, GL_UNSIGNED_BYTE, 6, byteIndices);
+    else IndexBuffer_initCompact(ib, 6, indices);
+
+    GLuint texture = 0;
+    if (VertexFormat_hasTexture(format)) {
+        texture = createChecker();
+        glBindTextureUnit(0, texture);
+    }
+
+    Renderer_t *renderer = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(Renderer_t));
+    Renderer_init(renderer, &formatContext, format, vb, ib);
+    Renderer_bind(renderer);
+    Renderer_draw(renderer);
+
+    Affine2D_t instances[2] = {
+        { { 0.25f, 0.0f }, { 0.0f, 0.25f }, { 4.0f, 4.0f } },
+        { { 0.0f, 0.4f }, { -0.4f, 0.0f }, { 124.0f, 72.0f } }
+    };
+    VertexBuffer_t *instanceVb = Memory_alloc(MEMORY_TAG_RENDERER, sizeof(VertexBuffer_t));
+    VertexBuffer_init(instanceVb, sizeof(Affine2D_t), 2, sizeof(instances), GL_STREAM_DRAW, instances);
+    Renderer_setInstanceBuffer(renderer, instanceVb);
+    Renderer_bind(renderer);
+    Renderer_drawInstanced(renderer, 2);
+
+    glFinish();
+    Renderer_free(renderer);
+    VertexBuffer_free(instanceVb);
+    VertexBuffer_free(vb);
+    IndexBuffer_free(ib);
+    if (texture != 0) {
+        glBindTextureUnit(0, 0);
+        glDeleteTextures(1, &texture);
+    }
+    Context_free(&formatContext);
+}
+
+// Plain and textured sprites, turned a bit more each row, with a tinted batch over the top
+static void renderSprites(int arg) {
+    PostFx_settings()->enabled = false;
+    glClearColor(.1f, .1f, .1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    SpriteBatch_t batch;
+    SpriteBatch_init(&batch, context);
+    GLuint texture = createChecker();
+
+    for (int textured = 0; textured < 2; textured++) {
+        for (int row = 0; row < 4; row++) {
+            for (int col = 0; col < 8; col++) {
+                vec2 pos = { 80.0f + col * 140.0f, 60.0f + textured * 340.0f + row * 80.0f };
+                vec2 size = { 40.0f + col * 6.0f, 30.0f };
+                vec4 uvRect = { col / 8.0f, 0.0f, 0.5f, 0.25f + row * 0.25f };
+                vec4 color = { col / 7.0f, 1.0f - row / 3.0f, 1.0f, 0.5f + row / 6.0f };
+                SpriteBatch_add(&batch, pos, size, row * GLM_PI_4f / 3.0f, uvRect, color);
+            }
+        }
+        SpriteBatch_flush(&batch, textured ? texture : 0);
+    }
+
+    SpriteBatch_setTint(&batch, (vec4) { 1.0f, 0.5f, 0.0f, 0.5f });
+    SpriteBatch_add(&batch, (vec2) { 600.0f, 20.0f }, (vec2) { 80.0f, 680.0f }, 0.0f, GLM_VEC4_ZERO, GLM_VEC4_ONE);
+    SpriteBatch_flush(&batch, 0);
+
+    glDeleteTextures(1, &texture);
+    SpriteBatch_free(&batch);
+}
+
+// Layers with a stripe width and colour each, all drawn in one flush. The pool starts
+// at 2 layers so it has to grow twice, and layer 1 is removed and replaced on the way
+static void renderTexturePool(int arg) {
+    PostFx_settings()->enabled = false;
+    glClearColor(.1f, .1f, .1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    TexturePool_t pool;
+    TexturePool_init(&pool, 16, 16, GL_RGBA8, 1, 2);
+
+    uint8_t pixels[16 * 16 * 4];
+    uint32_t layers[6];
+    for (int l = 0; l < 7; l++) {
+        for (int i = 0; i < 16 * 16; i++) {
+            bool on = ((i % 16) / (l + 1)) % 2;
+            pixels[i * 4] = on ? 40 * l : 255;
+            pixels[i * 4 + 1] = on ? 255 - 40 * l : i;
+            pixels[i * 4 + 2] = on ? 255 : 30 * l;
+            pixels[i * 4 + 3] = 255;
+        }
+        if (l == 6) {
+            TexturePool_remove(&pool, layers[1]);
+            layers[1] = TexturePool_add(&pool, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        } else {
+            layers[l] = TexturePool_add(&pool, 16, 16, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        }
+    }
+
+    SpriteBatch_t batch;
+    SpriteBatch_init(&batch, context);
+    for (int row = 0; row < 6; row++) {
+        for (int col = 0; col < 8; col++) {
+            vec2 pos = { 80.0f + col * 140.0f, 40.0f + row * 110.0f };
+            vec2 size = { 60.0f + col * 6.0f, 60.0f };
+            vec4 color = { 1.0f, 1.0f, 1.0f, 0.5f + col / 14.0f };
+            Sprite_t *sprite = SpriteBatch_add(&batch, pos, size, col * GLM_PI_4f / 7.0f, (vec4) { 0.0f, 0.0f, 1.0f, 1.0f }, color);
+            sprite->layer = layers[(row + col) % 6];
+        }
+    }
+    SpriteBatch_flushPool(&batch, &pool);
+
+    SpriteBatch_free(&batch);
+    TexturePool_free(&pool);
+}
+
+// The sky over the whole frame with the hills repeated along the bottom
+static void drawBackdrop(const Texture_t *sky, const Texture_t *hills) {
+    PostFx_settings()->enabled = false;
+    glClearColor(.1f, .1f, .1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    SpriteBatch_t batch;
+    SpriteBatch_init(&batch, context);
+    SpriteBatch_add(&batch, (vec2) { 0.0f, 0.0f }, (vec2) { DISPLAY_WIDTHF, DISPLAY_HEIGHTF }, 0.0f, (vec4) { 0.0f, 0.0f, 1.0f, 1.0f }, GLM_VEC4_ONE);
+    SpriteBatch_flush(&batch, sky->texId);
+    vec4 hillsUv = { 0.0f, 0.0f, DISPLAY_WIDTHF / hills->width, 1.0f };
+    SpriteBatch_add(&batch, (vec2) { 0.0f, DISPLAY_HEIGHTF - hills->height }, (vec2) { DISPLAY_WIDTHF, hills->height }, 0.0f, hillsUv, GLM_VEC4_ONE);
+    SpriteBatch_flush(&batch, hills->texId);
+    SpriteBatch_free(&batch);
+}
+
+// The sky (bc1) and the hills (bc3) as texconv wrote them. A texture that fell
+// back to its png shows up here, it doesn't have the block artifacts
+static void renderCompressed(int arg) {
+    Texture_t sky = DW_loadTexture("assets/sky.dwtx");
+    Texture_t hills = DW_loadTexture("assets/hills.dwtx");
+    drawBackdrop(&sky, &hills);
+    DW_freeTexture(&sky);
+    DW_freeTexture(&hills);
+}
+
+// The sky container and the hills png through the streamer, with a budget small enough
+// that both go up in bands over several frames. The png is decoded and mipmapped on a worker
+static void renderTextureStream(int arg) {
+    TextureStream_setBudget(64u << 10);
+    StreamedTexture_t *sky = TextureStream_load("assets/sky.dwtx");
+    StreamedTexture_t *hills = TextureStream_load("assets/hills.png");
+    finishTextureStreams();
+    TextureStream_setBudget(TEXTURE_STREAM_DEFAULT_BUDGET);
+
+    if (!TextureStream_isReady(sky) || !TextureStream_isReady(hills)) {
+        fprintf(stderr, "Error: Streamed textures failed to load\n");
+    }
+    drawBackdrop(TextureStream_texture(sky), TextureStream_texture(hills));
+
+    TextureStream_release(sky);
+    TextureStream_release(hills);
+    TextureStream_update();
+}
+
+static const GoldenCase_t goldenCases[] = {
+    { "menu", DISPLAY_WIDTH, DISPLAY_HEIGHT, setupMenu, renderScene, 0 },
+    { "world_000", DISPLAY_WIDTH, DISPLAY_HEIGHT, setupWorld, renderScene, 0 },
+    { "world_030", DISPLAY_WIDTH, DISPLAY_HEIGHT, setupWorld, renderScene, 30 },
+    { "world_090", DISPLAY_WIDTH, DISPLAY_HEIGHT, setupWorld, renderScene, 90 },
+    { "font", DISPLAY_WIDTH, DISPLAY_HEIGHT, NULL, renderFont, 0 },
+    { "sprites", DISPLAY_WIDTH, DISPLAY_HEIGHT, NULL, renderSprites, 0 },
+    { "texpool", DISPLAY_WIDTH, DISPLAY_HEIGHT, NULL, renderTexturePool, 0 },
+    { "compressed", DISPLAY_WIDTH, DISPLAY_HEIGHT, NULL, renderCompressed, 0 },
+    { "texstream", DISPLAY_WIDTH, DISPLAY_HEIGHT, NULL, renderTextureStream, 0 },
+    { "format_pc", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_PC },
+    { "format_pt", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_PT },
+    { "format_pct", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_PCT },
+    { "format_p2c8", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_P2C8 },
+    { "format_s16c8", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_S16C8 },
+    { "format_p2t16", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_P2T16 },
+    { "format_p2c8t16", FORMAT_SIZE, FORMAT_SIZE, NULL, renderFormat, VERTEX_FORMAT_P2C8T16 }
+};
+#define GOLDEN_CASE_COUNT (sizeof(goldenCases) / sizeof(goldenCases[0]))
+
+// Marks every pixel past the tolerance red in diff, over a dimmed copy of the reference
+static GoldenDiff_t compareImages(const uint8_t *expected, const uint8_t *actual, size_t pixelCount, uint8_t *diff) {
+    GoldenDiff_t result = { 0 };
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint32_t delta = 0;
+        for (int c = 0; c < 4; c++) {
+            uint32_t d = abs(expected[i * 4 + c] - actual[i * 4 + c]);
+            if (d > delta) delta = d;
+        }
+        if (delta > result.maxDelta) result.maxDelta = delta;
+
+        bool failed = delta > GOLDEN_CHANNEL_TOLERANCE;
+        if (failed) result.failedPixels++;
+        for (int c = 0; c < 3; c++) {
+            diff[i * 4 + c] = failed ? (c == 0 ? 255 : 0) : expected[i * 4 + c] / 4;
+        }
+        diff[i * 4 + 3] = 255;
+    }
+    return result;
+}
+
+static bool isSelected(const char *name, char **names, int nameCount) {
+    if (nameCount == 0) return true;
+    for (int i = 0; i < nameCount; i++) {
+        if (strcmp(names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    bool update = false;
+    const char *timingsPath = NULL;
+    char **names = malloc(argc * sizeof(char*));
+    int nameCount = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-u") == 0) update = true;
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) timingsPath = argv[++i];
+        else names[nameCount++] = argv[i];
+    }
+
+    if (!initContext()) return 1;
+    initGame();
+
+    FILE *timings = NULL;
+    if (timingsPath != NULL) {
+        timings = fopen(timingsPath, "w");
+        if (timings == NULL) fprintf(stderr, "Error: Couldn't open %s\n", timingsPath);
+        else fprintf(timings, "case,ms,result\n");
+    }
+
+    // the references are top down, flipped on load like every other texture
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    uint32_t failures = 0;
+    for (size_t c = 0; c < GOLDEN_CASE_COUNT; c++) {
+        const GoldenCase_t *test = &goldenCases[c];
+        if (!isSelected(test->name, names, nameCount)) continue;
+
+        size_t pixelCount = (size_t) test->width * test->height;
+        uint8_t *actual = malloc(pixelCount * 4);
+
+        bindFramebuffer(test->width, test->height);
+        // the ones without a setup get a frame first, so shader compiles don't end up in the timing
+        if (test->setup != NULL) test->setup(test->arg);
+        else test->render(test->arg);
+        glFinish();
+        uint64_t start = DW_currentTimeNanos();
+        test->render(test->arg);
+        glFinish();
+        float ms = (DW_currentTimeNanos() - start) / 1e6f;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_m);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, test->width, test->height, GL_RGBA, GL_UNSIGNED_BYTE, actual);
+        Resources_endFrame();
+        FrameArena_endFrame();
+
+        char path[256];
+        snprintf(path, sizeof(path), GOLDEN_DIR "/%s.png", test->name);
+        const char *result;
+        GoldenDiff_t diff = { 0 };
+
+        if (update) {
+            result = Png_write(path, test->width, test->height, actual) ? "wrote" : "FAIL";
+        } else {
+            int width, height, channels;
+            uint8_t *expected = stbi_load(path, &width, &height, &channels, 4);
+            if (expected == NULL || width != test->width || height != test->height) {
+                fprintf(stderr, "Error: No usable reference at %s, run with -u to make one\n", path);
+                result = "FAIL";
+            } else {
+                uint8_t *diffImage = malloc(pixelCount * 4);
+                diff = compareImages(expected, actual, pixelCount, diffImage);
+                bool passed = (uint64_t) diff.failedPixels * 1000000 <= (uint64_t) pixelCount * GOLDEN_PIXEL_TOLERANCE;
+                result = passed ? "ok" : "FAIL";
+
+                if (!passed) {
+                    snprintf(path, sizeof(path), GOLDEN_DIR "/%s.actual.png", test->name);
+                    Png_write(path, test->width, test->height, actual);
+                    snprintf(path, sizeof(path), GOLDEN_DIR "/%s.diff.png", test->name);
+                    Png_write(path, test->width, test->height, diffImage);
+                }
+                free(diffImage);
+            }
+            stbi_image_free(expected);
+        }
+
+        if (strcmp(result, "FAIL") == 0) failures++;
+        printf("%-16s %-5s %9.2f ms  %u px off, max delta %u\n", test->name, result, ms, diff.failedPixels, diff.maxDelta);
+        if (timings != NULL) fprintf(timings, "%s,%.3f,%s\n", test->name, ms, result);
+        free(actual);
+    }
+
+    if (timings != NULL) fclose(timings);
+    free(names);
+    cleanupGame();
+    if (window != NULL) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+    printf("%u failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,264 @@
+#include "png.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WINDOW_SIZE 32768
+#define HASH_BITS 15
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+// how far down the hash chain we look, past this it's slower and barely smaller
+#define MAX_CHAIN 64
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    uint64_t bits;
+    uint32_t bitCount;
+} ByteWriter_t;
+
+static const uint16_t lengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void ByteWriter_reserve(ByteWriter_t *out, size_t extra) {
+    if (out->size + extra <= out->capacity) return;
+    while (out->size + extra > out->capacity) out->capacity = out->capacity ? out->capacity * 2 : 4096;
+    out->data = realloc(out->data, out->capacity);
+}
+
+static void ByteWriter_put(ByteWriter_t *out, const void *data, size_t size) {
+    ByteWriter_reserve(out, size);
+    memcpy(out->data + out->size, data, size);
+    out->size += size;
+}
+
+static void ByteWriter_put32(ByteWriter_t *out, uint32_t value) {
+    uint8_t be[4] = { value >> 24, value >> 16, value >> 8, value };
+    ByteWriter_put(out, be, 4);
+}
+
+// deflate packs from the least significant bit up
+static void ByteWriter_bits(ByteWriter_t *out, uint32_t value, uint32_t count) {
+    out->bits |= (uint64_t) value << out->bitCount;
+    out->bitCount += count;
+    while (out->bitCount >= 8) {
+        uint8_t byte = out->bits & 0xff;
+        ByteWriter_put(out, &byte, 1);
+        out->bits >>= 8;
+        out->bitCount -= 8;
+    }
+}
+
+static void ByteWriter_flushBits(ByteWriter_t *out) {
+    if (out->bitCount > 0) ByteWriter_bits(out, 0, 8 - out->bitCount);
+}
+
+// except for Huffman codes, those go most significant bit first
+static void ByteWriter_code(ByteWriter_t *out, uint32_t code, uint32_t length) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    }
+    ByteWriter_bits(out, reversed, length);
+}
+
+// the fixed literal/length code from the deflate spec
+static void writeLiteral(ByteWriter_t *out, uint32_t symbol) {
+    if (symbol < 144) ByteWriter_code(out, 0x30 + symbol, 8);
+    else if (symbol < 256) ByteWriter_code(out, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) ByteWriter_code(out, symbol - 256, 7);
+    else ByteWriter_code(out, 0xc0 + symbol - 280, 8);
+}
+
+static void writeMatch(ByteWriter_t *out, uint32_t length, uint32_t distance) {
+    int l = 28;
+    while (lengthBase[l] > length) l--;
+    writeLiteral(out, 257 + l);
+    ByteWriter_bits(out, length - lengthBase[l], lengthExtra[l]);
+
+    int d = 29;
+    while (distanceBase[d] > distance) d--;
+    ByteWriter_code(out, d, 5);
+    ByteWriter_bits(out, distance - distanceBase[d], distanceExtra[d]);
+}
+
+static uint32_t hash3(const uint8_t *p) {
+    return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void deflate(ByteWriter_t *out, const uint8_t *data, size_t size) {
+    int32_t *head = malloc((1 << HASH_BITS) * sizeof(int32_t));
+    int32_t *prev = malloc(WINDOW_SIZE * sizeof(int32_t));
+    memset(head, 0xff, (1 << HASH_BITS) * sizeof(int32_t));
+
+    // one final block with the fixed codes
+    ByteWriter_bits(out, 1, 1);
+    ByteWriter_bits(out, 1, 2);
+
+    size_t pos = 0;
+    while (pos < size) {
+        uint32_t bestLength = 0;
+        uint32_t bestDistance = 0;
+
+        if (pos + MIN_MATCH <= size) {
+            uint32_t h = hash3(data + pos);
+            size_t maxLength = size - pos < MAX_MATCH ? size - pos : MAX_MATCH;
+            int32_t candidate = head[h];
+            for (int chain = 0; candidate >= 0 && chain < MAX_CHAIN; chain++) {
+                size_t distance = pos - candidate;
+                if (distance > WINDOW_SIZE - 1) break;
+
+                uint32_t length = 0;
+                while (length < maxLength && data[candidate + length] == data[pos + length]) length++;
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = distance;
+                    if (length == maxLength) break;
+                }
+                candidate = prev[candidate & (WINDOW_SIZE - 1)];
+            }
+        }
+
+        size_t advance = bestLength >= MIN_MATCH ? bestLength : 1;
+        if (bestLength >= MIN_MATCH) writeMatch(out, bestLength, bestDistance);
+        else writeLiteral(out, data[pos]);
+
+        // everything we skip over still goes in the chains
+        for (size_t i = 0; i < advance; i++, pos++) {
+            if (pos + MIN_MATCH > size) continue;
+            uint32_t h = hash3(data + pos);
+            prev[pos & (WINDOW_SIZE - 1)] = head[h];
+            head[h] = (int32_t) pos;
+        }
+    }
+
+    writeLiteral(out, 256);
+    ByteWriter_flushBits(out);
+    free(head);
+    free(prev);
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size) {
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t size) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return b << 16 | a;
+}
+
+static void writeChunk(ByteWriter_t *out, const char *type, const uint8_t *data, size_t size) {
+    ByteWriter_put32(out, (uint32_t) size);
+    size_t start = out->size;
+    ByteWriter_put(out, type, 4);
+    if (size > 0) ByteWriter_put(out, data, size);
+    ByteWriter_put32(out, crc32(0, out->data + start, size + 4));
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Filters one row every way and keeps the one with the smallest sum, the usual heuristic
+static void filterRow(const uint8_t *row, const uint8_t *above, size_t rowSize, uint8_t *out) {
+    uint8_t *candidate = malloc(rowSize);
+    uint64_t bestCost = UINT64_MAX;
+
+    for (uint8_t filter = 0; filter < 5; filter++) {
+        uint64_t cost = 0;
+        for (size_t i = 0; i < rowSize; i++) {
+            int a = i >= 4 ? row[i - 4] : 0;
+            int b = above != NULL ? above[i] : 0;
+            int c = i >= 4 && above != NULL ? above[i - 4] : 0;
+            uint8_t predicted = 0;
+            switch (filter) {
+                case 1: predicted = a; break;
+                case 2: predicted = b; break;
+                case 3: predicted = (a + b) / 2; break;
+                case 4: predicted = paeth(a, b, c); break;
+            }
+            candidate[i] = row[i] - predicted;
+            cost += abs((int8_t) candidate[i]);
+        }
+
+        if (cost < bestCost) {
+            bestCost = cost;
+            out[0] = filter;
+            memcpy(out + 1, candidate, rowSize);
+        }
+    }
+
+    free(candidate);
+}
+
+bool Png_write(const char *path, uint32_t width, uint32_t height, const uint8_t *rgba) {
+    size_t rowSize = (size_t) width * 4;
+    size_t rawSize = (rowSize + 1) * height;
+    uint8_t *raw = malloc(rawSize);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t *row = rgba + (height - 1 - y) * rowSize;
+        const uint8_t *above = y > 0 ? row + rowSize : NULL;
+        filterRow(row, above, rowSize, raw + y * (rowSize + 1));
+    }
+
+    ByteWriter_t zlib = { 0 };
+    // deflate with a 32K window, no preset dictionary
+    ByteWriter_put(&zlib, (uint8_t[]) { 0x78, 0x01 }, 2);
+    deflate(&zlib, raw, rawSize);
+    ByteWriter_put32(&zlib, adler32(raw, rawSize));
+    free(raw);
+
+    ByteWriter_t png = { 0 };
+    ByteWriter_put(&png, (uint8_t[]) { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' }, 8);
+    uint8_t header[13] = {
+        width >> 24, width >> 16, width >> 8, width,
+        height >> 24, height >> 16, height >> 8, height,
+        // 8 bits per channel, rgba, deflate, adaptive filtering, no interlace
+        8, 6, 0, 0, 0
+    };
+    writeChunk(&png, "IHDR", header, sizeof(header));
+    writeChunk(&png, "IDAT", zlib.data, zlib.size);
+    writeChunk(&png, "IEND", NULL, 0);
+    free(zlib.data);
+
+    FILE *file = fopen(path, "wb");
+    bool written = file != NULL && fwrite(png.data, 1, png.size, file) == png.size;
+    if (file != NULL) written &= fclose(file) == 0;
+    if (!written) fprintf(stderr, "Error: Couldn't write %s\n", path);
+
+    free(png.data);
+    return written;
+}
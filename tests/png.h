@@ -0,0 +1,17 @@
+#ifndef PNG_H
+#define PNG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Just enough of a PNG encoder for the golden images: 8 bit RGBA, each row gets
+ * whichever filter makes it smallest, then one fixed Huffman deflate block with
+ * a hash chain matcher. Nowhere near zlib -9, but flat game frames squash well
+ * enough that the references can live in git. Reading goes through stb_image.
+ */
+
+// Rows are bottom up like glReadPixels gives them, the file comes out top down
+bool Png_write(const char *path, uint32_t width, uint32_t height, const uint8_t *rgba);
+
+#endif
@@ -0,0 +1,689 @@
+/**
+ * Unit tests for the engine code that doesn't need a GL context, checked against
+ * plain reference versions of the same thing.
+ *
+ * usage: DeltaWingTests [-b] [test...]
+ *   -b  run the benchmarks instead of the tests
+ *   only the named tests (or benchmarks) run if any are given
+ *
+ * A failing test prints the check that failed and the line it's on.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#define DEFINE_GLOBALS
+#include "../src/globals.h"
+
+#include "../src/util.h"
+#include "../src/rng.h"
+#include "../src/physics.h"
+#include "../src/collision.h"
+#include "../src/culling.h"
+#include "../src/atlas.h"
+#include "../src/arena.h"
+#include "../src/memory.h"
+#include "../src/jobs.h"
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "  %s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+typedef struct {
+    const char *name;
+    bool (*run)();
+} UnitTest_t;
+
+GLFWwindow *window;
+
+void DW_exitGame() {
+
+}
+
+void DW_setScene(Scene_t *scene) {
+    currentScene = scene;
+}
+
+// objects per physics benchmark tick, and the most one tick of them may take
+#define PHYSICS_BENCH_COUNT 100000
+#define PHYSICS_BENCH_TARGET_MS 1.0f
+#define PHYSICS_BENCH_TICKS 200
+
+static const PhysicsParams_t testPhysics_m = {
+    .gravity = { 0.0f, -0.8f },
+    .terminalVelocity = { 0.0f, 12.0f },
+    .maxVelocity = { 6.0f, 16.0f }
+};
+
+// spread around the thresholds, so every branch of the step gets both sides
+static void randomObjects(GameObj_t *objs, size_t count, uint64_t seed) {
+    Pcg32_t rng;
+    Pcg32_init(&rng, seed, 0);
+    for (size_t i = 0; i < count; i++) {
+        for (int a = 0; a < 2; a++) {
+            objs[i].pos[a] = Pcg32_range(&rng, -1000.0f, 1000.0f);
+            objs[i].prevPos[a] = Pcg32_range(&rng, -1000.0f, 1000.0f);
+            objs[i].velocity[a] = Pcg32_range(&rng, -20.0f, 20.0f);
+        }
+        // exactly on them too
+        switch (i % 5) {
+        case 1: objs[i].velocity[1] = -testPhysics_m.terminalVelocity[1]; break;
+        case 2: objs[i].velocity[0] = testPhysics_m.maxVelocity[0]; break;
+        case 3: objs[i].velocity[1] = -testPhysics_m.maxVelocity[1]; break;
+        case 4: objs[i].velocity[0] = -0.0f; break;
+        }
+    }
+}
+
+// The SIMD path has to give the exact bits of the scalar one, for counts that hit every tail
+static bool testPhysicsMatchesScalar() {
+    size_t counts[] = { 1, 2, 3, 7, 16, 17, 1001 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t count = counts[c];
+        GameObj_t *simd = malloc(count * sizeof(GameObj_t));
+        GameObj_t *scalar = malloc(count * sizeof(GameObj_t));
+        randomObjects(simd, count, 1234 + c);
+        memcpy(scalar, simd, count * sizeof(GameObj_t));
+
+        // a few ticks, so clamped and terminal velocities come through again
+        bool same = true;
+        for (int tick = 0; tick < 8 && same; tick++) {
+            Physics_integrate(simd, count, &testPhysics_m);
+            Physics_integrateScalar(scalar, count, &testPhysics_m);
+            same = memcmp(simd, scalar, count * sizeof(GameObj_t)) == 0;
+        }
+        free(simd);
+        free(scalar);
+        EXPECT(same);
+    }
+    return true;
+}
+
+// Closed boxes: edges count, a ray along one hits, a zero length ray hits only from inside
+static bool testRaycast() {
+    Rect_t rect = { { 10.0f, 20.0f }, { 30.0f, 40.0f } };
+    float t = -1.0f;
+
+    EXPECT(Rect_raycast(&rect, (vec2) { 0.0f, 30.0f }, (vec2) { 20.0f, 0.0f }, &t) && t == 0.5f);
+    EXPECT(Rect_raycast(&rect, (vec2) { 50.0f, 70.0f }, (vec2) { -20.0f, -20.0f }, &t) && t == 0.5f);
+    EXPECT(!Rect_raycast(&rect, (vec2) { 0.0f, 30.0f }, (vec2) { 5.0f, 0.0f }, &t));
+    EXPECT(!Rect_raycast(&rect, (vec2) { 0.0f, 0.0f }, (vec2) { 0.0f, 100.0f }, &t));
+
+    // edge on, along the bottom and right edges, and just outside them
+    EXPECT(Rect_raycast(&rect, (vec2) { 2.0f, 20.0f }, (vec2) { 32.0f, 0.0f }, &t) && t == 0.25f);
+    EXPECT(Rect_raycast(&rect, (vec2) { 40.0f, 4.0f }, (vec2) { 0.0f, 64.0f }, &t) && t == 0.25f);
+    EXPECT(!Rect_raycast(&rect, (vec2) { 2.0f, 19.99f }, (vec2) { 32.0f, 0.0f }, &t));
+    EXPECT(!Rect_raycast(&rect, (vec2) { 40.01f, 4.0f }, (vec2) { 0.0f, 64.0f }, &t));
+    // through the corner only
+    EXPECT(Rect_raycast(&rect, (vec2) { 0.0f, 10.0f }, (vec2) { 20.0f, 20.0f }, &t) && t == 0.5f);
+
+    // zero length, inside, on an edge and outside
+    EXPECT(Rect_raycast(&rect, (vec2) { 15.0f, 25.0f }, GLM_VEC2_ZERO, &t) && t == 0.0f);
+    EXPECT(Rect_raycast(&rect, (vec2) { 10.0f, 60.0f }, GLM_VEC2_ZERO, &t) && t == 0.0f);
+    EXPECT(!Rect_raycast(&rect, (vec2) { 5.0f, 25.0f }, GLM_VEC2_ZERO, &t));
+
+    // starting inside hits straight away
+    EXPECT(Rect_raycast(&rect, (vec2) { 15.0f, 25.0f }, (vec2) { 100.0f, 0.0f }, &t) && t == 0.0f);
+    return true;
+}
+
+static int compareHits(const void *a, const void *b) {
+    const CollisionHit_t *hitA = a;
+    const CollisionHit_t *hitB = b;
+    return hitA->index < hitB->index ? -1 : hitA->index > hitB->index;
+}
+
+#define SEGMENT_TEST_RECTS 300
+#define SEGMENT_TEST_QUERIES 2000
+
+// Segment queries have to find exactly what testing every box would, cell edges and all
+static bool testSegmentQuery() {
+    Pcg32_t rng;
+    Pcg32_init(&rng, 42, 0);
+
+    // on a 16 unit lattice some of the time, so boxes and rays land on cell edges
+    Rect_t rects[SEGMENT_TEST_RECTS];
+    for (int i = 0; i < SEGMENT_TEST_RECTS; i++) {
+        bool snapped = i % 3 == 0;
+        for (int a = 0; a < 2; a++) {
+            rects[i].pos[a] = snapped ? Pcg32_nextBounded(&rng, 64) * 16.0f - 512.0f : Pcg32_range(&rng, -512.0f, 512.0f);
+            rects[i].size[a] = snapped ? Pcg32_nextBounded(&rng, 8) * 16.0f : Pcg32_range(&rng, 0.0f, 100.0f);
+        }
+    }
+
+    SpatialHash_t hash;
+    SpatialHash_init(&hash, 64.0f, SEGMENT_TEST_RECTS);
+    SpatialHash_build(&hash, rects, SEGMENT_TEST_RECTS);
+
+    CollisionHitArray_t hits;
+    CollisionHitArray_init(&hits, 16);
+    CollisionHit_t *expected = malloc(SEGMENT_TEST_RECTS * sizeof(CollisionHit_t));
+
+    bool same = true;
+    for (int q = 0; q < SEGMENT_TEST_QUERIES && same; q++) {
+        vec2 origin, delta;
+        bool snapped = q % 4 == 0;
+        for (int a = 0; a < 2; a++) {
+            origin[a] = snapped ? Pcg32_nextBounded(&rng, 64) * 16.0f - 512.0f : Pcg32_range(&rng, -600.0f, 600.0f);
+            delta[a] = snapped ? Pcg32_nextBounded(&rng, 32) * 16.0f - 256.0f : Pcg32_range(&rng, -400.0f, 400.0f);
+        }
+        // axis aligned and zero length ones too
+        if (q % 5 == 1) delta[0] = 0.0f;
+        if (q % 5 == 2) delta[1] = 0.0f;
+        if (q % 7 == 3) glm_vec2_zero(delta);
+
+        uint32_t expectedCount = 0;
+        for (uint32_t i = 0; i < SEGMENT_TEST_RECTS; i++) {
+            float t;
+            if (Rect_raycast(&rects[i], origin, delta, &t)) expected[expectedCount++] = (CollisionHit_t) { i, t };
+        }
+
+        SpatialHash_querySegment(&hash, origin, delta, &hits);
+        qsort(hits.ptr, hits.size, sizeof(CollisionHit_t), compareHits);
+        same = hits.size == expectedCount && memcmp(hits.ptr, expected, expectedCount * sizeof(CollisionHit_t)) == 0;
+        if (!same) {
+            fprintf(stderr, "  segment (%g, %g) + (%g, %g): %u hits, %u expected\n",
+                origin[0], origin[1], delta[0], delta[1], hits.size, expectedCount);
+        }
+    }
+
+    free(expected);
+    CollisionHitArray_free(&hits);
+    SpatialHash_free(&hash);
+    EXPECT(same);
+    return true;
+}
+
+static int compareU32(const void *a, const void *b) {
+    uint32_t ua = *(const uint32_t*) a;
+    uint32_t ub = *(const uint32_t*) b;
+    return ua < ub ? -1 : ua > ub;
+}
+
+#define CULL_TEST_RECTS 500
+#define CULL_TEST_VIEWS 500
+
+// The grid has to let through exactly what testing every box does, in any order. Boxes hang
+// off the grid on every side and the views go past it, so the clamped border cells get used
+static bool testCullGrid() {
+    Pcg32_t rng;
+    Pcg32_init(&rng, 7, 0);
+
+    CullBounds_t bounds;
+    CullBounds_init(&bounds, 16);
+    for (int i = 0; i < CULL_TEST_RECTS; i++) {
+        // mostly small, some as big as a few cells
+        float maxSize = i % 10 == 0 ? 600.0f : 60.0f;
+        Rect_t rect = {
+            { Pcg32_range(&rng, -300.0f, 1300.0f), Pcg32_range(&rng, -300.0f, 1300.0f) },
+            { Pcg32_range(&rng, 0.0f, maxSize), Pcg32_range(&rng, 0.0f, maxSize) }
+        };
+        CullBounds_add(&bounds, &rect);
+    }
+
+    CullGrid_t grid;
+    CullGrid_init(&grid, GLM_VEC2_ZERO, 100.0f, 10, 10);
+
+    uint32_t *expected = malloc(CULL_TEST_RECTS * sizeof(uint32_t));
+    uint32_t *actual = malloc(CULL_TEST_RECTS * sizeof(uint32_t));
+
+    bool same = true;
+    for (int v = 0; v < CULL_TEST_VIEWS && same; v++) {
+        // moved around like the world moves it, the answer can't depend on where the grid is
+        if (v % 100 == 0) {
+            grid.origin[0] = Pcg32_range(&rng, -200.0f, 200.0f);
+            grid.origin[1] = Pcg32_range(&rng, -200.0f, 200.0f);
+            CullGrid_build(&grid, &bounds);
+        }
+
+        Rect_t view = {
+            { Pcg32_range(&rng, -600.0f, 1400.0f), Pcg32_range(&rng, -600.0f, 1400.0f) },
+            { Pcg32_range(&rng, 1.0f, 800.0f), Pcg32_range(&rng, 1.0f, 800.0f) }
+        };
+
+        CullStats_t expectedStats, actualStats;
+        uint32_t expectedCount = Cull_rects(&bounds, &view, expected, &expectedStats);
+        uint32_t actualCount = CullGrid_query(&grid, &view, actual, &actualStats);
+        qsort(actual, actualCount, sizeof(uint32_t), compareU32);
+
+        same = actualCount == expectedCount && memcmp(actual, expected, expectedCount * sizeof(uint32_t)) == 0
+            && actualStats.visible == expectedStats.visible && actualStats.culled == expectedStats.culled;
+        if (!same) {
+            fprintf(stderr, "  view (%g, %g) %gx%g: %u visible, %u expected\n",
+                view.pos[0], view.pos[1], view.size[0], view.size[1], actualCount, expectedCount);
+        }
+    }
+
+    free(expected);
+    free(actual);
+    CullGrid_free(&grid);
+    CullBounds_free(&bounds);
+    EXPECT(same);
+    return true;
+}
+
+#define ATLAS_TEST_IMAGES 40
+#define ATLAS_TEST_PAGE 128
+#define ATLAS_TEST_PADDING 4
+
+// Every texel of an image is its own colour, so a copy in the wrong place shows up
+static void atlasTexel(uint32_t image, int x, int y, uint8_t *out) {
+    out[0] = (uint8_t) image;
+    out[1] = (uint8_t) x;
+    out[2] = (uint8_t) y;
+    out[3] = 255;
+}
+
+// Packs more than a page holds plus one image too wide for any page, then checks
+// where everything went against the images it came from
+static bool testAtlasPack() {
+    Pcg32_t rng;
+    Pcg32_init(&rng, 11, 0);
+
+    Atlas_t atlas;
+    Atlas_init(&atlas, ATLAS_TEST_PAGE, ATLAS_TEST_PADDING);
+    Image_t images[ATLAS_TEST_IMAGES + 1];
+    for (uint32_t i = 0; i <= ATLAS_TEST_IMAGES; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "image %u", i);
+        Atlas_add(&atlas, name);
+
+        bool tooWide = i == ATLAS_TEST_IMAGES;
+        images[i].width = tooWide ? ATLAS_TEST_PAGE : 4 + (int) Pcg32_nextBounded(&rng, 37);
+        images[i].height = 4 + (int) Pcg32_nextBounded(&rng, 37);
+        images[i].channels = 4;
+        images[i].pixels = malloc((size_t) images[i].width * images[i].height * 4);
+        for (int y = 0; y < images[i].height; y++) {
+            for (int x = 0; x < images[i].width; x++) {
+                atlasTexel(i, x, y, images[i].pixels + ((size_t) y * images[i].width + x) * 4);
+            }
+        }
+    }
+
+    Image_t pages[ATLAS_MAX_PAGES];
+    uint32_t pageCount = 0;
+    bool allPlaced = Atlas_pack(&atlas, images, pages, &pageCount);
+
+    // the wide one plus its gutter is past the page, it's the only one left out
+    EXPECT(!allPlaced);
+    EXPECT(Atlas_region(&atlas, ATLAS_TEST_IMAGES)->page == -1);
+    EXPECT(pageCount > 1 && pageCount <= ATLAS_MAX_PAGES);
+
+    int pad = ATLAS_TEST_PADDING;
+    bool ok = true;
+    for (uint32_t i = 0; i < ATLAS_TEST_IMAGES && ok; i++) {
+        const AtlasRegion_t *region = Atlas_region(&atlas, i);
+        const Image_t *page = &pages[region->page];
+        int x0 = (int) region->x;
+        int y0 = (int) region->y;
+        int width = images[i].width;
+        int height = images[i].height;
+
+        // in the page with the gutter, mip aligned, and the uvs land on the same texels
+        ok = region->page >= 0 && (int) region->width == width && (int) region->height == height
+            && x0 >= pad && y0 >= pad && x0 + width + pad <= page->width && y0 + height + pad <= page->height
+            && x0 % pad == 0 && y0 % pad == 0
+            && region->uv[0] * page->width == x0 && region->uv[1] * page->height == y0
+            && region->uv[2] * page->width == x0 + width && region->uv[3] * page->height == y0 + height;
+        if (!ok) {
+            fprintf(stderr, "  image %u: %dx%d at (%d, %d) on page %d\n", i, width, height, x0, y0, region->page);
+            break;
+        }
+
+        // the image itself, then the gutter repeating its edge texels
+        for (int y = -pad; y < height + pad && ok; y++) {
+            for (int x = -pad; x < width + pad && ok; x++) {
+                uint8_t expected[4];
+                atlasTexel(i, x < 0 ? 0 : x >= width ? width - 1 : x, y < 0 ? 0 : y >= height ? height - 1 : y, expected);
+                const uint8_t *actual = page->pixels + ((size_t) (y0 + y) * page->width + x0 + x) * 4;
+                ok = memcmp(actual, expected, 4) == 0;
+                if (!ok) fprintf(stderr, "  image %u: wrong texel at (%d, %d)\n", i, x, y);
+            }
+        }
+
+        // cells with their gutters never touch on the same page
+        for (uint32_t j = 0; j < i && ok; j++) {
+            const AtlasRegion_t *other = Atlas_region(&atlas, j);
+            if (other->page != region->page) continue;
+            ok = (int) other->x + (int) other->width + pad <= x0 - pad || x0 + width + pad <= (int) other->x - pad
+                || (int) other->y + (int) other->height + pad <= y0 - pad || y0 + height + pad <= (int) other->y - pad;
+            if (!ok) fprintf(stderr, "  images %u and %u overlap\n", j, i);
+        }
+    }
+
+    for (uint32_t p = 0; p < pageCount; p++) {
+        Memory_free(pages[p].pixels);
+    }
+    for (uint32_t i = 0; i <= ATLAS_TEST_IMAGES; i++) {
+        free(images[i].pixels);
+    }
+    Atlas_free(&atlas);
+    EXPECT(ok);
+    return true;
+}
+
+// Nested marks on an arena that's already spilling, each rewind gives back exactly
+// the spills made after its mark and the rest stay put
+static bool testArenaRewind() {
+    MemoryStats_t before, after;
+    Memory_getStats(MEMORY_TAG_ENGINE, &before);
+
+    Arena_t arena;
+    Arena_init(&arena, "test", 64);
+    Arena_alloc(&arena, 48);
+    void *kept = Arena_alloc(&arena, 100);
+
+    ArenaMark_t outer = Arena_mark(&arena);
+    Arena_alloc(&arena, 200);
+    ArenaMark_t inner = Arena_mark(&arena);
+    Arena_alloc(&arena, 300);
+    Arena_alloc(&arena, 400);
+    EXPECT(arena.spilled == 1000);
+
+    Arena_rewind(&arena, inner);
+    EXPECT(arena.spilled == 300 && arena.used == 48);
+    Arena_rewind(&arena, outer);
+    EXPECT(arena.spilled == 100 && arena.used == 48);
+    // the spill from before the marks is still ours
+    memset(kept, 0xAB, 100);
+
+    Memory_getStats(MEMORY_TAG_ENGINE, &after);
+    // the block and the one spill left
+    EXPECT(after.liveCount == before.liveCount + 2);
+
+    Arena_reset(&arena);
+    EXPECT(arena.spills == NULL && arena.spilled == 0 && arena.used == 0);
+    Arena_free(&arena);
+    Memory_getStats(MEMORY_TAG_ENGINE, &after);
+    EXPECT(after.liveCount == before.liveCount);
+    return true;
+}
+
+#define JOBS_TEST_ROUNDS 2000
+#define JOBS_TEST_COUNT 256
+
+static void addRange(void *data, uint32_t start, uint32_t end) {
+    __atomic_add_fetch((uint32_t*) data, end - start, __ATOMIC_RELAXED);
+}
+
+static void addOne(void *data) {
+    __atomic_add_fetch((uint32_t*) data, 1, __ATOMIC_RELAXED);
+}
+
+// A counter on the stack is gone the moment wait returns, a worker still holding its
+// lock would scribble over whatever the next round puts there
+static bool jobsRound(uint32_t *sum, uint32_t *chained) {
+    JobSystem_parallelFor(JOBS_TEST_COUNT, 8, addRange, sum);
+
+    JobCounter_t first = { 0 };
+    JobCounter_t second = { 0 };
+    for (int i = 0; i < 8; i++) {
+        JobSystem_run(addOne, chained, &first);
+    }
+    for (int i = 0; i < 8; i++) {
+        JobSystem_runAfter(&first, addOne, chained, &second);
+    }
+    JobSystem_wait(&second);
+    bool done = JobCounter_isDone(&first);
+
+    // reuse the memory straight away, as the next call's frame would
+    first.lock = 1;
+    second.lock = 1;
+    for (int i = 0; i < 4; i++) sched_yield();
+    return done && first.lock == 1 && second.lock == 1;
+}
+
+// parallelFor and runAfter over and over with stack counters, nothing touches them after done
+static bool testJobCounters() {
+    JobSystem_init(4);
+
+    uint32_t sum = 0;
+    uint32_t chained = 0;
+    bool untouched = true;
+    for (int r = 0; r < JOBS_TEST_ROUNDS && untouched; r++) {
+        untouched = jobsRound(&sum, &chained);
+    }
+    uint32_t rounds = untouched ? JOBS_TEST_ROUNDS : 0;
+
+    JobSystem_shutdown();
+    EXPECT(untouched);
+    EXPECT(sum == rounds * JOBS_TEST_COUNT);
+    EXPECT(chained == rounds * 16);
+    return true;
+}
+
+// Same seeds have to give the same numbers on every machine, the level is built from them
+static bool testRngDeterminism() {
+    // the reference outputs from the pcg and splitmix64 papers' code
+    Pcg32_t pcg;
+    Pcg32_init(&pcg, 42, 54);
+    uint32_t pcgExpected[] = { 0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e };
+    for (int i = 0; i < 6; i++) {
+        EXPECT(Pcg32_next(&pcg) == pcgExpected[i]);
+    }
+
+    uint64_t splitmix = 0;
+    EXPECT(Rng_splitmix64(&splitmix) == 0xe220a8397b1dcdafULL);
+
+    // and our own seeding on top, pinned so a change to it shows up here and not as a different level
+    Xoshiro128_t xoshiro;
+    Xoshiro128_init(&xoshiro, 12345);
+    uint32_t xoshiroExpected[] = { 0xc9c8548f, 0x11ca377a, 0x0c8942f1, 0x70439841 };
+    for (int i = 0; i < 4; i++) {
+        EXPECT(Xoshiro128_next(&xoshiro) == xoshiroExpected[i]);
+    }
+
+    Pcg32_init(&pcg, 2024, 0);
+    uint32_t boundedExpected[] = { 6, 2, 1, 7, 7, 9, 6, 7 };
+    for (int i = 0; i < 8; i++) {
+        EXPECT(Pcg32_nextBounded(&pcg, 10) == boundedExpected[i]);
+    }
+    return true;
+}
+
+#define RNG_TEST_STEPS 1001
+
+// Each lane is its own xoshiro128++ stream, a jump apart, whether or not it went through SIMD
+static bool testXoshiroLanes() {
+    uint64_t seed = 0x1234567890abcdefULL;
+    Xoshiro128x4_t rng4;
+    Xoshiro128x4_init(&rng4, seed);
+
+    Xoshiro128_t lanes[4];
+    Xoshiro128_init(&lanes[0], seed);
+    for (int l = 1; l < 4; l++) {
+        lanes[l] = lanes[l - 1];
+        Xoshiro128_jump(&lanes[l]);
+    }
+
+    // not a multiple of 4, so the tail path is checked too
+    float *batch = malloc(RNG_TEST_STEPS * sizeof(float));
+    Xoshiro128x4_fillFloat(&rng4, batch, RNG_TEST_STEPS, 0.0f, 1.0f);
+
+    bool same = true;
+    for (int i = 0; i < RNG_TEST_STEPS; i++) {
+        float expected = Xoshiro128_nextFloat(&lanes[i % 4]);
+        if (batch[i] != expected) same = false;
+    }
+    // the tail used a whole step of every lane, the next batch picks up after it
+    for (int l = RNG_TEST_STEPS % 4; l < 4; l++) {
+        Xoshiro128_nextFloat(&lanes[l]);
+    }
+    Xoshiro128x4_fillFloat(&rng4, batch, 8, 0.0f, 1.0f);
+    for (int i = 0; i < 8; i++) {
+        if (batch[i] != Xoshiro128_nextFloat(&lanes[i % 4])) same = false;
+    }
+
+    // and ranges stay inside [min, max)
+    Xoshiro128x4_fillFloat(&rng4, batch, RNG_TEST_STEPS, -5.0f, 3.0f);
+    bool inRange = true;
+    for (int i = 0; i < RNG_TEST_STEPS; i++) {
+        if (batch[i] < -5.0f || batch[i] >= 3.0f) inRange = false;
+    }
+
+    free(batch);
+    EXPECT(same);
+    EXPECT(inRange);
+    return true;
+}
+
+// The int fill is the same four streams, tail and follow-up batch included
+static bool testXoshiroLanesU32() {
+    uint64_t seed = 0xfeedface12345678ULL;
+    Xoshiro128x4_t rng4;
+    Xoshiro128x4_init(&rng4, seed);
+
+    Xoshiro128_t lanes[4];
+    Xoshiro128_init(&lanes[0], seed);
+    for (int l = 1; l < 4; l++) {
+        lanes[l] = lanes[l - 1];
+        Xoshiro128_jump(&lanes[l]);
+    }
+
+    uint32_t *batch = malloc(RNG_TEST_STEPS * sizeof(uint32_t));
+    Xoshiro128x4_fillU32(&rng4, batch, RNG_TEST_STEPS);
+
+    bool same = true;
+    for (int i = 0; i < RNG_TEST_STEPS; i++) {
+        if (batch[i] != Xoshiro128_next(&lanes[i % 4])) same = false;
+    }
+    for (int l = RNG_TEST_STEPS % 4; l < 4; l++) {
+        Xoshiro128_next(&lanes[l]);
+    }
+    Xoshiro128x4_fillU32(&rng4, batch, 8);
+    for (int i = 0; i < 8; i++) {
+        if (batch[i] != Xoshiro128_next(&lanes[i % 4])) same = false;
+    }
+
+    free(batch);
+    EXPECT(same);
+    return true;
+}
+
+#define BOUNDED_TEST_DRAWS 300000
+
+// Chi squared of draws against the same count in every bucket
+static double chiSquared(const uint32_t *counts, uint32_t buckets, uint32_t draws) {
+    double expected = (double) draws / buckets;
+    double sum = 0.0;
+    for (uint32_t b = 0; b < buckets; b++) {
+        double d = counts[b] - expected;
+        sum += d * d / expected;
+    }
+    return sum;
+}
+
+// Always below the bound, and uniform even where plain modulo would be badly off
+static bool testBoundedRng() {
+    Pcg32_t rng;
+    Pcg32_init(&rng, 99, 3);
+
+    uint32_t bounds[] = { 1, 2, 3, 7, 1000, 0x80000001u, 0xffffffffu };
+    for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+        for (int i = 0; i < 10000; i++) {
+            EXPECT(Pcg32_nextBounded(&rng, bounds[b]) < bounds[b]);
+        }
+    }
+    EXPECT(Pcg32_nextBounded(&rng, 0) == 0);
+
+    // a small bound, every value about as common as the others. 20.5 is p = 0.001 with 5 degrees
+    uint32_t dice[6] = { 0 };
+    for (int i = 0; i < BOUNDED_TEST_DRAWS; i++) {
+        dice[Pcg32_nextBounded(&rng, 6)]++;
+    }
+    EXPECT(chiSquared(dice, 6, BOUNDED_TEST_DRAWS) < 20.5);
+
+    // 3 * 2^30, where modulo would make the first third twice as likely as each of the others.
+    // 13.8 is p = 0.001 with 2 degrees
+    uint32_t thirds[3] = { 0 };
+    for (int i = 0; i < BOUNDED_TEST_DRAWS; i++) {
+        thirds[Pcg32_nextBounded(&rng, 0xc0000000u) >> 30]++;
+    }
+    EXPECT(chiSquared(thirds, 3, BOUNDED_TEST_DRAWS) < 13.8);
+    return true;
+}
+
+static const UnitTest_t unitTests[] = {
+    { "physics_simd", testPhysicsMatchesScalar },
+    { "raycast", testRaycast },
+    { "segment_query", testSegmentQuery },
+    { "cull_grid", testCullGrid },
+    { "atlas_pack", testAtlasPack },
+    { "arena_rewind", testArenaRewind },
+    { "jobs_counters", testJobCounters },
+    { "rng_determinism", testRngDeterminism },
+    { "rng_lanes", testXoshiroLanes },
+    { "rng_lanes_u32", testXoshiroLanesU32 },
+    { "rng_bounded", testBoundedRng }
+};
+#define UNIT_TEST_COUNT (sizeof(unitTests) / sizeof(unitTests[0]))
+
+static int compareFloats(const void *a, const void *b) {
+    float fa = *(const float*) a;
+    float fb = *(const float*) b;
+    return fa < fb ? -1 : fa > fb;
+}
+
+// PHYSICS_BENCH_COUNT objects, one tick at a time. Fails if the median tick is over target
+static bool benchPhysics() {
+    GameObj_t *objs = malloc(PHYSICS_BENCH_COUNT * sizeof(GameObj_t));
+    randomObjects(objs, PHYSICS_BENCH_COUNT, 99);
+
+    float ticks[PHYSICS_BENCH_TICKS];
+    for (int i = 0; i < PHYSICS_BENCH_TICKS; i++) {
+        uint64_t start = DW_currentTimeNanos();
+        Physics_integrate(objs, PHYSICS_BENCH_COUNT, &testPhysics_m);
+        ticks[i] = (DW_currentTimeNanos() - start) / 1e6f;
+    }
+    free(objs);
+
+    qsort(ticks, PHYSICS_BENCH_TICKS, sizeof(float), compareFloats);
+    float median = ticks[PHYSICS_BENCH_TICKS / 2];
+    printf("Physics: %d objects, min %.3f ms, p50 %.3f ms, max %.3f ms a tick\n",
+        PHYSICS_BENCH_COUNT, ticks[0], median, ticks[PHYSICS_BENCH_TICKS - 1]);
+    EXPECT(median < PHYSICS_BENCH_TARGET_MS);
+    return true;
+}
+
+static const UnitTest_t benchmarks[] = {
+    { "physics", benchPhysics }
+};
+#define BENCHMARK_COUNT (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static bool isSelected(const char *name, char **names, int nameCount) {
+    if (nameCount == 0) return true;
+    for (int i = 0; i < nameCount; i++) {
+        if (strcmp(names[i], name) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    bool bench = false;
+    char **names = malloc(argc * sizeof(char*));
+    int nameCount = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0) bench = true;
+        else names[nameCount++] = argv[i];
+    }
+
+    const UnitTest_t *tests = bench ? benchmarks : unitTests;
+    size_t testCount = bench ? BENCHMARK_COUNT : UNIT_TEST_COUNT;
+
+    uint32_t failures = 0;
+    for (size_t t = 0; t < testCount; t++) {
+        if (!isSelected(tests[t].name, names, nameCount)) continue;
+
+        bool passed = tests[t].run();
+        if (!passed) failures++;
+        printf("%-16s %s\n", tests[t].name, passed ? "ok" : "FAIL");
+    }
+
+    free(names);
+    printf("%u failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+/**
+ * Packs a directory into a single asset pack, see src/archive.h for the layout.
+ *
+ * usage: assetpack [-n] <output> <directory>
+ *   -n  store everything uncompressed
+ *
+ * Entries are named by their path relative to the working directory, so
+ * `assetpack assets.pak assets` stores assets/pc.vs.glsl as "assets/pc.vs.glsl",
+ * which is exactly what the game asks for.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../src/archive.h"
+
+// compressed entries have to be at least this much smaller to be worth the decode
+#define MIN_SAVINGS 8
+
+#define LZ4_MIN_MATCH 4
+// the format needs the last 5 bytes to be literals and the last match to start 12 before the end
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_LIMIT 12
+#define LZ4_HASH_BITS 14
+
+typedef struct {
+    char *path;
+    uint8_t *data;
+    uint32_t size;
+
+    uint8_t *packed;
+    uint32_t packedSize;
+
+    ArchiveEntry_t entry;
+} PackFile_t;
+
+typedef struct {
+    PackFile_t *ptr;
+    uint32_t size;
+    uint32_t capacity;
+} PackFileArray_t;
+
+static uint8_t* writeLength(uint8_t *op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t) length;
+    return op;
+}
+
+static uint8_t* writeSequence(uint8_t *op, const uint8_t *literals, size_t literalCount, size_t offset, size_t matchLen) {
+    uint8_t *token = op++;
+    *token = (uint8_t) ((literalCount >= 15 ? 15 : literalCount) << 4);
+    if (literalCount >= 15) op = writeLength(op, literalCount - 15);
+
+    memcpy(op, literals, literalCount);
+    op += literalCount;
+
+    // literals only for the final sequence
+    if (matchLen == 0) return op;
+
+    *op++ = (uint8_t) offset;
+    *op++ = (uint8_t) (offset >> 8);
+
+    size_t matchCode = matchLen - LZ4_MIN_MATCH;
+    *token |= (uint8_t) (matchCode >= 15 ? 15 : matchCode);
+    if (matchCode >= 15) op = writeLength(op, matchCode - 15);
+    return op;
+}
+
+static uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// Greedy LZ4 block compressor with a single hash table, plenty for text assets
+static size_t compressBlock(const uint8_t *src, size_t size, uint8_t *dst) {
+    int64_t table[1 << LZ4_HASH_BITS];
+    for (size_t i = 0; i < (1 << LZ4_HASH_BITS); i++) table[i] = -1;
+
+    uint8_t *op = dst;
+    size_t anchor = 0;
+    size_t i = 0;
+
+    if (size > LZ4_MATCH_LIMIT) {
+        size_t matchStartLimit = size - LZ4_MATCH_LIMIT;
+        size_t matchEndLimit = size - LZ4_LAST_LITERALS;
+
+        while (i < matchStartLimit) {
+            uint32_t h = (read32(src + i) * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            int64_t candidate = table[h];
+            table[h] = i;
+
+            if (candidate < 0 || i - candidate > 65535 || read32(src + candidate) != read32(src + i)) {
+                i++;
+                continue;
+            }
+
+            size_t matchLen = LZ4_MIN_MATCH;
+            while (i + matchLen < matchEndLimit && src[candidate + matchLen] == src[i + matchLen]) matchLen++;
+
+            op = writeSequence(op, src + anchor, i - anchor, i - candidate, matchLen);
+            i += matchLen;
+            anchor = i;
+        }
+    }
+
+    op = writeSequence(op, src + anchor, size - anchor, 0, 0);
+    return op - dst;
+}
+
+static void addFile(PackFileArray_t *files, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Couldn't open %s\n", path);
+        exit(1);
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    if (fread(data, 1, size, file) != (size_t) size) {
+        fprintf(stderr, "Error: Couldn't read %s\n", path);
+        exit(1);
+    }
+    fclose(file);
+
+    if (files->size == files->capacity) {
+        files->capacity = files->capacity ? files->capacity * 2 : 32;
+        files->ptr = realloc(files->ptr, files->capacity * sizeof(PackFile_t));
+    }
+
+    PackFile_t *pf = &files->ptr[files->size++];
+    memset(pf, 0, sizeof(PackFile_t));
+    pf->path = strdup(path);
+    pf->data = data;
+    pf->size = (uint32_t) size;
+}
+
+static void addDirectory(PackFileArray_t *files, const char *dirPath, const char *packPath) {
+    DIR *dir = opendir(dirPath);
+    if (dir == NULL) {
+        fprintf(stderr, "Error: Couldn't open directory %s\n", dirPath);
+        exit(1);
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.') continue;
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dirPath, ent->d_name);
+
+        struct stat st;
+        if (stat(path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            addDirectory(files, path, packPath);
+        } else if (S_ISREG(st.st_mode)) {
+            // don't pack the pack into itself when it's written inside the directory
+            if (strcmp(ent->d_name, packPath) == 0) continue;
+            addFile(files, path);
+        }
+    }
+    closedir(dir);
+}
+
+static int compareEntries(const void *a, const void *b) {
+    const PackFile_t *fa = a;
+    const PackFile_t *fb = b;
+    if (fa->entry.hash != fb->entry.hash) return fa->entry.hash < fb->entry.hash ? -1 : 1;
+    return strcmp(fa->path, fb->path);
+}
+
+static uint64_t alignUp(uint64_t value) {
+    return (value + ARCHIVE_ALIGNMENT - 1) & ~(uint64_t) (ARCHIVE_ALIGNMENT - 1);
+}
+
+int main(int argc, char **argv) {
+    bool compress = true;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-n") == 0) {
+        compress = false;
+        arg++;
+    }
+
+    if (argc - arg != 2) {
+        fprintf(stderr, "usage: assetpack [-n] <output> <directory>\n");
+        return 1;
+    }
+
+    const char *outPath = argv[arg];
+    const char *dirPath = argv[arg + 1];
+    const char *outName = strrchr(outPath, '/') ? strrchr(outPath, '/') + 1 : outPath;
+
+    PackFileArray_t files = { 0 };
+    addDirectory(&files, dirPath, outName);
+
+    uint32_t namesSize = 0;
+    for (uint32_t i = 0; i < files.size; i++) {
+        PackFile_t *pf = &files.ptr[i];
+        pf->entry.hash = Archive_hash(pf->path);
+        pf->entry.size = pf->size;
+
+        if (compress && pf->size > 0) {
+            pf->packed = malloc(pf->size + pf->size / 255 + 16);
+            pf->packedSize = compressBlock(pf->data, pf->size, pf->packed);
+
+            // round trip it so a compressor bug can't ship
+            uint8_t *check = malloc(pf->size);
+            if (!Archive_decompress(pf->packed, pf->packedSize, check, pf->size) || memcmp(check, pf->data, pf->size) != 0) {
+                fprintf(stderr, "Error: Compressing %s didn't round trip\n", pf->path);
+                return 1;
+            }
+            free(check);
+
+            if (pf->packedSize + pf->size / MIN_SAVINGS <= pf->size) {
+                pf->entry.flags |= ARCHIVE_ENTRY_COMPRESSED;
+                pf->entry.packedSize = pf->packedSize;
+            }
+        }
+        if (!(pf->entry.flags & ARCHIVE_ENTRY_COMPRESSED)) pf->entry.packedSize = pf->size;
+
+        namesSize += strlen(pf->path) + 1;
+    }
+
+    // same input always gives the same file
+    qsort(files.ptr, files.size, sizeof(PackFile_t), compareEntries);
+
+    ArchiveHeader_t header = { .version = ARCHIVE_VERSION, .entryCount = files.size, .namesSize = namesSize };
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+
+    uint32_t nameOffset = 0;
+    uint64_t offset = alignUp(sizeof(ArchiveHeader_t) + (uint64_t) files.size * sizeof(ArchiveEntry_t) + namesSize);
+    for (uint32_t i = 0; i < files.size; i++) {
+        PackFile_t *pf = &files.ptr[i];
+        pf->entry.nameOffset = nameOffset;
+        nameOffset += strlen(pf->path) + 1;
+
+        pf->entry.offset = offset;
+        // stored entries get a zero byte after them so they can be used as strings in place
+        offset = alignUp(offset + pf->entry.packedSize + 1);
+    }
+
+    FILE *out = fopen(outPath, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Couldn't open %s for writing\n", outPath);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, out);
+    for (uint32_t i = 0; i < files.size; i++) {
+        fwrite(&files.ptr[i].entry, sizeof(ArchiveEntry_t), 1, out);
+    }
+    for (uint32_t i = 0; i < files.size; i++) {
+        fwrite(files.ptr[i].path, strlen(files.ptr[i].path) + 1, 1, out);
+    }
+
+    uint64_t rawTotal = 0;
+    for (uint32_t i = 0; i < files.size; i++) {
+        PackFile_t *pf = &files.ptr[i];
+        // zero padding up to the entry
+        while ((uint64_t) ftell(out) < pf->entry.offset) fputc(0, out);
+
+        const uint8_t *data = (pf->entry.flags & ARCHIVE_ENTRY_COMPRESSED) ? pf->packed : pf->data;
+        fwrite(data, 1, pf->entry.packedSize, out);
+        fputc(0, out);
+
+        rawTotal += pf->size;
+        printf("%-40s %8u -> %8u%s\n", pf->path, pf->size, pf->entry.packedSize, (pf->entry.flags & ARCHIVE_ENTRY_COMPRESSED) ? " lz4" : "");
+    }
+    while ((uint64_t) ftell(out) < offset) fputc(0, out);
+
+    printf("Packed %u files, %llu bytes -> %llu bytes\n", files.size, (unsigned long long) rawTotal, (unsigned long long) offset);
+    fclose(out);
+
+    for (uint32_t i = 0; i < files.size; i++) {
+        free(files.ptr[i].path);
+        free(files.ptr[i].data);
+        free(files.ptr[i].packed);
+    }
+    free(files.ptr);
+    return 0;
+}
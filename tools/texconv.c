@@ -0,0 +1,274 @@
+/**
+ * Converts an image into a DWTX texture, see src/texfile.h for the layout.
+ *
+ * usage: texconv [-f rgba8|bc1|bc3] [-m] <input> <output.dwtx>
+ *   -f  storage format, rgba8 by default. bc1 drops alpha, bc3 keeps it
+ *   -m  only the base level, no mipmaps
+ *
+ * Everything the runtime used to do per launch happens here instead:
+ * decoding, flipping for GL, building the mip chain and block compression.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "../src/texfile.h"
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    // always rgba
+    uint8_t *pixels;
+} MipLevel_t;
+
+static MipLevel_t downsample(const MipLevel_t *src) {
+    MipLevel_t dst;
+    dst.width = src->width > 1 ? src->width / 2 : 1;
+    dst.height = src->height > 1 ? src->height / 2 : 1;
+    dst.pixels = malloc((size_t) dst.width * dst.height * 4);
+    TextureFile_downsample(src->pixels, src->width, src->height, 4, dst.pixels);
+    return dst;
+}
+
+static uint16_t toRgb565(const uint8_t *c) {
+    return (uint16_t) (((c[0] * 31 + 127) / 255) << 11 | ((c[1] * 63 + 127) / 255) << 5 | ((c[2] * 31 + 127) / 255));
+}
+
+static void fromRgb565(uint16_t v, int *c) {
+    c[0] = ((v >> 11) & 31) * 255 / 31;
+    c[1] = ((v >> 5) & 63) * 255 / 63;
+    c[2] = (v & 31) * 255 / 31;
+}
+
+// bounding box endpoints, then every texel snaps to the closest of the 4 palette colours
+static void encodeColorBlock(const uint8_t block[16][4], uint8_t *out) {
+    uint8_t lo[3] = { 255, 255, 255 };
+    uint8_t hi[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            if (block[i][c] < lo[c]) lo[c] = block[i][c];
+            if (block[i][c] > hi[c]) hi[c] = block[i][c];
+        }
+    }
+
+    // pull the endpoints in a little, the extremes are usually outliers
+    for (int c = 0; c < 3; c++) {
+        int inset = (hi[c] - lo[c]) / 16;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    uint16_t c0 = toRgb565(hi);
+    uint16_t c1 = toRgb565(lo);
+    // c0 > c1 picks the 4 colour mode, equal endpoints just use index 0 everywhere
+    if (c0 < c1) {
+        uint16_t t = c0;
+        c0 = c1;
+        c1 = t;
+    }
+
+    int palette[4][3];
+    fromRgb565(c0, palette[0]);
+    fromRgb565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestDist = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int dr = block[i][0] - palette[p][0];
+                int dg = block[i][1] - palette[p][1];
+                int db = block[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t) best << (i * 2);
+        }
+    }
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    memcpy(out + 4, &indices, 4);
+}
+
+// 8 interpolated alpha values between the block's min and max
+static void encodeAlphaBlock(const uint8_t block[16][4], uint8_t *out) {
+    uint8_t lo = 255;
+    uint8_t hi = 0;
+    for (int i = 0; i < 16; i++) {
+        if (block[i][3] < lo) lo = block[i][3];
+        if (block[i][3] > hi) hi = block[i][3];
+    }
+
+    int palette[8] = { hi, lo };
+    for (int i = 1; i < 7; i++) {
+        palette[i + 1] = ((7 - i) * hi + i * lo) / 7;
+    }
+
+    uint64_t indices = 0;
+    if (hi != lo) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            int bestDist = 1 << 30;
+            for (int p = 0; p < 8; p++) {
+                int dist = abs(block[i][3] - palette[p]);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t) best << (i * 3);
+        }
+    }
+
+    out[0] = hi;
+    out[1] = lo;
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (uint8_t) (indices >> (i * 8));
+    }
+}
+
+static uint8_t* compressLevel(const MipLevel_t *level, TextureFormat_e format, size_t *size) {
+    *size = TextureFormat_levelSize(format, level->width, level->height);
+    uint8_t *out = malloc(*size);
+    uint8_t *op = out;
+
+    for (uint32_t by = 0; by < level->height; by += 4) {
+        for (uint32_t bx = 0; bx < level->width; bx += 4) {
+            // edge blocks repeat the last row/column, those texels never get sampled
+            uint8_t block[16][4];
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = by + y < level->height ? by + y : level->height - 1;
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = bx + x < level->width ? bx + x : level->width - 1;
+                    memcpy(block[y * 4 + x], level->pixels + ((size_t) sy * level->width + sx) * 4, 4);
+                }
+            }
+
+            if (format == TEXTURE_FORMAT_BC3) {
+                encodeAlphaBlock(block, op);
+                op += 8;
+            }
+            encodeColorBlock(block, op);
+            op += 8;
+        }
+    }
+
+    return out;
+}
+
+static uint32_t alignUp(uint32_t value) {
+    return (value + TEXTURE_FILE_ALIGNMENT - 1) & ~(uint32_t) (TEXTURE_FILE_ALIGNMENT - 1);
+}
+
+int main(int argc, char **argv) {
+    TextureFormat_e format = TEXTURE_FORMAT_RGBA8;
+    bool mipmaps = true;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-m") == 0) {
+            mipmaps = false;
+        } else if (strcmp(argv[arg], "-f") == 0 && arg + 1 < argc) {
+            const char *name = argv[++arg];
+            if (strcmp(name, "rgba8") == 0) format = TEXTURE_FORMAT_RGBA8;
+            else if (strcmp(name, "bc1") == 0) format = TEXTURE_FORMAT_BC1;
+            else if (strcmp(name, "bc3") == 0) format = TEXTURE_FORMAT_BC3;
+            else {
+                fprintf(stderr, "Error: Unknown format %s\n", name);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[arg]);
+            return 1;
+        }
+    }
+
+    if (argc - arg != 2) {
+        fprintf(stderr, "usage: texconv [-f rgba8|bc1|bc3] [-m] <input> <output.dwtx>\n");
+        return 1;
+    }
+
+    const char *inPath = argv[arg];
+    const char *outPath = argv[arg + 1];
+
+    // GL wants the bottom row first, so it's flipped here once instead of every launch
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    uint8_t *pixels = stbi_load(inPath, &width, &height, &channels, 4);
+    if (pixels == NULL) {
+        fprintf(stderr, "Error: Couldn't decode %s: %s\n", inPath, stbi_failure_reason());
+        return 1;
+    }
+
+    MipLevel_t levels[TEXTURE_FILE_MAX_LEVELS];
+    uint32_t levelCount = 1;
+    levels[0] = (MipLevel_t) { width, height, pixels };
+    while (mipmaps && levelCount < TEXTURE_FILE_MAX_LEVELS && (levels[levelCount - 1].width > 1 || levels[levelCount - 1].height > 1)) {
+        levels[levelCount] = downsample(&levels[levelCount - 1]);
+        levelCount++;
+    }
+
+    TextureFileHeader_t header = {
+        .version = TEXTURE_FILE_VERSION,
+        .format = format,
+        .width = width,
+        .height = height,
+        .levels = levelCount
+    };
+    memcpy(header.magic, TEXTURE_FILE_MAGIC, 4);
+
+    TextureFileLevel_t table[TEXTURE_FILE_MAX_LEVELS];
+    uint8_t *data[TEXTURE_FILE_MAX_LEVELS];
+    uint32_t offset = alignUp(sizeof(TextureFileHeader_t) + levelCount * sizeof(TextureFileLevel_t));
+
+    for (uint32_t i = 0; i < levelCount; i++) {
+        size_t size;
+        if (format == TEXTURE_FORMAT_RGBA8) {
+            size = TextureFormat_levelSize(format, levels[i].width, levels[i].height);
+            data[i] = levels[i].pixels;
+        } else {
+            data[i] = compressLevel(&levels[i], format, &size);
+        }
+
+        table[i] = (TextureFileLevel_t) { offset, (uint32_t) size, levels[i].width, levels[i].height };
+        offset = alignUp(offset + size);
+    }
+
+    FILE *out = fopen(outPath, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Couldn't open %s for writing\n", outPath);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(table, sizeof(TextureFileLevel_t), levelCount, out);
+    for (uint32_t i = 0; i < levelCount; i++) {
+        while ((uint32_t) ftell(out) < table[i].offset) fputc(0, out);
+        fwrite(data[i], 1, table[i].size, out);
+    }
+    fclose(out);
+
+    static const char *formatNames[TEXTURE_FORMAT_TOTAL] = { "rgba8", "bc1", "bc3" };
+    printf("%s: %dx%d %s, %u levels, %u bytes\n", outPath, width, height, formatNames[format], levelCount, offset);
+
+    for (uint32_t i = 0; i < levelCount; i++) {
+        if (data[i] != levels[i].pixels) free(data[i]);
+        if (i == 0) stbi_image_free(levels[i].pixels);
+        else free(levels[i].pixels);
+    }
+    return 0;
+}